@@ -0,0 +1,50 @@
+#ifndef AFINA_BENCH_ZIPF_H
+#define AFINA_BENCH_ZIPF_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+namespace Afina {
+namespace Bench {
+
+/**
+ * Zipfian distribution over [0, n) with the given skew, as in YCSB: most popular key is 0, key i is chosen with
+ * probability proportional to 1 / (i + 1)^theta. Construction is O(n), each sample is O(1)
+ */
+class Zipf {
+public:
+    Zipf(uint64_t n, double theta) : _n(n), _zetan(0) {
+        for (uint64_t i = 1; i <= n; i++) {
+            _zetan += 1.0 / std::pow(double(i), theta);
+        }
+        double zeta2 = 1.0 + 1.0 / std::pow(2.0, theta);
+        _alpha = 1.0 / (1.0 - theta);
+        _eta = (1.0 - std::pow(2.0 / n, 1.0 - theta)) / (1.0 - zeta2 / _zetan);
+        _half_pow_theta = 1.0 + std::pow(0.5, theta);
+    }
+
+    // Maps uniform [0, 1) value to the key
+    uint64_t operator()(double u) const {
+        double uz = u * _zetan;
+        if (uz < 1.0) {
+            return 0;
+        }
+        if (uz < _half_pow_theta) {
+            return 1;
+        }
+        return std::min(_n - 1, uint64_t(_n * std::pow(_eta * u - _eta + 1.0, _alpha)));
+    }
+
+private:
+    uint64_t _n;
+    double _zetan;
+    double _alpha;
+    double _eta;
+    double _half_pow_theta;
+};
+
+} // namespace Bench
+} // namespace Afina
+
+#endif // AFINA_BENCH_ZIPF_H
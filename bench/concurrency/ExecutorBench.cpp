@@ -0,0 +1,102 @@
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <new>
+#include <thread>
+
+#include <afina/concurrency/Executor.h>
+
+using namespace Afina::Concurrency;
+
+// Every allocation made by the process, including ones in the pool threads
+static std::atomic<uint64_t> allocations(0);
+
+void *operator new(std::size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    void *p = std::malloc(size == 0 ? 1 : size);
+    if (p == nullptr) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void *p) noexcept { std::free(p); }
+
+// Mimics network server handing accepted socket over to the pool
+class Server {
+public:
+    Server() : done(0) {}
+
+    void OnCommand(int socket) { done.fetch_add(1, std::memory_order_relaxed); }
+
+    std::atomic<uint64_t> done;
+};
+
+// Submits tasks by batches so that queue limit is never hit, returns number of allocations
+template <typename F> uint64_t measure(const char *name, uint64_t total, Server &server, F &&submit) {
+    const uint64_t batch = 512;
+
+    uint64_t before = allocations.load();
+    auto start = std::chrono::steady_clock::now();
+    for (uint64_t sent = 0; sent < total; sent += batch) {
+        uint64_t target = server.done.load() + batch;
+        for (uint64_t i = 0; i < batch; i++) {
+            while (!submit(i)) {
+                std::this_thread::yield();
+            }
+        }
+        while (server.done.load() < target) {
+            std::this_thread::yield();
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+    uint64_t allocs = allocations.load() - before;
+
+    double ns = double(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count()) / total;
+    double per_task = double(allocs) / total;
+    std::printf("%-40s %8.1f ns/task %8.3f allocations/task (%lu total)\n", name, ns, per_task,
+                (unsigned long)allocs);
+    return allocs;
+}
+
+int main(int argc, char **argv) {
+    const uint64_t total = 2 * 1000 * 1000;
+
+    // Fixed number of threads, so that measurement doesn't include thread start
+    Executor executor(4, 4, 1024, 60 * 1000);
+    executor.Start();
+
+    Server server;
+
+    // What pool used to do for each task
+    measure("new std::function (previous Task)", total, server, [&](uint64_t i) {
+        std::unique_ptr<std::function<void()>> task(
+            new std::function<void()>(std::bind(&Server::OnCommand, &server, int(i))));
+        (*task)();
+        return true;
+    });
+
+    auto submit_small = [&](uint64_t i) { return executor.Execute(&Server::OnCommand, &server, int(i)); };
+
+    // Closure too large to fit inline
+    std::array<char, 128> payload;
+    payload.fill(0);
+    auto submit_large = [&](uint64_t i) {
+        return executor.Execute([&server](std::array<char, 128> data) { server.OnCommand(data[0]); }, payload);
+    };
+
+    // Warm up pools in all threads
+    measure("warm up", total / 10, server, submit_small);
+    measure("warm up", total / 10, server, submit_large);
+
+    uint64_t small = measure("Execute(&Server::OnCommand, this, fd)", total, server, submit_small);
+    uint64_t large = measure("Execute(128 bytes closure)", total, server, submit_large);
+
+    executor.Stop(true);
+    return (small == 0 && large == 0) ? 0 : 1;
+}
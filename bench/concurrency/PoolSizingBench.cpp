@@ -0,0 +1,206 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <afina/concurrency/Executor.h>
+#include <afina/metrics/Histogram.h>
+
+using namespace Afina;
+using namespace Afina::Concurrency;
+
+using Clock = std::chrono::steady_clock;
+
+/**
+ * Phase of the bursty load: tasks arrive at the given rate for the given time, each task sleeps, like a
+ * handler waiting for slow client, and then burns CPU
+ */
+struct Phase {
+    const char *name;
+    int duration_ms;
+    int rate;
+    int sleep_us;
+    int spin_us;
+};
+
+// Blocking bursts want many threads, CPU bursts gain nothing from threads above number of cores
+const Phase phases[] = {
+    {"quiet", 200, 200, 1000, 0}, {"io", 300, 8000, 2000, 0},   {"quiet", 200, 200, 1000, 0},
+    {"cpu", 200, 4000, 0, 200},   {"quiet", 200, 200, 1000, 0}, {"mixed", 300, 4000, 3000, 20},
+};
+const std::size_t phase_count = sizeof(phases) / sizeof(phases[0]);
+const int cycles = 3;
+
+void spin(int us) {
+    auto until = Clock::now() + std::chrono::microseconds(us);
+    while (Clock::now() < until) {
+    }
+}
+
+struct Result {
+    uint64_t completed;
+    uint64_t rejected;
+    uint64_t p50_us;
+    uint64_t p99_us;
+
+    // p99 of tasks submitted during each phase
+    uint64_t phase_p99_us[phase_count];
+
+    int threads_spawned;
+    double threads_avg;
+};
+
+/**
+ * Runs the whole schedule open loop: task start is scheduled in advance and latency is measured from the
+ * scheduled time, so that slow submission doesn't hide queueing
+ */
+Result run_once(int low, int high) {
+    struct Job {
+        Clock::duration at;
+        std::size_t phase;
+    };
+    std::vector<Job> jobs;
+    Clock::duration offset(0);
+    for (int c = 0; c < cycles; c++) {
+        for (std::size_t k = 0; k < phase_count; k++) {
+            const Phase &p = phases[k];
+            int n = p.rate * p.duration_ms / 1000;
+            for (int i = 0; i < n; i++) {
+                jobs.push_back(Job{offset + std::chrono::microseconds(int64_t(p.duration_ms) * 1000 * i / n), k});
+            }
+            offset += std::chrono::milliseconds(p.duration_ms);
+        }
+    }
+
+    std::unique_ptr<std::atomic<uint64_t>[]> latency(new std::atomic<uint64_t>[jobs.size()]);
+    std::atomic<uint64_t> done(0);
+
+    Executor executor(low, high, 1000000, 1000);
+    executor.Start();
+
+    Result r;
+    std::memset(&r, 0, sizeof(r));
+    Executor::Statistics stats;
+    uint64_t samples = 0, threads = 0;
+    auto start = Clock::now();
+    auto next_sample = start;
+    for (std::size_t i = 0; i < jobs.size(); i++) {
+        auto at = start + jobs[i].at;
+        std::this_thread::sleep_until(at);
+
+        // Pool size over time: thread costs memory and scheduler time even if it is idle
+        if (at >= next_sample) {
+            executor.GetStatistics(stats);
+            threads += stats.threads_live;
+            samples++;
+            next_sample += std::chrono::milliseconds(10);
+        }
+
+        const Phase *phase = &phases[jobs[i].phase];
+        std::atomic<uint64_t> *slot = &latency[i];
+        slot->store(0);
+        bool ok = executor.Execute([at, phase, slot, &done] {
+            if (phase->sleep_us > 0) {
+                std::this_thread::sleep_for(std::chrono::microseconds(phase->sleep_us));
+            }
+            spin(phase->spin_us);
+            slot->store(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - at).count());
+            done++;
+        });
+        if (!ok) {
+            r.rejected++;
+        }
+    }
+
+    while (done.load() + r.rejected < jobs.size()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    executor.GetStatistics(stats);
+    executor.Stop(true);
+
+    Metrics::Histogram h, per_phase[phase_count];
+    for (std::size_t i = 0; i < jobs.size(); i++) {
+        if (latency[i].load() > 0) {
+            h.Record(latency[i].load());
+            per_phase[jobs[i].phase].Record(latency[i].load());
+        }
+    }
+
+    r.completed = h.Count();
+    r.p50_us = h.Percentile(50) / 1000;
+    r.p99_us = h.Percentile(99) / 1000;
+    for (std::size_t k = 0; k < phase_count; k++) {
+        r.phase_p99_us[k] = per_phase[k].Percentile(99) / 1000;
+    }
+    r.threads_spawned = int(stats.threads_spawned);
+    r.threads_avg = double(threads) / samples;
+    return r;
+}
+
+/**
+ * Timing of sleeping threads is noisy, so each configuration runs several times and the run with the median
+ * p99 is reported
+ */
+Result run(int low, int high) {
+    const int repeats = 3;
+
+    std::vector<Result> results;
+    for (int i = 0; i < repeats; i++) {
+        results.push_back(run_once(low, high));
+    }
+    std::sort(results.begin(), results.end(), [](const Result &a, const Result &b) { return a.p99_us < b.p99_us; });
+    return results[repeats / 2];
+}
+
+void print_header() {
+    std::printf("%-16s %9s %9s %9s", "pool", "tasks", "p50_us", "p99_us");
+    for (auto &p : phases) {
+        if (std::strcmp(p.name, "quiet") != 0) {
+            std::printf(" %9s", (std::string(p.name) + "_p99").c_str());
+        }
+    }
+    std::printf(" %9s %9s\n", "spawned", "threads");
+}
+
+void print(const std::string &name, const Result &r) {
+    std::printf("%-16s %9lu %9lu %9lu", name.c_str(), (unsigned long)r.completed, (unsigned long)r.p50_us,
+                (unsigned long)r.p99_us);
+    for (std::size_t k = 0; k < phase_count; k++) {
+        if (std::strcmp(phases[k].name, "quiet") != 0) {
+            std::printf(" %9lu", (unsigned long)r.phase_p99_us[k]);
+        }
+    }
+    std::printf(" %9d %9.1f\n", r.threads_spawned, r.threads_avg);
+}
+
+int main(int argc, char **argv) {
+    const int max_threads = 64;
+
+    std::printf("cores: %u\n", std::thread::hardware_concurrency());
+    print_header();
+
+    // Smaller pools can't keep up with the io bursts at all
+    uint64_t best_fixed_p99 = UINT64_MAX;
+    for (int threads = 8; threads <= max_threads; threads *= 2) {
+        Result r = run(threads, threads);
+        print("fixed " + std::to_string(threads), r);
+        if (r.p99_us < best_fixed_p99) {
+            best_fixed_p99 = r.p99_us;
+        }
+    }
+
+    // Elastic pool as it is used by the server: grows whenever there is no free thread
+    Result elastic = run(2, max_threads);
+    print("elastic 2-" + std::to_string(max_threads), elastic);
+
+    std::printf("\nelastic p99 %luus, best fixed p99 %luus\n", (unsigned long)elastic.p99_us,
+                (unsigned long)best_fixed_p99);
+    return 0;
+}
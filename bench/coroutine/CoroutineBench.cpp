@@ -0,0 +1,74 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#include <afina/coroutine/Engine.h>
+
+using namespace Afina::Coroutine;
+
+// Shared state of two routines passing control to each other
+struct PingPong {
+    Engine *engine;
+    void *peer[2];
+    uint64_t rounds;
+    std::size_t depth;
+};
+
+// Switches from the frame that has depth bytes of stack above it, as a handler deep in the call chain would
+void play(PingPong &game, int side, std::size_t depth) {
+    if (depth >= 1024) {
+        volatile char frame[1024];
+        frame[0] = 0;
+        play(game, side, depth - 1024);
+        frame[0]++;
+        return;
+    }
+
+    for (uint64_t i = 0; i < game.rounds; i++) {
+        game.engine->sched(game.peer[1 - side]);
+    }
+}
+
+void player(PingPong &game, int side) { play(game, side, game.depth); }
+
+void table(PingPong &game) {
+    game.peer[0] = game.engine->run(player, game, 0);
+    game.peer[1] = game.engine->run(player, game, 1);
+    game.engine->sched(game.peer[0]);
+}
+
+// Returns number of switches per second
+double measure(Engine::StackMode mode, std::size_t depth, uint64_t rounds) {
+    Engine engine(mode);
+    PingPong game;
+    game.engine = &engine;
+    game.rounds = rounds;
+    game.depth = depth;
+
+    auto start = std::chrono::steady_clock::now();
+    engine.start(table, game);
+    auto end = std::chrono::steady_clock::now();
+
+    double seconds = std::chrono::duration<double>(end - start).count();
+    return 2.0 * rounds / seconds;
+}
+
+int main(int argc, char **argv) {
+    const uint64_t rounds = 1000 * 1000;
+    const std::size_t depths[] = {0, 1024, 4096, 16384};
+
+    std::printf("%-10s %10s %14s %12s\n", "mode", "depth", "switches/s", "ns/switch");
+    for (std::size_t depth : depths) {
+        const struct {
+            const char *name;
+            Engine::StackMode mode;
+        } modes[] = {{"copy", Engine::StackMode::kCopy}, {"separate", Engine::StackMode::kSeparate}};
+
+        for (auto &m : modes) {
+            double rate = measure(m.mode, depth, rounds);
+            std::printf("%-10s %10lu %14.0f %12.1f\n", m.name, (unsigned long)depth, rate, 1e9 / rate);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,559 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cxxopts.hpp>
+
+#include <afina/metrics/Histogram.h>
+
+#include "common/Zipf.h"
+
+using namespace Afina;
+using Afina::Bench::Zipf;
+
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+struct Config {
+    std::string host;
+    uint16_t port;
+    int connections;
+    int threads;
+    std::size_t depth;
+    uint64_t keys;
+    double theta;
+    std::size_t value_min;
+    std::size_t value_max;
+    double set_ratio;
+    double rate;
+    double warmup;
+    double duration;
+    bool preload;
+    uint64_t seed;
+    std::string label;
+};
+
+// Request in flight: when it was due to be sent and when it was actually sent
+struct Request {
+    Clock::time_point intended;
+    Clock::time_point sent;
+};
+
+struct Connection {
+    int socket;
+    std::deque<Request> inflight;
+
+    // Bytes to be sent, socket hasn't taken them yet
+    std::string output;
+    std::size_t output_sent;
+
+    // Response bytes which aren't parsed yet and number of data bytes of the VALUE being skipped
+    std::string input;
+    std::size_t skip;
+    bool hit;
+
+    // Open loop: when the next request is due
+    Clock::time_point next_due;
+};
+
+// What a client thread has seen
+struct Stats {
+    uint64_t gets = 0;
+    uint64_t sets = 0;
+    uint64_t hits = 0;
+    uint64_t errors = 0;
+
+    // Requests which were due, but haven't been sent by the end since connection window was full
+    uint64_t backlog = 0;
+
+    // Response time from the actual send and corrected for coordinated omission
+    Metrics::Histogram raw;
+    Metrics::Histogram corrected;
+};
+
+int Connect(const Config &config) {
+    struct addrinfo hints, *addrs = nullptr;
+    std::memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    if (getaddrinfo(config.host.c_str(), std::to_string(config.port).c_str(), &hints, &addrs) != 0) {
+        throw std::runtime_error("Failed to resolve " + config.host);
+    }
+
+    // Server could be still starting
+    int s = -1;
+    for (int attempt = 0; s == -1; attempt++) {
+        s = socket(AF_INET, SOCK_STREAM, 0);
+        if (connect(s, addrs->ai_addr, addrs->ai_addrlen) == 0) {
+            break;
+        }
+        close(s);
+        s = -1;
+        if (attempt == 500) {
+            freeaddrinfo(addrs);
+            throw std::runtime_error("connect() failed: " + std::string(strerror(errno)));
+        }
+        usleep(10000);
+    }
+    freeaddrinfo(addrs);
+
+    int one = 1;
+    setsockopt(s, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    return s;
+}
+
+// Sends all the data, socket is blocking
+void SendAll(int s, const std::string &data) {
+    for (std::size_t sent = 0; sent < data.size();) {
+        ssize_t n = send(s, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0) {
+            throw std::runtime_error("send() failed: " + std::string(strerror(errno)));
+        }
+        sent += n;
+    }
+}
+
+// Reads from the blocking socket until the given number of lines is received, input keeps what follows them
+void ReceiveLines(int s, std::size_t count, std::string &input) {
+    char buf[16384];
+    std::size_t pos = 0;
+    while (count > 0) {
+        std::size_t eol = input.find("\r\n", pos);
+        if (eol != std::string::npos) {
+            count--;
+            pos = eol + 2;
+            continue;
+        }
+
+        ssize_t n = recv(s, buf, sizeof(buf), 0);
+        if (n <= 0) {
+            throw std::runtime_error("Server closed connection");
+        }
+        input.append(buf, n);
+    }
+    input.erase(0, pos);
+}
+
+// Appends random request to the output, returns true if it is set
+bool AddRequest(const Config &config, const Zipf *zipf, std::mt19937_64 &rnd, Connection &c) {
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    uint64_t key = (zipf != nullptr) ? (*zipf)(uniform(rnd)) : rnd() % config.keys;
+
+    char header[128];
+    if (uniform(rnd) < config.set_ratio) {
+        std::size_t size = config.value_min + rnd() % (config.value_max - config.value_min + 1);
+        int n = std::snprintf(header, sizeof(header), "set key%llu 0 0 %zu\r\n", (unsigned long long)key, size);
+        c.output.append(header, n);
+        c.output.append(size, 'x');
+        c.output.append("\r\n");
+        return true;
+    }
+
+    int n = std::snprintf(header, sizeof(header), "get key%llu\r\n", (unsigned long long)key);
+    c.output.append(header, n);
+    return false;
+}
+
+// Sends as much of the output as socket takes
+void Flush(Connection &c) {
+    while (c.output_sent < c.output.size()) {
+        ssize_t n = send(c.socket, c.output.data() + c.output_sent, c.output.size() - c.output_sent,
+                         MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (n < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                break;
+            }
+            throw std::runtime_error("send() failed: " + std::string(strerror(errno)));
+        }
+        c.output_sent += n;
+    }
+    if (c.output_sent == c.output.size()) {
+        c.output.clear();
+        c.output_sent = 0;
+    }
+}
+
+// Takes complete responses from the input, each is either a single line or VALUE blocks followed by END
+void TakeResponses(Connection &c, Stats &stats, bool measure, bool open_loop, uint64_t expected_interval,
+                   Clock::time_point now) {
+    std::size_t pos = 0;
+    while (true) {
+        if (c.skip > 0) {
+            std::size_t take = std::min(c.skip, c.input.size() - pos);
+            pos += take;
+            c.skip -= take;
+            if (c.skip > 0) {
+                break;
+            }
+            continue;
+        }
+
+        std::size_t eol = c.input.find("\r\n", pos);
+        if (eol == std::string::npos) {
+            break;
+        }
+        const char *line = c.input.data() + pos;
+        std::size_t size = eol - pos;
+        pos = eol + 2;
+
+        if (size > 6 && std::strncmp(line, "VALUE ", 6) == 0) {
+            // Data block size is the last field
+            const char *last = line + size;
+            while (last > line && last[-1] != ' ') {
+                last--;
+            }
+            c.skip = std::strtoull(last, nullptr, 10) + 2;
+            c.hit = true;
+            continue;
+        }
+
+        if (c.inflight.empty()) {
+            throw std::runtime_error("Unexpected response: " + std::string(line, size));
+        }
+        bool get = (size == 3 && std::strncmp(line, "END", 3) == 0);
+        bool set = (size == 6 && std::strncmp(line, "STORED", 6) == 0) ||
+                   (size == 10 && std::strncmp(line, "NOT_STORED", 10) == 0);
+
+        Request r = c.inflight.front();
+        c.inflight.pop_front();
+        if (measure) {
+            stats.gets += get;
+            stats.sets += set;
+            stats.hits += (get && c.hit);
+            stats.errors += (!get && !set);
+
+            uint64_t raw = std::chrono::duration_cast<std::chrono::nanoseconds>(now - r.sent).count();
+            uint64_t intended = std::chrono::duration_cast<std::chrono::nanoseconds>(now - r.intended).count();
+            stats.raw.Record(raw);
+            if (open_loop) {
+                // Latency is counted from the time request was due, even if it was sent right on time
+                stats.corrected.Record(intended);
+            } else {
+                stats.corrected.RecordCorrected(raw, expected_interval);
+            }
+        }
+        c.hit = false;
+    }
+    c.input.erase(0, pos);
+}
+
+// Drives given connections until the end of measurement
+void RunClient(const Config &config, const Zipf *zipf, std::vector<Connection> &connections, int first,
+               Clock::time_point start, Clock::time_point measure_from, Clock::time_point until, Stats &stats) {
+    std::mt19937_64 rnd(config.seed + first);
+    bool open_loop = config.rate > 0;
+    auto interval = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(
+        open_loop ? config.connections / config.rate : 0.0));
+
+    int epoll_fd = epoll_create1(0);
+    for (std::size_t i = 0; i < connections.size(); i++) {
+        Connection &c = connections[i];
+        fcntl(c.socket, F_SETFL, O_NONBLOCK);
+        struct epoll_event ev;
+        ev.events = EPOLLIN | EPOLLOUT | EPOLLET;
+        ev.data.ptr = &c;
+        epoll_ctl(epoll_fd, EPOLL_CTL_ADD, c.socket, &ev);
+
+        // Arrivals of different connections are spread evenly
+        c.next_due = start + interval * (first + i) / config.connections;
+    }
+
+    // Closed loop has no schedule, expected interval between requests is taken from the warm up
+    Metrics::Histogram warmup;
+    uint64_t expected_interval = 0;
+    bool measure = false;
+
+    char buf[65536];
+    struct epoll_event events[64];
+    while (true) {
+        auto now = Clock::now();
+        if (now >= until) {
+            break;
+        }
+        if (!measure && now >= measure_from) {
+            measure = true;
+            expected_interval = uint64_t(stats.raw.Mean());
+            stats.raw.Reset();
+            stats.corrected.Reset();
+            stats.gets = stats.sets = stats.hits = stats.errors = 0;
+        }
+
+        // Issue requests: closed loop keeps the window full, open loop sends those which are due
+        auto wake = until;
+        for (auto &c : connections) {
+            while (c.inflight.size() < config.depth) {
+                Request r;
+                r.sent = now;
+                if (open_loop) {
+                    if (c.next_due > now) {
+                        break;
+                    }
+                    r.intended = c.next_due;
+                    c.next_due += interval;
+                } else {
+                    r.intended = now;
+                }
+                AddRequest(config, zipf, rnd, c);
+                c.inflight.push_back(r);
+            }
+            if (open_loop && c.inflight.size() < config.depth) {
+                wake = std::min(wake, c.next_due);
+            }
+            Flush(c);
+        }
+
+        // Millisecond precision of epoll_wait is too coarse for the schedule, so the last millisecond is spun
+        int timeout = 100;
+        if (open_loop) {
+            auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(wake - Clock::now()).count();
+            timeout = std::max<int>(0, std::min<int>(ms - 1, 100));
+        }
+
+        int n = epoll_wait(epoll_fd, events, 64, timeout);
+        now = Clock::now();
+        for (int i = 0; i < n; i++) {
+            Connection &c = *static_cast<Connection *>(events[i].data.ptr);
+            ssize_t got;
+            while ((got = recv(c.socket, buf, sizeof(buf), 0)) > 0) {
+                c.input.append(buf, got);
+            }
+            if (got == 0) {
+                throw std::runtime_error("Server closed connection");
+            } else if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                throw std::runtime_error("recv() failed: " + std::string(strerror(errno)));
+            }
+            TakeResponses(c, stats, measure, open_loop, expected_interval, now);
+        }
+    }
+
+    if (open_loop) {
+        auto now = Clock::now();
+        for (auto &c : connections) {
+            while (c.next_due <= now) {
+                stats.backlog++;
+                c.next_due += interval;
+            }
+        }
+    }
+    close(epoll_fd);
+}
+
+void Print(const char *name, const Metrics::Histogram &h) {
+    std::printf("%-12s %9.1f %9.1f %9.1f %9.1f %9.1f\n", name, h.Percentile(50) / 1000.0, h.Percentile(90) / 1000.0,
+                h.Percentile(99) / 1000.0, h.Percentile(99.9) / 1000.0, h.Max() / 1000.0);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    cxxopts::Options options("bench_load", "Load generator for afina and other memcached servers");
+    Config config;
+    try {
+        // clang-format off
+        options.add_options()
+            ("host", "Server address", cxxopts::value<std::string>()->default_value("127.0.0.1"))
+            ("p,port", "Server port", cxxopts::value<int>()->default_value("8080"))
+            ("c,connections", "Number of connections", cxxopts::value<int>()->default_value("16"))
+            ("t,threads", "Number of client threads, connections are split between them", cxxopts::value<int>()->default_value("1"))
+            ("d,depth", "Requests in flight per connection", cxxopts::value<int>()->default_value("1"))
+            ("k,keys", "Number of keys", cxxopts::value<uint64_t>()->default_value("10000"))
+            ("zipf", "Zipfian skew of the keys popularity, 0 means uniform", cxxopts::value<double>()->default_value("0.99"))
+            ("value-size", "Value size of sets, either N or MIN:MAX", cxxopts::value<std::string>()->default_value("32"))
+            ("set-ratio", "Share of sets among requests", cxxopts::value<double>()->default_value("0.1"))
+            ("r,rate", "Open loop: requests per second in total, each sent at its time whatever responses are. "
+                       "Closed loop if 0: connection sends next request once response arrives",
+             cxxopts::value<double>()->default_value("0"))
+            ("warmup", "Seconds of load before measurement", cxxopts::value<double>()->default_value("1"))
+            ("duration", "Seconds of measurement", cxxopts::value<double>()->default_value("5"))
+            ("no-preload", "Don't store every key before the run")
+            ("seed", "Random seed", cxxopts::value<uint64_t>()->default_value("1"))
+            ("label", "Print single row of results with the given label", cxxopts::value<std::string>()->default_value(""))
+            ("h,help", "Print usage info");
+        // clang-format on
+        options.parse(argc, argv);
+        if (options.count("help") > 0) {
+            std::cerr << options.help() << std::endl;
+            return 0;
+        }
+
+        config.host = options["host"].as<std::string>();
+        config.port = options["port"].as<int>();
+        config.connections = options["connections"].as<int>();
+        config.threads = std::max(1, std::min(options["threads"].as<int>(), config.connections));
+        config.depth = std::max(1, options["depth"].as<int>());
+        config.keys = std::max<uint64_t>(2, options["keys"].as<uint64_t>());
+        config.theta = options["zipf"].as<double>();
+        config.set_ratio = options["set-ratio"].as<double>();
+        config.rate = options["rate"].as<double>();
+        config.warmup = options["warmup"].as<double>();
+        config.duration = options["duration"].as<double>();
+        config.preload = options.count("no-preload") == 0;
+        config.seed = options["seed"].as<uint64_t>();
+        config.label = options["label"].as<std::string>();
+
+        std::string sizes = options["value-size"].as<std::string>();
+        std::size_t colon = sizes.find(':');
+        config.value_min = std::stoul(sizes.substr(0, colon));
+        config.value_max = (colon == std::string::npos) ? config.value_min : std::stoul(sizes.substr(colon + 1));
+        if (config.connections < 1 || config.value_max < config.value_min || config.theta < 0 || config.theta == 1) {
+            throw std::runtime_error("Invalid options");
+        }
+    } catch (std::exception &ex) {
+        std::cerr << "Error: " << ex.what() << std::endl;
+        return 1;
+    }
+
+    try {
+        std::unique_ptr<Zipf> zipf;
+        if (config.theta > 0) {
+            zipf.reset(new Zipf(config.keys, config.theta));
+        }
+
+        // Store every key, so that gets hit unless server has evicted them. Requests are sent while responses are
+        // read: client that waits for a batch of responses before sending more stalls on delayed acks
+        if (config.preload) {
+            int s = Connect(config);
+            std::thread sender([&config, s]() {
+                const uint64_t batch = 128;
+                try {
+                    for (uint64_t first = 0; first < config.keys; first += batch) {
+                        std::string requests;
+                        for (uint64_t key = first; key < std::min(config.keys, first + batch); key++) {
+                            requests += "set key" + std::to_string(key) + " 0 0 " +
+                                        std::to_string(config.value_min) + "\r\n";
+                            requests.append(config.value_min, 'x');
+                            requests += "\r\n";
+                        }
+                        SendAll(s, requests);
+                    }
+                } catch (std::runtime_error &) {
+                    // Receiver finds connection broken as well
+                }
+            });
+
+            std::string input;
+            try {
+                ReceiveLines(s, config.keys, input);
+            } catch (std::runtime_error &) {
+                shutdown(s, SHUT_RDWR);
+                sender.join();
+                throw;
+            }
+            sender.join();
+            close(s);
+        }
+
+        // Connections are opened one by one and each makes a request, so that blocking server has taken them all
+        std::vector<std::vector<Connection>> groups(config.threads);
+        for (int i = 0; i < config.connections; i++) {
+            Connection c;
+            c.socket = Connect(config);
+            c.output_sent = 0;
+            c.skip = 0;
+            c.hit = false;
+            SendAll(c.socket, "set key0 0 0 1\r\nx\r\n");
+            ReceiveLines(c.socket, 1, c.input);
+            groups[i % config.threads].push_back(std::move(c));
+        }
+
+        auto seconds = [](double s) {
+            return std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(s));
+        };
+        auto start = Clock::now() + std::chrono::milliseconds(10);
+        auto measure_from = start + seconds(config.warmup);
+        auto until = measure_from + seconds(config.duration);
+
+        std::vector<std::unique_ptr<Stats>> stats;
+        std::vector<std::thread> threads;
+        std::vector<std::string> errors(config.threads);
+        for (int t = 0, first = 0; t < config.threads; first += groups[t].size(), t++) {
+            stats.emplace_back(new Stats());
+            threads.emplace_back([&, t, first]() {
+                try {
+                    RunClient(config, zipf.get(), groups[t], first, start, measure_from, until, *stats[t]);
+                } catch (std::runtime_error &ex) {
+                    errors[t] = ex.what();
+                }
+            });
+        }
+        for (auto &t : threads) {
+            t.join();
+        }
+        for (auto &group : groups) {
+            for (auto &c : group) {
+                close(c.socket);
+            }
+        }
+        for (auto &error : errors) {
+            if (!error.empty()) {
+                throw std::runtime_error(error);
+            }
+        }
+
+        Stats total;
+        for (auto &s : stats) {
+            total.gets += s->gets;
+            total.sets += s->sets;
+            total.hits += s->hits;
+            total.errors += s->errors;
+            total.backlog += s->backlog;
+            total.raw.Merge(s->raw);
+            total.corrected.Merge(s->corrected);
+        }
+        double ops = (total.gets + total.sets + total.errors) / config.duration;
+
+        if (!config.label.empty()) {
+            std::printf("%-26s %10.0f %9.1f %9.1f %9.1f %9.1f %8.3f %6llu\n", config.label.c_str(), ops,
+                        total.corrected.Percentile(50) / 1000.0, total.corrected.Percentile(99) / 1000.0,
+                        total.corrected.Percentile(99.9) / 1000.0, total.corrected.Max() / 1000.0,
+                        total.gets ? double(total.hits) / total.gets : 0.0, (unsigned long long)total.errors);
+            return 0;
+        }
+
+        std::printf("%s loop, %d connections in %d threads, depth %zu, ", config.rate > 0 ? "open" : "closed",
+                    config.connections, config.threads, config.depth);
+        if (zipf) {
+            std::printf("zipf %.2f", config.theta);
+        } else {
+            std::printf("uniform");
+        }
+        std::printf(" over %llu keys, %.0f%% sets of %zu..%zu bytes\n", (unsigned long long)config.keys,
+                    config.set_ratio * 100, config.value_min, config.value_max);
+        if (config.rate > 0) {
+            std::printf("target %.0f ops/s, ", config.rate);
+        }
+        std::printf("done %.0f ops/s: %llu gets, %llu sets, hit ratio %.3f, %llu errors", ops,
+                    (unsigned long long)total.gets, (unsigned long long)total.sets,
+                    total.gets ? double(total.hits) / total.gets : 0.0, (unsigned long long)total.errors);
+        if (config.rate > 0) {
+            std::printf(", %llu requests left unsent", (unsigned long long)total.backlog);
+        }
+        std::printf("\n\n%-12s %9s %9s %9s %9s %9s\n", "latency, us", "p50", "p90", "p99", "p99.9", "max");
+        Print("raw", total.raw);
+        Print("corrected", total.corrected);
+    } catch (std::runtime_error &ex) {
+        std::cerr << "Error: " << ex.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,48 @@
+#!/bin/bash
+
+# Runs bench_load against afina started with every --network/--storage combination in turn and prints
+# throughput and latency percentiles corrected for coordinated omission, one row per combination.
+#
+# Usage: bench/load/run_all.sh <build dir> [bench_load options...], for example
+#   bench/load/run_all.sh build -d 16 --duration 10
+#   bench/load/run_all.sh build --rate 50000
+#   PORT=11211 bench/load/run_all.sh build
+#
+# st_* storages aren't thread safe, so they are only paired with networks that touch storage from a single thread.
+# st_block serves one connection at a time, so it gets a single connection whatever options say.
+
+set -e
+
+BUILD=${1:?build directory is expected}
+shift
+
+PORT=${PORT:-8080}
+AFINA="$BUILD/src/afina"
+LOAD="$BUILD/bench/load/bench_load"
+
+printf "%-26s %10s %9s %9s %9s %9s %8s %6s\n" "network/storage" "ops/s" "p50, us" "p99, us" "p99.9, us" "max, us" \
+    "hits" "errors"
+
+for storage in st_lru mt_lru st_slru mt_slru st_arc mt_arc mt_clock; do
+    for network in st_block mt_block st_nonblock mt_nonblock st_coroutine mt_coroutine uring; do
+        case "$network/$storage" in
+            mt_block/st_* | mt_nonblock/st_* | mt_coroutine/st_* | uring/st_*)
+                continue
+                ;;
+        esac
+
+        connections=()
+        case "$network" in
+            st_block) connections=(-c 1 -t 1) ;;
+        esac
+
+        "$AFINA" -n "$network" -s "$storage" -p "$PORT" > /dev/null 2>&1 &
+        pid=$!
+
+        # bench_load waits for the port to be bound
+        "$LOAD" --label "$network/$storage" -p "$PORT" "$@" "${connections[@]}" || true
+
+        kill -INT $pid
+        wait $pid || true
+    done
+done
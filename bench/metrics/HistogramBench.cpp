@@ -0,0 +1,68 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#include <afina/metrics/Histogram.h>
+#include <afina/metrics/Latency.h>
+
+using namespace Afina::Metrics;
+
+// Budget for the latency recording on the request path
+const double budget_ns = 20.0;
+
+// Measures average cost of the given function in nanoseconds
+template <typename F> double measure(const char *name, uint64_t iterations, F &&func) {
+    auto start = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < iterations; i++) {
+        func(i);
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    double ns = double(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count()) / iterations;
+    std::printf("%-40s %8.2f ns/op\n", name, ns);
+    return ns;
+}
+
+int main(int argc, char **argv) {
+    const uint64_t iterations = 50 * 1000 * 1000;
+
+    // Latency like values: mostly few microseconds, sometimes much longer
+    std::vector<uint64_t> values(4096);
+    uint64_t seed = 42;
+    for (auto &v : values) {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        v = 1000 + (seed >> 40) % 20000;
+        if ((seed & 0xff) == 0) {
+            v *= 1000;
+        }
+    }
+    const std::size_t mask = values.size() - 1;
+
+    // Empty loop, to see what loop itself costs
+    volatile uint64_t sink = 0;
+    double loop = measure("loop overhead", iterations, [&](uint64_t i) { sink = values[i & mask]; });
+
+    Histogram h;
+    measure("Histogram::Record", iterations, [&](uint64_t i) { h.Record(values[i & mask]); });
+
+    double now = measure("Clock::Now", iterations, [&](uint64_t i) { sink = Clock::Now(); });
+
+    // What server does for each request: thread local lookup, ticks conversion and record
+    double latency = measure("RecordLatency", iterations, [&](uint64_t i) {
+        RecordLatency(kOpGet, 0, values[i & mask]);
+    });
+
+    // Server takes one timestamp per read batch, shared by pipelined commands, and one per response
+    double per_request = measure("Clock::Now + RecordLatency", iterations, [&](uint64_t i) {
+        uint64_t start = Clock::Now();
+        RecordLatency(kOpSet, start, start + values[i & mask]);
+    });
+
+    std::printf("\nrecorded %lu values, p50=%luns p99=%luns max=%luns\n", (unsigned long)h.Count(),
+                (unsigned long)h.Percentile(50), (unsigned long)h.Percentile(99), (unsigned long)h.Max());
+    std::printf("recording cost: %.2f ns/request (budget %.0f ns), timestamp: %.2f ns, total per request: %.2f ns\n",
+                latency - loop, budget_ns, now - loop, per_request - loop);
+
+    return (latency - loop) < budget_ns ? 0 : 1;
+}
@@ -0,0 +1,23 @@
+#include <cstdio>
+#include <cstdlib>
+
+#include "Harness.h"
+
+int main(int argc, char **argv) {
+    const int idle = 10000, hot = argc > 1 ? std::atoi(argv[1]) : 100, seconds = 3;
+    const char *types[] = {"st_nonblock", "st_coroutine"};
+
+    // Client and server live in different processes, each needs descriptors for all connections
+    std::printf("%-14s %8s %6s %10s %8s %8s %8s %10s\n", "server", "idle", "hot", "ops/s", "p50_us", "p99_us",
+                "max_us", "rss_mb");
+    uint16_t port = 18080;
+    for (int idle_count : {0, idle}) {
+        for (const char *type : types) {
+            Result r = run(type, port++, 1, idle_count, hot, seconds);
+            std::printf("%-14s %8d %6d %10.0f %8lu %8lu %8lu %10.1f\n", type, idle_count, hot, r.ops,
+                        (unsigned long)r.p50_us, (unsigned long)r.p99_us, (unsigned long)r.max_us,
+                        r.rss_idle_kb / 1024.0);
+        }
+    }
+    return 0;
+}
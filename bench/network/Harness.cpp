@@ -0,0 +1,326 @@
+#include "Harness.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <signal.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <afina/logging/Config.h>
+#include <afina/metrics/Histogram.h>
+#include <afina/network/Server.h>
+
+#include "logging/ServiceImpl.h"
+#include "network/mt_blocking/ServerImpl.h"
+#include "network/mt_coroutine/ServerImpl.h"
+#include "network/mt_nonblocking/ServerImpl.h"
+#include "network/st_blocking/ServerImpl.h"
+#include "network/st_coroutine/ServerImpl.h"
+#include "network/st_nonblocking/ServerImpl.h"
+#include "network/uring/ServerImpl.h"
+#include "storage/SimpleLRU.h"
+#include "storage/ThreadSafeSimpleLRU.h"
+
+using namespace Afina;
+
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+// Keys hot clients work with, all of them are stored before measurement
+const int keys = 1000;
+
+// Runs server of the given type in the current process until SIGTERM
+void serve(const std::string &type, uint16_t port, uint32_t workers) {
+    // Commands trace each execution to stdout, keep it out of the report
+    if (std::freopen("/dev/null", "w", stdout) == nullptr) {
+        return;
+    }
+
+    auto config = std::make_shared<Logging::Config>();
+    Logging::Appender &console = config->appenders["console"];
+    console.type = Logging::Appender::Type::STDERR;
+    console.color = false;
+    Logging::Logger &logger = config->loggers["root"];
+    // Clients drop connections with requests in flight once measurement is over, server reports each of them
+    logger.level = Logging::Logger::Level::CRITICAL;
+    logger.format = "[%n] [%l] %v";
+    logger.appenders.push_back("console");
+    auto logging = std::make_shared<Logging::ServiceImpl>(config);
+    logging->Start();
+
+    // Workers of multithreaded servers share storage
+    std::shared_ptr<Backend::SimpleLRU> storage;
+    if (type.compare(0, 3, "st_") != 0) {
+        storage = std::make_shared<Backend::ThreadSafeSimplLRU>(64 * 1024 * 1024);
+    } else {
+        storage = std::make_shared<Backend::SimpleLRU>(64 * 1024 * 1024);
+    }
+    storage->Start();
+
+    std::shared_ptr<Network::Server> server;
+    if (type == "st_block") {
+        server = std::make_shared<Network::STblocking::ServerImpl>(storage, logging);
+    } else if (type == "mt_block") {
+        server = std::make_shared<Network::MTblocking::ServerImpl>(storage, logging);
+    } else if (type == "st_nonblock") {
+        server = std::make_shared<Network::STnonblock::ServerImpl>(storage, logging);
+    } else if (type == "mt_nonblock") {
+        server = std::make_shared<Network::MTnonblock::ServerImpl>(storage, logging);
+    } else if (type == "st_coroutine") {
+        server = std::make_shared<Network::STcoroutine::ServerImpl>(storage, logging);
+    } else if (type == "uring") {
+        server = std::make_shared<Network::Uring::ServerImpl>(storage, logging);
+    } else {
+        server = std::make_shared<Network::MTcoroutine::ServerImpl>(storage, logging);
+    }
+
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &mask, nullptr);
+
+    server->Start(port, 1, workers);
+    int sig;
+    sigwait(&mask, &sig);
+    server->Stop();
+    server->Join();
+    storage->Stop();
+    logging->Stop();
+}
+
+int connect_to(uint16_t port) {
+    int s = socket(AF_INET, SOCK_STREAM, 0);
+    if (s == -1) {
+        throw std::runtime_error("socket() failed: " + std::string(strerror(errno)));
+    }
+
+    struct sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    for (int attempt = 0; connect(s, (struct sockaddr *)&addr, sizeof(addr)) == -1; attempt++) {
+        if (attempt == 100) {
+            throw std::runtime_error("connect() failed: " + std::string(strerror(errno)));
+        }
+        usleep(10000);
+    }
+
+    int one = 1;
+    setsockopt(s, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    return s;
+}
+
+// Sends request and reads until response ends with the given suffix
+void roundtrip(int s, const std::string &request, const char *suffix) {
+    if (send(s, request.data(), request.size(), 0) != ssize_t(request.size())) {
+        throw std::runtime_error("send() failed");
+    }
+
+    std::string response;
+    std::size_t suffix_len = std::strlen(suffix);
+    char buf[4096];
+    while (response.size() < suffix_len || response.compare(response.size() - suffix_len, suffix_len, suffix) != 0) {
+        ssize_t n = recv(s, buf, sizeof(buf), 0);
+        if (n <= 0) {
+            throw std::runtime_error("recv() failed");
+        }
+        response.append(buf, n);
+    }
+}
+
+// Opens given number of connections, each makes a single request. Clients connect in small groups, so that
+// accept queue never overflows and server has a routine or a connection object for each of them once done.
+// Blocking servers queue connections to executor, which has room for a single one, so they connect one by one
+std::vector<int> connect_all(const std::string &type, uint16_t port, int count) {
+    const int group = type.find("_block") != std::string::npos ? 1 : 4;
+    std::vector<int> sockets;
+    for (int i = 0; i < count; i += group) {
+        int n = std::min(group, count - i);
+        for (int j = 0; j < n; j++) {
+            sockets.push_back(connect_to(port));
+        }
+        for (int j = sockets.size() - n; j < int(sockets.size()); j++) {
+            roundtrip(sockets[j], "get key0\r\n", "END\r\n");
+        }
+    }
+    return sockets;
+}
+
+// Resident memory of the process in kilobytes
+long rss_kb(pid_t pid) {
+    char path[64];
+    std::snprintf(path, sizeof(path), "/proc/%d/status", int(pid));
+    FILE *f = std::fopen(path, "r");
+    if (f == nullptr) {
+        return -1;
+    }
+
+    long kb = -1;
+    char line[256];
+    while (std::fgets(line, sizeof(line), f) != nullptr) {
+        if (std::sscanf(line, "VmRSS: %ld", &kb) == 1) {
+            break;
+        }
+    }
+    std::fclose(f);
+    return kb;
+}
+
+// Hot client connection: requests in flight and responses which are not complete yet
+struct Hot {
+    int socket;
+    std::deque<Clock::time_point> sent;
+    std::string response;
+};
+
+// Appends i-th request to the batch
+void add_request(Hot &h, std::string &batch, uint64_t i) {
+    char request[128];
+    if (i % 10 == 0) {
+        std::snprintf(request, sizeof(request), "set key%d 0 0 8\r\nvalue%03d\r\n", int(i % keys), int(i % 1000));
+    } else {
+        std::snprintf(request, sizeof(request), "get key%d\r\n", int(i % keys));
+    }
+    batch += request;
+    h.sent.push_back(Clock::now());
+}
+
+void send_batch(Hot &h, const std::string &batch) {
+    if (send(h.socket, batch.data(), batch.size(), 0) != ssize_t(batch.size())) {
+        throw std::runtime_error("send() failed");
+    }
+}
+
+// Drops complete responses from the input, each of them is either STORED or ends with END line. Returns number
+// of them
+int take_responses(Hot &h, Metrics::Histogram &latency) {
+    int count = 0;
+    std::size_t start = 0, end;
+    auto now = Clock::now();
+    while ((end = h.response.find("\r\n", start)) != std::string::npos) {
+        if (h.response.compare(start, end - start, "END") == 0 || h.response.compare(start, end - start, "STORED") == 0) {
+            latency.Record(std::chrono::duration_cast<std::chrono::nanoseconds>(now - h.sent.front()).count());
+            h.sent.pop_front();
+            count++;
+        }
+        start = end + 2;
+    }
+    h.response.erase(0, start);
+    return count;
+}
+
+} // namespace
+
+// See Harness.h
+Result run(const std::string &type, uint16_t port, uint32_t workers, int idle, int hot, int seconds, int depth) {
+    // Otherwise child gets a copy of buffered report and prints it once more
+    std::fflush(stdout);
+    pid_t pid = fork();
+    if (pid == 0) {
+        serve(type, port, workers);
+        _exit(0);
+    }
+
+    Result r;
+    std::memset(&r, 0, sizeof(r));
+    std::vector<int> idle_sockets;
+    try {
+        int s = connect_to(port);
+        for (int k = 0; k < keys; k++) {
+            roundtrip(s, "set key" + std::to_string(k) + " 0 0 8\r\nvalue000\r\n", "STORED\r\n");
+        }
+        close(s);
+
+        idle_sockets = connect_all(type, port, idle);
+        r.rss_idle_kb = rss_kb(pid);
+
+        int epoll_fd = epoll_create1(0);
+        std::vector<Hot> clients(hot);
+        std::vector<int> hot_sockets = connect_all(type, port, hot);
+        for (int i = 0; i < hot; i++) {
+            clients[i].socket = hot_sockets[i];
+            fcntl(clients[i].socket, F_SETFL, O_NONBLOCK);
+            struct epoll_event ev;
+            ev.events = EPOLLIN;
+            ev.data.ptr = &clients[i];
+            epoll_ctl(epoll_fd, EPOLL_CTL_ADD, clients[i].socket, &ev);
+        }
+
+        Metrics::Histogram latency;
+        uint64_t sent = 0, done = 0;
+        for (auto &h : clients) {
+            std::string batch;
+            for (int i = 0; i < depth; i++) {
+                add_request(h, batch, sent++);
+            }
+            send_batch(h, batch);
+        }
+
+        auto start = Clock::now();
+        auto until = start + std::chrono::seconds(seconds);
+        struct epoll_event events[128];
+        char buf[4096];
+        while (Clock::now() < until) {
+            int n = epoll_wait(epoll_fd, events, 128, 100);
+            for (int i = 0; i < n; i++) {
+                Hot &h = *static_cast<Hot *>(events[i].data.ptr);
+                ssize_t got;
+                while ((got = recv(h.socket, buf, sizeof(buf), 0)) > 0) {
+                    h.response.append(buf, got);
+                }
+                if (got == 0) {
+                    throw std::runtime_error("server closed connection");
+                }
+
+                // Each response is replaced by a new request right away, all of them go in one batch
+                int completed = take_responses(h, latency);
+                if (completed > 0) {
+                    std::string batch;
+                    for (int j = 0; j < completed; j++) {
+                        add_request(h, batch, sent++);
+                    }
+                    send_batch(h, batch);
+                    done += completed;
+                }
+            }
+        }
+        double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+
+        r.ops = done / elapsed;
+        r.p50_us = latency.Percentile(50) / 1000;
+        r.p99_us = latency.Percentile(99) / 1000;
+        r.max_us = latency.Max() / 1000;
+
+        for (auto &h : clients) {
+            close(h.socket);
+        }
+        close(epoll_fd);
+    } catch (std::runtime_error &ex) {
+        std::fprintf(stderr, "%s: %s\n", type.c_str(), ex.what());
+    }
+
+    for (int s : idle_sockets) {
+        close(s);
+    }
+    kill(pid, SIGTERM);
+    waitpid(pid, nullptr, 0);
+    return r;
+}
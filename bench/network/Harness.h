@@ -0,0 +1,25 @@
+#ifndef AFINA_BENCH_NETWORK_HARNESS_H
+#define AFINA_BENCH_NETWORK_HARNESS_H
+
+#include <cstdint>
+#include <string>
+
+/**
+ * What clients have seen from the server during measurement
+ */
+struct Result {
+    double ops;
+    uint64_t p50_us;
+    uint64_t p99_us;
+    uint64_t max_us;
+    long rss_idle_kb;
+};
+
+/**
+ * Forks server of the given network type with the given number of workers, opens idle connections which make a
+ * single request and then keeps hot connections busy for the given number of seconds, each with depth requests
+ * in flight, 10% of them are sets
+ */
+Result run(const std::string &type, uint16_t port, uint32_t workers, int idle, int hot, int seconds, int depth = 1);
+
+#endif // AFINA_BENCH_NETWORK_HARNESS_H
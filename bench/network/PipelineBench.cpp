@@ -0,0 +1,26 @@
+#include <cstdio>
+
+#include "Harness.h"
+
+int main() {
+    const int seconds = 3;
+    const int depths[] = {1, 16, 64};
+
+    // Blocking servers serve connection by a thread, so only a few connections are hot: st_block has a single
+    // one, executor of mt_block has at most 4 threads
+    struct {
+        const char *type;
+        int hot;
+    } servers[] = {{"st_block", 1}, {"mt_block", 4}, {"st_nonblock", 4}};
+
+    std::printf("%-14s %6s %6s %10s %8s %8s %8s\n", "server", "hot", "depth", "ops/s", "p50_us", "p99_us", "max_us");
+    uint16_t port = 18280;
+    for (auto &server : servers) {
+        for (int depth : depths) {
+            Result r = run(server.type, port++, 1, 0, server.hot, seconds, depth);
+            std::printf("%-14s %6d %6d %10.0f %8lu %8lu %8lu\n", server.type, server.hot, depth, r.ops,
+                        (unsigned long)r.p50_us, (unsigned long)r.p99_us, (unsigned long)r.max_us);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,24 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+
+#include "Harness.h"
+
+int main(int argc, char **argv) {
+    const int hot = 256, seconds = 3;
+    const int cores = argc > 1 ? std::atoi(argv[1]) : std::max(1u, std::thread::hardware_concurrency());
+    const char *types[] = {"mt_nonblock", "mt_coroutine", "uring"};
+
+    // Single client thread drives all connections, so once server gets fast enough client becomes the limit
+    std::printf("%-14s %8s %6s %10s %8s %8s %8s\n", "server", "workers", "hot", "ops/s", "p50_us", "p99_us", "max_us");
+    uint16_t port = 18180;
+    for (const char *type : types) {
+        for (int workers = 1; workers <= cores; workers *= 2) {
+            Result r = run(type, port++, workers, 0, hot, seconds);
+            std::printf("%-14s %8d %6d %10.0f %8lu %8lu %8lu\n", type, workers, hot, r.ops, (unsigned long)r.p50_us,
+                        (unsigned long)r.p99_us, (unsigned long)r.max_us);
+        }
+    }
+    return 0;
+}
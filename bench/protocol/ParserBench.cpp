@@ -0,0 +1,181 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <afina/execute/Command.h>
+
+#include <protocol/Parser.h>
+
+using namespace Afina;
+
+namespace {
+
+// Stream of commands client sends and how it is split between reads
+struct Workload {
+    std::string stream;
+    std::size_t commands;
+    std::vector<std::size_t> reads;
+};
+
+std::string Key(std::size_t i) {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "key:%08zu", i);
+    return buf;
+}
+
+// Builds stream of count commands made by the given function
+template <typename F> Workload Make(std::size_t count, F &&command) {
+    Workload w;
+    w.commands = count;
+    for (std::size_t i = 0; i < count; i++) {
+        w.stream += command(i);
+    }
+    return w;
+}
+
+// Reads of the given size, as server gets them from the socket
+void SplitBy(Workload &w, std::size_t size) {
+    w.reads.clear();
+    for (std::size_t offset = 0; offset < w.stream.size(); offset += size) {
+        w.reads.push_back(std::min(size, w.stream.size() - offset));
+    }
+}
+
+// Each command comes in two reads, split point walks through every byte of the command
+template <typename F> void SplitEveryByte(Workload &w, F &&command) {
+    w.reads.clear();
+    for (std::size_t i = 0; i < w.commands; i++) {
+        std::size_t size = command(i).size();
+        std::size_t split = 1 + i % (size - 1);
+        w.reads.push_back(split);
+        w.reads.push_back(size - split);
+    }
+}
+
+// Parses workload the same way server does: builds each command and takes its argument. Returns number of commands
+std::size_t Run(const Workload &w, Protocol::Parser &parser, std::string &argument, bool in_place) {
+    std::size_t commands = 0, arg_remains = 0;
+    bool command = false;
+    std::unique_ptr<Execute::Command> owned;
+
+    const char *p = w.stream.data();
+    for (std::size_t read : w.reads) {
+        while (read > 0) {
+            if (!command) {
+                std::size_t parsed = 0;
+                if (parser.Parse(p, read, parsed)) {
+                    if (in_place) {
+                        command = parser.BuildInPlace(arg_remains) != nullptr;
+                    } else {
+                        owned = parser.Build(arg_remains);
+                        command = owned != nullptr;
+                    }
+                    if (arg_remains > 0) {
+                        arg_remains += 2;
+                    }
+                }
+                p += parsed;
+                read -= parsed;
+            }
+
+            if (command && arg_remains > 0) {
+                std::size_t take = std::min(arg_remains, read);
+                argument.append(p, take);
+                p += take;
+                read -= take;
+                arg_remains -= take;
+            }
+
+            if (command && arg_remains == 0) {
+                commands++;
+                command = false;
+                argument.resize(0);
+                parser.Reset();
+            }
+        }
+    }
+    return commands;
+}
+
+void Measure(const char *name, const char *reads, const Workload &w, bool in_place) {
+    Protocol::Parser parser(in_place ? Protocol::Parser::Mode::kView : Protocol::Parser::Mode::kCopy);
+    std::string argument;
+
+    // Warm up, then repeat for at least half a second
+    if (Run(w, parser, argument, in_place) != w.commands) {
+        std::printf("%s: parsed wrong number of commands\n", name);
+        return;
+    }
+
+    std::size_t rounds = 0;
+    auto start = std::chrono::steady_clock::now();
+    auto end = start;
+    do {
+        Run(w, parser, argument, in_place);
+        rounds++;
+        end = std::chrono::steady_clock::now();
+    } while (end - start < std::chrono::milliseconds(500));
+
+    double seconds = std::chrono::duration<double>(end - start).count();
+    double mb = double(w.stream.size()) * rounds / (1024 * 1024);
+    double cmds = double(w.commands) * rounds;
+    std::printf("%-22s %-10s %-8s %10.1f %10.2f\n", name, reads, in_place ? "view" : "copy", mb / seconds,
+                cmds / seconds / 1e6);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    const std::size_t count = 10000;
+
+    auto get = [](std::size_t i) { return "get " + Key(i) + "\r\n"; };
+    auto multi_get = [](std::size_t i) {
+        std::string cmd = "get";
+        for (std::size_t k = 0; k < 10; k++) {
+            cmd += " " + Key(i * 10 + k);
+        }
+        return cmd + "\r\n";
+    };
+    auto set = [](std::size_t size) {
+        return [size](std::size_t i) {
+            return "set " + Key(i) + " 0 0 " + std::to_string(size) + "\r\n" + std::string(size, 'x') + "\r\n";
+        };
+    };
+
+    std::printf("%-22s %-10s %-8s %10s %10s\n", "workload", "reads", "mode", "MB/s", "Mcmd/s");
+
+    Workload w = Make(count, get);
+    SplitBy(w, 4096);
+    Measure("get", "4096", w, false);
+    Measure("get", "4096", w, true);
+    SplitEveryByte(w, get);
+    Measure("get", "split", w, false);
+    Measure("get", "split", w, true);
+    SplitBy(w, 1);
+    Measure("get", "1", w, true);
+
+    w = Make(count, multi_get);
+    SplitBy(w, 4096);
+    Measure("get 10 keys", "4096", w, false);
+    Measure("get 10 keys", "4096", w, true);
+    SplitEveryByte(w, multi_get);
+    Measure("get 10 keys", "split", w, true);
+
+    const std::size_t sizes[] = {16, 1024, 64 * 1024};
+    for (std::size_t size : sizes) {
+        std::string name = "set " + std::to_string(size) + "B";
+        w = Make(size > 1024 ? count / 10 : count, set(size));
+        SplitBy(w, 4096);
+        Measure(name.c_str(), "4096", w, false);
+        Measure(name.c_str(), "4096", w, true);
+        if (size <= 1024) {
+            SplitEveryByte(w, set(size));
+            Measure(name.c_str(), "split", w, true);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,297 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <new>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <malloc.h>
+
+#include <afina/Storage.h>
+#include <afina/metrics/Histogram.h>
+
+#include "common/Zipf.h"
+#include "storage/ARC.h"
+#include "storage/ClockLRU.h"
+#include "storage/SegmentedLRU.h"
+#include "storage/SimpleLRU.h"
+#include "storage/ThreadSafe.h"
+#include "storage/ThreadSafeSimpleLRU.h"
+
+using namespace Afina;
+
+// Bytes of heap the process holds, as allocator sees them: rounding of each block is included
+static std::atomic<int64_t> heap_bytes(0);
+
+void *operator new(std::size_t size) {
+    void *p = std::malloc(size == 0 ? 1 : size);
+    if (p == nullptr) {
+        throw std::bad_alloc();
+    }
+    heap_bytes.fetch_add(malloc_usable_size(p), std::memory_order_relaxed);
+    return p;
+}
+
+void operator delete(void *p) noexcept {
+    if (p != nullptr) {
+        heap_bytes.fetch_sub(malloc_usable_size(p), std::memory_order_relaxed);
+        std::free(p);
+    }
+}
+
+namespace {
+
+// Storage implementation under test, new ones are to be added to the list in main
+struct Implementation {
+    const char *name;
+
+    // Could be used by many threads at once
+    bool thread_safe;
+
+    std::function<std::unique_ptr<Afina::Storage>(std::size_t max_size)> create;
+};
+
+// Operations mix, keys are zipfian
+struct Workload {
+    const char *name;
+    int threads;
+
+    // Number of distinct keys and bytes storage may hold
+    uint64_t keys;
+    std::size_t capacity;
+
+    // Value size is uniform in the range
+    std::size_t value_min;
+    std::size_t value_max;
+
+    // Share of gets, rest are puts. Get that misses puts the key back, as cache in front of database would
+    double get_ratio;
+
+    uint64_t ops_per_thread;
+
+    // Every scan_every operations start with gets of scan_length keys never seen before, as a batch job scanning
+    // a key range would do. No scans if zero
+    uint64_t scan_every;
+    uint64_t scan_length;
+
+    // Share of operations on keys never requested again, as most keys of CDN and web traces are
+    double unique_share;
+
+    // Every shift_every operations zipfian ranks move by a tenth of the keys, so that popular keys of the past turn
+    // cold and new ones become hot. Popularity never shifts if zero
+    uint64_t shift_every;
+
+    // Every other phase_every operations keys are zipfian by recency rather than by rank: the key that many
+    // operations behind the current one is requested, so each key is hot for a short while only and recency wins
+    // over frequency. Always by rank if zero
+    uint64_t phase_every;
+};
+
+struct Result {
+    uint64_t ops = 0;
+    uint64_t gets = 0;
+    uint64_t hits = 0;
+    Metrics::Histogram latency;
+};
+
+const double theta = 0.99;
+
+// Runs workload operations from the single thread
+void RunThread(Afina::Storage &storage, const Workload &w, const Bench::Zipf &zipf,
+               const std::vector<std::string> &keys, const std::vector<std::string> &scan_keys,
+               const std::vector<std::string> &values, uint64_t seed, Result &result) {
+    std::mt19937_64 rnd(seed);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    std::string out;
+    std::size_t scanned = 0;
+    std::string unique = "once" + std::to_string(seed) + "_";
+    const std::size_t unique_prefix = unique.size();
+
+    for (uint64_t i = 0; i < w.ops_per_thread; i++) {
+        bool scan = w.scan_length > 0 && (i % w.scan_every) < w.scan_length;
+        uint64_t shift = w.shift_every > 0 ? (i / w.shift_every) * (w.keys / 10) : 0;
+        const std::string *key;
+        if (scan) {
+            key = &scan_keys[scanned++ % scan_keys.size()];
+        } else if (uniform(rnd) < w.unique_share) {
+            unique.resize(unique_prefix);
+            unique += std::to_string(i);
+            key = &unique;
+        } else if (w.phase_every > 0 && (i / w.phase_every) % 2 == 1) {
+            key = &keys[(i + w.keys - zipf(uniform(rnd)) % w.keys) % w.keys];
+        } else {
+            key = &keys[(zipf(uniform(rnd)) + shift) % w.keys];
+        }
+        const std::string &value = values[rnd() % values.size()];
+
+        auto start = std::chrono::steady_clock::now();
+        if (scan || uniform(rnd) < w.get_ratio) {
+            // Scan keys are never found, so hits are counted for the zipfian keys only: they tell how much of the
+            // hot set a scan has pushed out
+            bool found = storage.Get(*key, out);
+            if (!scan) {
+                result.gets++;
+                result.hits += found;
+            }
+            if (!found) {
+                storage.Put(*key, value);
+            }
+        } else {
+            storage.Put(*key, value);
+        }
+        auto end = std::chrono::steady_clock::now();
+
+        result.latency.Record(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+        result.ops++;
+    }
+}
+
+void Run(const Implementation &backend, const Workload &w, bool csv) {
+    // Keys and values are made up front, so that neither their construction nor their memory is measured
+    std::vector<std::string> keys(w.keys);
+    for (uint64_t i = 0; i < w.keys; i++) {
+        keys[i] = "key" + std::to_string(i);
+    }
+    // Scan keys repeat once in a few scans, which is long enough for any of them to be evicted by then
+    std::vector<std::string> scan_keys(4 * w.scan_length);
+    for (uint64_t i = 0; i < scan_keys.size(); i++) {
+        scan_keys[i] = "scan" + std::to_string(i);
+    }
+    std::mt19937_64 rnd(42);
+    std::vector<std::string> values(64);
+    for (auto &v : values) {
+        v.assign(w.value_min + rnd() % (w.value_max - w.value_min + 1), 'x');
+    }
+    Bench::Zipf zipf(w.keys, theta);
+
+    // Storage starts full: every key is put once, the last ones stay if they don't fit
+    int64_t heap_before = heap_bytes.load();
+    std::unique_ptr<Afina::Storage> storage = backend.create(w.capacity);
+    for (uint64_t i = 0; i < w.keys; i++) {
+        storage->Put(keys[i], values[i % values.size()]);
+    }
+    int64_t heap_full = heap_bytes.load() - heap_before;
+
+    Afina::Storage::Usage usage;
+    storage->GetUsage(usage);
+    int64_t payload = usage.bytes - usage.overhead;
+    double overhead = usage.items ? double(heap_full - payload) / usage.items : 0.0;
+
+    std::vector<std::unique_ptr<Result>> results;
+    std::vector<std::thread> threads;
+    auto start = std::chrono::steady_clock::now();
+    for (int t = 0; t < w.threads; t++) {
+        results.emplace_back(new Result());
+        threads.emplace_back(RunThread, std::ref(*storage), std::cref(w), std::cref(zipf), std::cref(keys),
+                             std::cref(scan_keys), std::cref(values), 1000 + t, std::ref(*results[t]));
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    Result total;
+    for (auto &r : results) {
+        total.ops += r->ops;
+        total.gets += r->gets;
+        total.hits += r->hits;
+        total.latency.Merge(r->latency);
+    }
+    double seconds = std::chrono::duration<double>(end - start).count();
+    double ops = total.ops / seconds;
+    double hit_ratio = total.gets ? double(total.hits) / total.gets : 0.0;
+
+    if (csv) {
+        std::printf("%s,%s,%d,%.0f,%lu,%.1f,%.4f\n", backend.name, w.name, w.threads, ops,
+                    (unsigned long)total.latency.Percentile(99), overhead, hit_ratio);
+    } else {
+        std::printf("%-12s %-16s %7d %12.0f %10lu %12.1f %8.3f\n", backend.name, w.name, w.threads, ops,
+                    (unsigned long)total.latency.Percentile(99), overhead, hit_ratio);
+    }
+    std::fflush(stdout);
+}
+
+} // namespace
+
+// Usage: bench_storage [--csv] [backend or workload name...]
+int main(int argc, char **argv) {
+    const std::size_t MB = 1024 * 1024;
+
+    // clang-format off
+    const Implementation backends[] = {
+        {"st_lru", false, [](std::size_t max_size) { return std::unique_ptr<Afina::Storage>(new Backend::SimpleLRU(max_size)); }},
+        {"mt_lru", true, [](std::size_t max_size) { return std::unique_ptr<Afina::Storage>(new Backend::ThreadSafeSimplLRU(max_size)); }},
+        {"st_slru", false, [](std::size_t max_size) { return std::unique_ptr<Afina::Storage>(new Backend::SegmentedLRU(max_size)); }},
+        {"mt_slru", true, [](std::size_t max_size) { return std::unique_ptr<Afina::Storage>(new Backend::ThreadSafe<Backend::SegmentedLRU>(max_size)); }},
+        {"st_lru_tlfu", false, [](std::size_t max_size) { return std::unique_ptr<Afina::Storage>(new Backend::SimpleLRU(max_size, true)); }},
+        {"st_slru_tlfu", false, [](std::size_t max_size) { return std::unique_ptr<Afina::Storage>(new Backend::SegmentedLRU(max_size, 0.8, true)); }},
+        {"mt_slru_tlfu", true, [](std::size_t max_size) { return std::unique_ptr<Afina::Storage>(new Backend::ThreadSafe<Backend::SegmentedLRU>(max_size, 0.8, true)); }},
+        {"st_arc", false, [](std::size_t max_size) { return std::unique_ptr<Afina::Storage>(new Backend::ARC(max_size)); }},
+        {"mt_arc", true, [](std::size_t max_size) { return std::unique_ptr<Afina::Storage>(new Backend::ThreadSafe<Backend::ARC>(max_size)); }},
+        {"mt_clock", true, [](std::size_t max_size) { return std::unique_ptr<Afina::Storage>(new Backend::ClockLRU(max_size)); }},
+    };
+
+    // Concurrent workload runs at least 4 threads, even if cores are fewer: contention is what it is about
+    const int many = std::max(4, int(std::thread::hardware_concurrency()));
+    const Workload workloads[] = {
+        // name              threads  keys       capacity  values        gets  ops per thread             scans           unique  shift    phases
+        {"read_heavy",       1,       100000,    64 * MB,  100, 100,     0.95, 2000000,                   0, 0,           0.0,    0,       0},
+        {"write_heavy",      1,       100000,    64 * MB,  100, 100,     0.50, 2000000,                   0, 0,           0.0,    0,       0},
+        {"eviction_heavy",   1,       1000000,   16 * MB,  100, 100,     0.90, 2000000,                   0, 0,           0.0,    0,       0},
+        {"large_value",      1,       2000,      64 * MB,  16384, 65536, 0.90, 200000,                    0, 0,           0.0,    0,       0},
+        {"many_threads",     many,    100000,    64 * MB,  100, 100,     0.95, uint64_t(2000000 / many),  0, 0,           0.0,    0,       0},
+        {"scan_polluted",    1,       100000,    8 * MB,   100, 100,     0.95, 2000000,                   400000, 40000,  0.0,    0,       0},
+        {"one_hit_wonders",  1,       1000000,   16 * MB,  100, 100,     0.90, 2000000,                   0, 0,           0.3,    0,       0},
+        {"shifting_hot_set", 1,       1000000,   16 * MB,  100, 100,     0.90, 2000000,                   0, 0,           0.0,    250000,  0},
+        {"day_cycle",        1,       1000000,   16 * MB,  100, 100,     0.90, 4000000,                   0, 0,           0.0,    0,       500000},
+    };
+    // clang-format on
+
+    bool csv = false;
+    std::vector<std::string> only;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--csv") == 0) {
+            csv = true;
+        } else {
+            only.push_back(argv[i]);
+        }
+    }
+
+    // Names filter backends and workloads independently, nothing listed means everything runs
+    auto listed = [&](const char *name) { return std::find(only.begin(), only.end(), name) != only.end(); };
+    bool any_backend = false, any_workload = false;
+    for (auto &b : backends) {
+        any_backend |= listed(b.name);
+    }
+    for (auto &w : workloads) {
+        any_workload |= listed(w.name);
+    }
+
+    if (csv) {
+        std::printf("backend,workload,threads,ops_per_sec,p99_ns,overhead_bytes_per_item,hit_ratio\n");
+    } else {
+        std::printf("%-12s %-16s %7s %12s %10s %12s %8s\n", "backend", "workload", "threads", "ops/s", "p99, ns",
+                    "overhead, B", "hits");
+    }
+
+    for (auto &b : backends) {
+        if (any_backend && !listed(b.name)) {
+            continue;
+        }
+        for (auto &w : workloads) {
+            if ((any_workload && !listed(w.name)) || (w.threads > 1 && !b.thread_safe)) {
+                continue;
+            }
+            Run(b, w, csv);
+        }
+    }
+    return 0;
+}
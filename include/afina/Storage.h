@@ -1,6 +1,7 @@
 #ifndef AFINA_STORAGE_H
 #define AFINA_STORAGE_H
 
+#include <cstdint>
 #include <string>
 
 namespace Afina {
@@ -10,6 +11,26 @@ namespace Afina {
  */
 class Storage {
 public:
+    /**
+     * Storage usage counters, reported by the stats command
+     */
+    struct Usage {
+        // Number of items currently stored
+        std::size_t items = 0;
+
+        // Number of bytes currently used to store items, including their metadata and allocator slack
+        std::size_t bytes = 0;
+
+        // Part of the bytes spent on something else than keys and values
+        std::size_t overhead = 0;
+
+        // Maximum number of bytes storage is allowed to use
+        std::size_t limit = 0;
+
+        // Number of valid items removed from storage to free memory for new items
+        uint64_t evictions = 0;
+    };
+
     Storage() {}
     virtual ~Storage() {}
 
@@ -84,6 +105,14 @@ public:
      * @param value output parameter to copy value to
      */
     virtual bool Get(const std::string &key, std::string &value) = 0;
+
+    /**
+     * Fills given output parameter with the current storage usage. Default implementation knows nothing
+     * about storage internals and leaves everything zero
+     *
+     * @param usage output parameter to write counters to
+     */
+    virtual void GetUsage(Usage &usage) {}
 };
 
 } // namespace Afina
@@ -0,0 +1,83 @@
+#ifndef AFINA_CONCURRENCY_EPOCH_H
+#define AFINA_CONCURRENCY_EPOCH_H
+
+#include <atomic>
+#include <cstdint>
+
+#include <afina/concurrency/ThreadLocal.h>
+
+namespace Afina {
+namespace Concurrency {
+
+/**
+ * # Epoch based reclamation
+ * Lets readers walk shared structure without any lock, while writers unlink and free its nodes. Reader wraps
+ * the walk into a Guard, which announces the epoch it has started in. Writer tags each unlinked node with the
+ * epoch of unlinking and frees it once Advance tells that no reader is left in that epoch or earlier.
+ *
+ * Guard costs a store and a fence on the reader side and never writes shared cache lines: each thread announces
+ * its epoch in its own ThreadLocal copy. Advance visits all of them, so it is meant to be called by writers
+ * only, one at a time
+ */
+class Epoch {
+private:
+    // Epoch the thread has entered its read section in, zero if it is outside of any
+    struct Reader {
+        Reader() : epoch(0) {}
+        std::atomic<uint64_t> epoch;
+    };
+
+public:
+    Epoch() : _global(1) {}
+
+    /**
+     * Read section: nodes reachable from the structure while it is alive are not freed
+     */
+    class Guard {
+    public:
+        explicit Guard(Epoch &epoch) : _reader(epoch._readers.get()) {
+            _reader.epoch.store(epoch._global.load(std::memory_order_acquire), std::memory_order_relaxed);
+
+            // Either Advance sees the announcement, or this thread sees everything unlinked before it
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+        }
+        ~Guard() { _reader.epoch.store(0, std::memory_order_release); }
+
+    private:
+        Guard(const Guard &) = delete;
+        Guard &operator=(const Guard &) = delete;
+
+        Reader &_reader;
+    };
+
+    /**
+     * Returns epoch to tag the node being unlinked now with
+     */
+    uint64_t Current() const { return _global.load(std::memory_order_relaxed); }
+
+    /**
+     * Starts the next epoch and returns the oldest one some reader may still be in: nodes tagged with an
+     * earlier epoch are unreachable for everyone and could be freed
+     */
+    uint64_t Advance() {
+        uint64_t oldest = _global.fetch_add(1, std::memory_order_acq_rel) + 1;
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        _readers.for_each([&oldest](const Reader &reader) {
+            uint64_t epoch = reader.epoch.load(std::memory_order_acquire);
+            if (epoch != 0 && epoch < oldest) {
+                oldest = epoch;
+            }
+        });
+        return oldest;
+    }
+
+private:
+    std::atomic<uint64_t> _global;
+    ThreadLocal<Reader> _readers;
+};
+
+} // namespace Concurrency
+} // namespace Afina
+
+#endif // AFINA_CONCURRENCY_EPOCH_H
@@ -1,24 +1,41 @@
 #ifndef AFINA_CONCURRENCY_EXECUTOR_H
 #define AFINA_CONCURRENCY_EXECUTOR_H
 
+#include <atomic>
 #include <chrono>
 #include <condition_variable>
 #include <functional>
 #include <memory>
 #include <mutex>
-#include <queue>
 #include <string>
 #include <thread>
+#include <vector>
 
-// for debugging
-#include <iostream>
-#include <unistd.h>
+#include <afina/concurrency/SlotPool.h>
+#include <afina/concurrency/Task.h>
+#include <afina/concurrency/WorkStealingDeque.h>
+#include <afina/metrics/Histogram.h>
+#include <afina/metrics/Latency.h>
 
 namespace Afina {
 namespace Concurrency {
 
 /**
  * # Thread pool
+ * Work stealing thread pool: each worker owns a deque of tasks, tasks submitted from the inside of
+ * a worker go to its own deque, tasks submitted from the outside go to the shared injection queue.
+ * Worker runs own tasks first, then injected ones and once there is nothing else steals from others.
+ *
+ * Number of threads is kept between low_watermark and high_watermark: new thread is spawned on submit if
+ * there are more queued tasks than free workers, thread above low_watermark exits once it was idle for idle_time.
+ *
+ * Submission doesn't allocate: closure is kept in the Task and queue nodes come from the SlotPool.
+ *
+ * Tasks have priority: each priority has its own injection queue (lane) and each worker picks the lane by smooth
+ * weighted round robin among non-empty ones, so bulk tasks can't starve interactive ones and vice versa. Tasks
+ * submitted by workers with normal priority stay in the local deque, which is a part of the normal lane. Task
+ * could also have a deadline: once it has passed, task is dropped instead of being run, optional expiration
+ * handler runs instead so that resources owned by the task could be released.
  */
 class Executor {
     enum class State {
@@ -34,8 +51,56 @@ class Executor {
     };
 
 public:
-    Executor(int th_min, int th_max, int q_max, int wait_max)
-        : low_watermark(th_min), high_watermark(th_max), max_queue_size(q_max), idle_time(wait_max) {}
+    /**
+     * Task priority, see class description
+     */
+    enum class Priority {
+        // Short interactive requests, administration
+        kHigh,
+
+        // Everything else
+        kNormal,
+
+        // Bulk work that could wait
+        kLow
+    };
+    static const int kPriorities = 3;
+
+    using Deadline = std::chrono::steady_clock::time_point;
+
+    /**
+     * Deadline of tasks that never expire
+     */
+    static Deadline NoDeadline() { return Deadline::max(); }
+
+    /**
+     * Pool statistics, see GetStatistics
+     */
+    struct Statistics {
+        // Current state
+        int threads_live;
+        int threads_free;
+        int queue_depth;
+
+        // Highest number of queued tasks ever seen
+        int queue_depth_max;
+
+        // Number of Execute calls returned false
+        uint64_t tasks_rejected;
+
+        // Number of tasks dropped because of deadline
+        uint64_t tasks_expired;
+
+        // Number of threads started and number of threads exited after being idle for too long
+        uint64_t threads_spawned;
+        uint64_t threads_retired;
+
+        // Time from Execute to the start of the task and time task was running, in nanoseconds
+        Metrics::Histogram wait_time;
+        Metrics::Histogram run_time;
+    };
+
+    Executor(int th_min, int th_max, int q_max, int wait_max);
     ~Executor() { this->Stop(true); }
 
     /**
@@ -60,27 +125,23 @@ public:
      */
     template <typename F, typename... Types> bool Execute(F &&func, Types... args) {
         // Prepare "task"
-        auto exec = std::bind(std::forward<F>(func), std::forward<Types>(args)...);
-
-        {
-            std::unique_lock<std::mutex> lock(this->state_mutex);
-            if (state != State::kRun) {
-                return false;
-            }
-
-            if (tasks.size() >= max_queue_size) {
-                return false;
-            }
-
-            try_create_worker();
+        return enqueue(Task(std::bind(std::forward<F>(func), std::forward<Types>(args)...)), Priority::kNormal,
+                       NoDeadline(), Task());
+    }
 
-            // Enqueue new task
-            tasks.push_back(exec);
-        }
-        empty_condition.notify_one();
-        return true;
+    /**
+     * Same as Execute, but with the given priority and deadline. If task hasn't started before the deadline it
+     * is dropped and expired is called instead, unless it is empty. Expiration handler runs on the pool thread
+     */
+    bool Schedule(Priority priority, Deadline deadline, Task &&task, Task &&expired = Task()) {
+        return enqueue(std::move(task), priority, deadline, std::move(expired));
     }
 
+    /**
+     * Fills statistics of the pool since its creation, could be called from any thread
+     */
+    void GetStatistics(Statistics &stats);
+
 private:
     // No copy/move/assign allowed
     Executor(const Executor &);            // = delete;
@@ -88,20 +149,102 @@ private:
     Executor &operator=(const Executor &); // = delete;
     Executor &operator=(Executor &&);      // = delete;
 
-    bool check_running();
+    /**
+     * Queued task, intrusive so that injection queue needs no memory of its own
+     */
+    struct Node {
+        Node(Task &&t, Priority p, Deadline d, Task &&e, uint64_t now)
+            : task(std::move(t)), expired(std::move(e)), next(nullptr), priority(p), deadline(d), enqueued(now) {}
 
-    bool check_tasks_left();
+        Task task;
+        Task expired;
+        Node *next;
+
+        Priority priority;
+        Deadline deadline;
+
+        // Metrics::Clock reading taken on submit
+        uint64_t enqueued;
+    };
 
     /**
-     * Try to create new worker if high_watermark is not reached yet
+     * Injection queue of single priority, guarded by inject_mutex
+     */
+    struct Lane {
+        Lane() : head(nullptr), tail(nullptr), size(0) {}
+
+        Node *head;
+        Node *tail;
+
+        // Allows to skip inject_mutex if lane is empty
+        std::atomic<int> size;
+    };
+
+    using NodePool = SlotPool<sizeof(Node)>;
+
+    /**
+     * Per thread state, slots are allocated once for high_watermark threads and reused by threads
+     * spawned later
+     */
+    struct Worker {
+        Worker(Executor *executor) : owner(executor), used(false) {
+            for (auto &c : credit) {
+                c = 0;
+            }
+        }
+
+        // Deque ends are aligned to cache lines, which plain new guarantees only since C++17
+        static void *operator new(std::size_t size);
+        static void operator delete(void *p);
+
+        // Pool this slot belongs to
+        Executor *const owner;
+
+        // Tasks submitted by the thread owning this slot
+        WorkStealingDeque<Node> tasks;
+
+        // Is there thread owning this slot, guarded by state_mutex
+        bool used;
+
+        // Written by the thread owning this slot, see Statistics
+        Metrics::Histogram wait_time;
+        Metrics::Histogram run_time;
+
+        // Smooth weighted round robin state, see find_task
+        int credit[kPriorities];
+    };
+
+    /**
+     * Places task onto the execution queue, see Execute
+     */
+    bool enqueue(Task &&task, Priority priority, Deadline deadline, Task &&expired);
+
+    /**
+     * Try to create new worker if there are no free workers for queued tasks and high_watermark is not reached yet
      * Does not lock mutex and must be called inside unique_lock block
      */
     void try_create_worker();
 
+    /**
+     * Looks for the task to execute: picks the lane by weighted round robin and takes task from it. Normal lane
+     * consists of own deque, injection queue and then other workers deques
+     */
+    Node *find_task(Worker *self);
+
+    /**
+     * Takes the oldest task from the injection queue of the given priority, nullptr if there are no such
+     */
+    Node *take_injected(Priority priority);
+
+    /**
+     * Takes task from the normal lane: own deque, injection queue, other workers deques
+     */
+    Node *take_normal(Worker *self);
+
     /**
      * Main function that all pool threads are running. It polls internal task queue and execute tasks
      */
-    friend void perform(Executor *executor);
+    friend void perform(Executor *executor, Worker *self);
 
     /**
      * Mutex to protect state below from concurrent modification
@@ -119,9 +262,15 @@ private:
     std::condition_variable finish_condition;
 
     /**
-     * Task queue
+     * Worker slots, high_watermark of them
      */
-    std::deque<std::function<void()>> tasks;
+    std::vector<std::unique_ptr<Worker>> workers;
+
+    /**
+     * Tasks submitted from the outside of the pool and tasks with non normal priority, one lane per priority
+     */
+    std::mutex inject_mutex;
+    Lane lanes[kPriorities];
 
     // thread pool parameters
     int low_watermark;
@@ -129,14 +278,27 @@ private:
     int max_queue_size;
     std::chrono::milliseconds idle_time;
 
-    // thread pool state variables
-    int live_workers;
-    int free_workers;
+    // Number of tasks enqueued but not started yet, wherever they are
+    std::atomic<int> queued;
+
+    // Number of workers waiting on empty_condition
+    std::atomic<int> sleeping;
+
+    // thread pool state variables, live_workers is changed under state_mutex
+    std::atomic<int> live_workers;
+    std::atomic<int> free_workers;
+
+    // Statistics, spawned and retired are guarded by state_mutex
+    std::atomic<int> queue_depth_max;
+    std::atomic<uint64_t> rejected;
+    std::atomic<uint64_t> expired;
+    uint64_t spawned;
+    uint64_t retired;
 
     /**
      * Flag to stop bg threads
      */
-    State state;
+    std::atomic<State> state;
 };
 
 } // namespace Concurrency
@@ -0,0 +1,132 @@
+#ifndef AFINA_CONCURRENCY_SLOT_POOL_H
+#define AFINA_CONCURRENCY_SLOT_POOL_H
+
+#include <cstddef>
+#include <mutex>
+#include <new>
+
+namespace Afina {
+namespace Concurrency {
+
+/**
+ * # Pool of fixed size memory slots
+ * Allocator for short living objects of the same size, such as queued tasks. Each thread keeps a small
+ * cache of free slots, so allocate/free are a couple of pointer moves. Slots freed by other thread, which
+ * is the usual case for tasks, go to that thread's cache and once it overflows half of the cache moves to
+ * the shared list. Shared list is refilled by large chunks, so after warm up there are no calls to malloc.
+ *
+ * Memory is never given back to the system: pool size is the maximum number of slots ever used at once
+ */
+template <std::size_t Size> class SlotPool {
+public:
+    // Every slot is aligned as well as malloc result
+    static const std::size_t kSlotSize = (Size + alignof(std::max_align_t) - 1) & ~(alignof(std::max_align_t) - 1);
+
+    /**
+     * Returns memory for one object of at most Size bytes
+     */
+    static void *Allocate() {
+        Cache &c = cache();
+        if (c.head == nullptr) {
+            shared().take(c);
+        }
+
+        Slot *s = c.head;
+        c.head = s->next;
+        c.size--;
+        return s;
+    }
+
+    /**
+     * Returns slot back to the pool, could be called from any thread
+     */
+    static void Free(void *p) {
+        Cache &c = cache();
+        Slot *s = static_cast<Slot *>(p);
+        s->next = c.head;
+        c.head = s;
+        if (++c.size >= 2 * kBatch) {
+            shared().give(c, kBatch);
+        }
+    }
+
+private:
+    // Number of slots moved between thread cache and shared list at once
+    static const std::size_t kBatch = 32;
+
+    // Number of slots allocated from the system at once
+    static const std::size_t kChunk = 256;
+
+    union Slot {
+        Slot *next;
+        alignas(std::max_align_t) unsigned char data[kSlotSize];
+    };
+
+    struct Cache {
+        Slot *head = nullptr;
+        std::size_t size = 0;
+
+        ~Cache() {
+            if (size > 0) {
+                shared().give(*this, size);
+            }
+        }
+    };
+
+    struct Shared {
+        std::mutex mutex;
+        Slot *head = nullptr;
+
+        // Moves up to kBatch slots into the cache, allocates new chunk if there are no free slots
+        void take(Cache &c) {
+            std::unique_lock<std::mutex> lock(mutex);
+            if (head == nullptr) {
+                Slot *chunk = static_cast<Slot *>(::operator new(kChunk * sizeof(Slot)));
+                for (std::size_t i = 0; i < kChunk; i++) {
+                    chunk[i].next = head;
+                    head = &chunk[i];
+                }
+            }
+
+            for (std::size_t i = 0; i < kBatch && head != nullptr; i++) {
+                Slot *s = head;
+                head = s->next;
+                s->next = c.head;
+                c.head = s;
+                c.size++;
+            }
+        }
+
+        // Moves n slots from the cache
+        void give(Cache &c, std::size_t n) {
+            std::unique_lock<std::mutex> lock(mutex);
+            for (std::size_t i = 0; i < n; i++) {
+                Slot *s = c.head;
+                c.head = s->next;
+                c.size--;
+                s->next = head;
+                head = s;
+            }
+        }
+    };
+
+    // Never destroyed: thread caches could be released after static destructors have run
+    static Shared &shared() {
+        static Shared *instance = new Shared();
+        return *instance;
+    }
+
+    static Cache &cache() {
+        static thread_local Cache instance;
+        return instance;
+    }
+};
+
+template <std::size_t Size> const std::size_t SlotPool<Size>::kSlotSize;
+template <std::size_t Size> const std::size_t SlotPool<Size>::kBatch;
+template <std::size_t Size> const std::size_t SlotPool<Size>::kChunk;
+
+} // namespace Concurrency
+} // namespace Afina
+
+#endif // AFINA_CONCURRENCY_SLOT_POOL_H
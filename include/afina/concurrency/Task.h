@@ -0,0 +1,169 @@
+#ifndef AFINA_CONCURRENCY_TASK_H
+#define AFINA_CONCURRENCY_TASK_H
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include <afina/concurrency/SlotPool.h>
+
+namespace Afina {
+namespace Concurrency {
+
+/**
+ * # Move only void() callable
+ * Replacement of std::function<void()> for the thread pool. Closures up to kInlineSize bytes are stored
+ * right inside the task, which covers bound member function with a couple of arguments. Larger ones up to
+ * kPooledSize are placed into SlotPool, so creating and running a task normally never calls malloc.
+ * Anything even larger falls back to the operator new.
+ *
+ * Callable doesn't have to be copyable, only move constructible
+ */
+class Task {
+public:
+    static const std::size_t kInlineSize = 48;
+    static const std::size_t kPooledSize = 256;
+
+    Task() : _ops(nullptr) {}
+
+    template <typename F, typename = typename std::enable_if<
+                              !std::is_same<typename std::decay<F>::type, Task>::value>::type>
+    Task(F &&func) {
+        typedef typename std::decay<F>::type Func;
+        typedef typename std::conditional<
+            (sizeof(Func) <= kInlineSize && alignof(Func) <= alignof(std::max_align_t) &&
+             std::is_nothrow_move_constructible<Func>::value),
+            Inline<Func>, typename std::conditional<(sizeof(Func) <= kPooledSize &&
+                                                     alignof(Func) <= alignof(std::max_align_t)),
+                                                    Pooled<Func>, Heap<Func>>::type>::type Holder;
+
+        Holder::create(&_storage, std::forward<F>(func));
+        _ops = &Holder::ops;
+    }
+
+    Task(Task &&other) noexcept : _ops(other._ops) {
+        if (_ops != nullptr) {
+            _ops->move(&_storage, &other._storage);
+            other._ops = nullptr;
+        }
+    }
+
+    Task &operator=(Task &&other) noexcept {
+        if (this != &other) {
+            reset();
+            _ops = other._ops;
+            if (_ops != nullptr) {
+                _ops->move(&_storage, &other._storage);
+                other._ops = nullptr;
+            }
+        }
+        return *this;
+    }
+
+    ~Task() { reset(); }
+
+    /**
+     * Runs stored callable, task must not be empty
+     */
+    void operator()() { _ops->call(&_storage); }
+
+    explicit operator bool() const { return _ops != nullptr; }
+
+    /**
+     * Destroys stored callable, if any
+     */
+    void reset() {
+        if (_ops != nullptr) {
+            _ops->destroy(&_storage);
+            _ops = nullptr;
+        }
+    }
+
+private:
+    Task(const Task &) = delete;
+    Task &operator=(const Task &) = delete;
+
+    typedef std::aligned_storage<kInlineSize, alignof(std::max_align_t)>::type Storage;
+
+    // Type erased operations on the storage
+    struct Ops {
+        void (*call)(void *storage);
+
+        // Moves callable to the uninitialized storage, source is left destroyed
+        void (*move)(void *dst, void *src);
+        void (*destroy)(void *storage);
+    };
+
+    // Callable lives in the storage itself
+    template <typename F> struct Inline {
+        template <typename A> static void create(void *storage, A &&func) {
+            new (storage) F(std::forward<A>(func));
+        }
+
+        static void call(void *storage) { (*static_cast<F *>(storage))(); }
+
+        static void move(void *dst, void *src) {
+            F *f = static_cast<F *>(src);
+            new (dst) F(std::move(*f));
+            f->~F();
+        }
+
+        static void destroy(void *storage) { static_cast<F *>(storage)->~F(); }
+
+        static const Ops ops;
+    };
+
+    // Storage keeps pointer to the callable placed somewhere else, Alloc defines where exactly
+    template <typename F, typename Alloc> struct Indirect {
+        template <typename A> static void create(void *storage, A &&func) {
+            void *p = Alloc::allocate();
+            try {
+                *static_cast<F **>(storage) = new (p) F(std::forward<A>(func));
+            } catch (...) {
+                Alloc::free(p);
+                throw;
+            }
+        }
+
+        static void call(void *storage) { (**static_cast<F **>(storage))(); }
+
+        static void move(void *dst, void *src) { *static_cast<F **>(dst) = *static_cast<F **>(src); }
+
+        static void destroy(void *storage) {
+            F *f = *static_cast<F **>(storage);
+            f->~F();
+            Alloc::free(f);
+        }
+
+        static const Ops ops;
+    };
+
+    struct PoolAlloc {
+        static void *allocate() { return SlotPool<kPooledSize>::Allocate(); }
+        static void free(void *p) { SlotPool<kPooledSize>::Free(p); }
+    };
+
+    template <typename F> struct HeapAlloc {
+        static void *allocate() { return ::operator new(sizeof(F)); }
+        static void free(void *p) { ::operator delete(p); }
+    };
+
+    template <typename F> using Pooled = Indirect<F, PoolAlloc>;
+    template <typename F> using Heap = Indirect<F, HeapAlloc<F>>;
+
+    const Ops *_ops;
+    Storage _storage;
+};
+
+template <typename F> const Task::Ops Task::Inline<F>::ops = {&Task::Inline<F>::call, &Task::Inline<F>::move,
+                                                              &Task::Inline<F>::destroy};
+
+template <typename F, typename Alloc>
+const Task::Ops Task::Indirect<F, Alloc>::ops = {&Task::Indirect<F, Alloc>::call, &Task::Indirect<F, Alloc>::move,
+                                                 &Task::Indirect<F, Alloc>::destroy};
+
+} // namespace Concurrency
+} // namespace Afina
+
+#endif // AFINA_CONCURRENCY_TASK_H
@@ -1,10 +1,142 @@
 #ifndef AFINA_CONCURRENCY_THREAD_LOCAL_H
 #define AFINA_CONCURRENCY_THREAD_LOCAL_H
 
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+
 namespace Afina {
 namespace Concurrency {
 
-template <typename T> class ThreadLocal {};
+/**
+ * # Per thread instance of T
+ * Each thread calling get() receives its own copy of T and could modify it without any synchronization,
+ * while any other thread could visit all copies using for_each, for example to merge per thread counters.
+ * Concurrent reads are up to T, usually it consists of relaxed atomics.
+ *
+ * Copies are owned by ThreadLocal and never released while it is alive. Once thread exits its copy gets
+ * back to the pool and handed over to the next thread calling get(), so T must be fine to inherit state
+ * of the previous owner, which is the case for accumulating counters
+ */
+template <typename T> class ThreadLocal {
+public:
+    ThreadLocal() : _index(registry().attach(this)) {}
+    ~ThreadLocal() { registry().detach(_index); }
+
+    /**
+     * Returns copy of T owned by the calling thread
+     */
+    T &get() {
+        std::vector<T *> &slots = cache().slots;
+        if (_index < slots.size() && slots[_index] != nullptr) {
+            return *slots[_index];
+        }
+        return acquire();
+    }
+
+    /**
+     * Calls given function for each copy of T ever created, including those currently in the pool
+     */
+    template <typename F> void for_each(F &&func) {
+        std::unique_lock<std::mutex> lock(_mutex);
+        for (auto &p : _all) {
+            func(static_cast<const T &>(*p));
+        }
+    }
+
+private:
+    ThreadLocal(const ThreadLocal &) = delete;
+    ThreadLocal &operator=(const ThreadLocal &) = delete;
+
+    /**
+     * All ThreadLocal<T> instances, allows thread to return its copies on exit. Index of the instance
+     * is never reused, so stale cache entries of the dead instances are never accessed
+     */
+    struct Registry {
+        std::mutex mutex;
+        std::vector<ThreadLocal *> instances;
+
+        std::size_t attach(ThreadLocal *instance) {
+            std::unique_lock<std::mutex> lock(mutex);
+            instances.push_back(instance);
+            return instances.size() - 1;
+        }
+
+        void detach(std::size_t index) {
+            std::unique_lock<std::mutex> lock(mutex);
+            instances[index] = nullptr;
+        }
+    };
+
+    /**
+     * Thread's copies of T indexed by ThreadLocal#_index
+     */
+    struct Cache {
+        std::vector<T *> slots;
+
+        ~Cache() {
+            Registry &r = registry();
+            std::unique_lock<std::mutex> lock(r.mutex);
+            for (std::size_t i = 0; i < slots.size(); i++) {
+                if (slots[i] != nullptr && r.instances[i] != nullptr) {
+                    r.instances[i]->release(slots[i]);
+                }
+            }
+        }
+    };
+
+    // Registry outlives everything, threads could exit after static destructors are done
+    static Registry &registry() {
+        static Registry *r = new Registry();
+        return *r;
+    }
+
+    static Cache &cache() {
+        static thread_local Cache c;
+        return c;
+    }
+
+    // Slow path of get(): take copy from the pool or create new one
+    T &acquire() {
+        T *result = nullptr;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            if (!_free.empty()) {
+                result = _free.back();
+                _free.pop_back();
+            } else {
+                _all.emplace_back(new T());
+                result = _all.back().get();
+            }
+        }
+
+        std::vector<T *> &slots = cache().slots;
+        if (slots.size() <= _index) {
+            slots.resize(_index + 1, nullptr);
+        }
+        slots[_index] = result;
+        return *result;
+    }
+
+    // Called on thread exit, must be called under registry lock
+    void release(T *p) {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _free.push_back(p);
+    }
+
+    // Position of this instance in the registry and in each thread cache
+    const std::size_t _index;
+
+    // Protects pool below
+    std::mutex _mutex;
+
+    // Every copy ever created
+    std::vector<std::unique_ptr<T>> _all;
+
+    // Copies whose threads have been exited
+    std::vector<T *> _free;
+};
 
 } // namespace Concurrency
 } // namespace Afina
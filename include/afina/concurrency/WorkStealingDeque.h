@@ -0,0 +1,125 @@
+#ifndef AFINA_CONCURRENCY_WORK_STEALING_DEQUE_H
+#define AFINA_CONCURRENCY_WORK_STEALING_DEQUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace Afina {
+namespace Concurrency {
+
+/**
+ * # Chase-Lev work stealing deque
+ * Bounded deque of pointers. Owner thread pushes and pops at the bottom (LIFO, cache-hot tasks first), any
+ * other thread could steal from the top (FIFO, oldest tasks first). Owner operations are wait free and touch
+ * no shared cache line unless deque is almost empty, steal is lock free.
+ *
+ * Implementation follows "Correct and Efficient Work-Stealing for Weak Memory Models" (Le et al., 2013),
+ * except that buffer never grows: push reports failure instead, so caller could put item somewhere else.
+ */
+template <typename T> class WorkStealingDeque {
+public:
+    /**
+     * @param capacity maximum number of items, rounded up to the power of two
+     */
+    explicit WorkStealingDeque(std::size_t capacity = 256) : _top(0), _bottom(0) {
+        std::size_t size = 1;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        _mask = size - 1;
+        _buffer.reset(new std::atomic<T *>[size]);
+    }
+
+    /**
+     * Adds item to the bottom. Owner thread only. Returns false if deque is full
+     */
+    bool push(T *item) {
+        int64_t b = _bottom.load(std::memory_order_relaxed);
+        int64_t t = _top.load(std::memory_order_acquire);
+        if (b - t > int64_t(_mask)) {
+            return false;
+        }
+
+        _buffer[b & _mask].store(item, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        _bottom.store(b + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    /**
+     * Takes the most recently pushed item. Owner thread only. Returns nullptr if deque is empty
+     */
+    T *pop() {
+        int64_t b = _bottom.load(std::memory_order_relaxed) - 1;
+        _bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t t = _top.load(std::memory_order_relaxed);
+
+        if (t > b) {
+            // Empty
+            _bottom.store(b + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+
+        T *item = _buffer[b & _mask].load(std::memory_order_relaxed);
+        if (t == b) {
+            // Last item, race against thieves
+            if (!_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                item = nullptr;
+            }
+            _bottom.store(b + 1, std::memory_order_relaxed);
+        }
+        return item;
+    }
+
+    /**
+     * Takes the oldest item. Any thread. Returns nullptr if deque is empty or if some other thread won
+     * the race for the item, in the later case lost flag is set
+     */
+    T *steal(bool &lost) {
+        lost = false;
+        int64_t t = _top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t b = _bottom.load(std::memory_order_acquire);
+        if (t >= b) {
+            return nullptr;
+        }
+
+        T *item = _buffer[t & _mask].load(std::memory_order_relaxed);
+        if (!_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            lost = true;
+            return nullptr;
+        }
+        return item;
+    }
+
+    /**
+     * Approximate number of items, exact if called by owner while nobody steals
+     */
+    std::size_t size() const {
+        int64_t b = _bottom.load(std::memory_order_relaxed);
+        int64_t t = _top.load(std::memory_order_relaxed);
+        return b > t ? std::size_t(b - t) : 0;
+    }
+
+private:
+    WorkStealingDeque(const WorkStealingDeque &) = delete;
+    WorkStealingDeque &operator=(const WorkStealingDeque &) = delete;
+
+    // Thieves side, keep it away from owner's bottom
+    alignas(64) std::atomic<int64_t> _top;
+
+    // Owner side
+    alignas(64) std::atomic<int64_t> _bottom;
+
+    // Ring buffer, capacity is _mask + 1
+    std::unique_ptr<std::atomic<T *>[]> _buffer;
+    std::size_t _mask;
+};
+
+} // namespace Concurrency
+} // namespace Afina
+
+#endif // AFINA_CONCURRENCY_WORK_STEALING_DEQUE_H
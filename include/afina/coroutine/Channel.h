@@ -0,0 +1,105 @@
+#ifndef AFINA_COROUTINE_CHANNEL_H
+#define AFINA_COROUTINE_CHANNEL_H
+
+#include <cstddef>
+#include <deque>
+#include <stdexcept>
+#include <utility>
+
+#include <afina/coroutine/Engine.h>
+#include <afina/coroutine/Sync.h>
+
+namespace Afina {
+namespace Coroutine {
+
+/**
+ * # Bounded queue between routines
+ * Sender is parked while channel is full, receiver while it is empty. Once channel is closed senders fail,
+ * receivers get what is left and then fail as well. Not threadsafe, see WaitList
+ */
+template <typename T> class Channel {
+public:
+    Channel(Engine &engine, std::size_t capacity)
+        : _capacity(capacity), _closed(false), _senders(engine), _receivers(engine) {
+        if (capacity == 0) {
+            throw std::runtime_error("Channel must have room for at least one item");
+        }
+    }
+
+    /**
+     * Puts value into channel, waiting for room if needed. Returns false if channel is closed
+     */
+    bool send(T value) {
+        while (!_closed && _items.size() >= _capacity) {
+            _senders.wait();
+        }
+        if (_closed) {
+            return false;
+        }
+
+        _items.push_back(std::move(value));
+        _receivers.wake_one();
+        return true;
+    }
+
+    /**
+     * Same as send, but returns false instead of waiting
+     */
+    bool try_send(T value) {
+        if (_closed || _items.size() >= _capacity) {
+            return false;
+        }
+
+        _items.push_back(std::move(value));
+        _receivers.wake_one();
+        return true;
+    }
+
+    /**
+     * Takes value from channel, waiting for it if needed. Returns false if channel is closed and empty
+     */
+    bool recv(T &value) {
+        while (!_closed && _items.empty()) {
+            _receivers.wait();
+        }
+        return try_recv(value);
+    }
+
+    /**
+     * Same as recv, but returns false instead of waiting
+     */
+    bool try_recv(T &value) {
+        if (_items.empty()) {
+            return false;
+        }
+
+        value = std::move(_items.front());
+        _items.pop_front();
+        _senders.wake_one();
+        return true;
+    }
+
+    /**
+     * Wakes up everyone waiting, no values could be sent anymore
+     */
+    void close() {
+        _closed = true;
+        _senders.wake_all();
+        _receivers.wake_all();
+    }
+
+    std::size_t size() const { return _items.size(); }
+    bool closed() const { return _closed; }
+
+private:
+    const std::size_t _capacity;
+    bool _closed;
+    std::deque<T> _items;
+    WaitList _senders;
+    WaitList _receivers;
+};
+
+} // namespace Coroutine
+} // namespace Afina
+
+#endif // AFINA_COROUTINE_CHANNEL_H
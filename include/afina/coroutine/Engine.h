@@ -1,11 +1,15 @@
 #ifndef AFINA_COROUTINE_ENGINE_H
 #define AFINA_COROUTINE_ENGINE_H
 
+#include <cstddef>
 #include <cstdint>
+#include <functional>
 #include <iostream>
 #include <map>
 #include <setjmp.h>
 #include <tuple>
+#include <utility>
+#include <vector>
 
 namespace Afina {
 namespace Coroutine {
@@ -13,8 +17,27 @@ namespace Coroutine {
 /**
  * # Entry point of coroutine library
  * Allows to run coroutine and schedule its execution. Not threadsafe
+ *
+ * Engine supports two ways to keep coroutine stacks:
+ * - StackMode::kCopy: every routine runs on the stack of the thread that called start() and on each switch
+ *   the used part of the stack is copied out of/into a heap buffer. Memory per routine is as small as its
+ *   real stack usage, but switch cost grows with the stack depth
+ * - StackMode::kSeparate: every routine gets its own mmap'd stack with a guard page below it and switch is
+ *   just a swap of callee saved registers. Stack overflow hits the guard page instead of corrupting memory,
+ *   memory is reserved by stack_size per routine but committed only as the stack is touched
+ *
+ * Routine waiting for some event, such as socket readiness, blocks itself and is not scheduled until someone
+ * unblocks it. Once all routines are blocked engine calls unblocker, which is expected to wait for events and
+ * unblock routines interested in them, e.g epoll_wait loop
+ *
+ * With separate stacks routine isn't tied to the engine which started it: ready routine could be detached from
+ * one engine and adopted by another one running in some other thread, which is how several engines share load.
+ * Such routine must not rely on the engine it was started in, running() gives the one executing it now
  */
 class Engine final {
+public:
+    enum class StackMode { kCopy, kSeparate };
+
 private:
     /**
      * A single coroutine instance which could be scheduled for execution
@@ -28,12 +51,21 @@ private:
         // coroutine stack end address
         char *Hight = nullptr;
 
-        // coroutine stack copy buffer
+        // coroutine stack copy buffer and its capacity
         std::tuple<char *, uint32_t> Stack = std::make_tuple(nullptr, 0);
 
         // Saved coroutine context (registers)
         jmp_buf Environment;
 
+        // StackMode::kSeparate: mapping with the routine stack, guard page included
+        char *Memory = nullptr;
+
+        // StackMode::kSeparate: saved machine state of the suspended routine
+        void *Machine = nullptr;
+
+        // Routine is in the "blocked" list rather than in "alive" one
+        bool Blocked = false;
+
         // To include routine in the different lists, such as "alive", "blocked", e.t.c
         struct context *prev = nullptr;
         struct context *next = nullptr;
@@ -54,11 +86,46 @@ private:
      */
     context *alive;
 
+    /**
+     * List of routines waiting to be unblocked
+     */
+    context *blocked;
+
     /**
      * Context to be returned finally
      */
     context *idle_ctx;
 
+    /**
+     * How routine stacks are kept
+     */
+    const StackMode mode;
+
+    /**
+     * StackMode::kSeparate: size of each routine stack, without guard page
+     */
+    const std::size_t stack_size;
+
+    /**
+     * StackMode::kSeparate: stacks of finished routines, kept to avoid mmap on each run()
+     */
+    std::vector<char *> free_stacks;
+
+    /**
+     * StackMode::kSeparate: finished routine whose stack is still in use until switch completes
+     */
+    context *zombie;
+
+    /**
+     * StackMode::kSeparate: routine that called run() and waits for the new one to take its arguments
+     */
+    context *spawner;
+
+    /**
+     * Called by the idle context when all routines are blocked
+     */
+    std::function<void()> unblocker;
+
 protected:
     /**
      * Save stack of the current coroutine in the given context
@@ -70,15 +137,55 @@ protected:
      */
     void Restore(context &ctx);
 
+    /**
+     * Second half of Restore: copies the stack back and jumps into it. Must be called from the frame below
+     * the restored area, so that copying doesn't overwrite it
+     */
+    void Jump(context &ctx);
+
     /**
      * Suspend current coroutine execution and execute given context
      */
-    // void Enter(context& ctx);
+    void Enter(context &ctx);
+
+    /**
+     * StackMode::kSeparate: creates routine on its own stack and runs entry(arg) until it calls Suspend()
+     */
+    context *Spawn(void (*entry)(void *), void *arg);
+
+    /**
+     * StackMode::kSeparate: passes control from just spawned routine back to the one which has called run()
+     */
+    void Suspend();
+
+    /**
+     * StackMode::kSeparate: removes current routine and passes control to the idle context, never returns
+     */
+    void Finish();
+
+    /**
+     * StackMode::kSeparate: saves state to the "from" context and resumes "to"
+     */
+    void Switch(context &from, context &to);
+
+    /**
+     * StackMode::kSeparate: frees routine and gives its stack back to the free list
+     */
+    void Release(context *ctx);
+
+    /**
+     * Makes given engine the one running in the calling thread, returns previous one
+     */
+    static Engine *Activate(Engine *engine);
 
 public:
-    Engine() : StackBottom(0), cur_routine(nullptr), alive(nullptr) {}
+    Engine(StackMode mode = StackMode::kCopy, std::size_t stack_size = 256 * 1024,
+           std::function<void()> unblocker = nullptr)
+        : StackBottom(0), cur_routine(nullptr), alive(nullptr), blocked(nullptr), idle_ctx(nullptr), mode(mode),
+          stack_size(stack_size), zombie(nullptr), spawner(nullptr), unblocker(std::move(unblocker)) {}
     Engine(Engine &&) = delete;
     Engine(const Engine &) = delete;
+    ~Engine();
 
     /**
      * Gives up current routine execution and let engine to schedule other one. It is not defined when
@@ -99,12 +206,50 @@ public:
      */
     void sched(void *routine);
 
+    /**
+     * Moves given routine, current one if nullptr, to the blocked list, so that yield doesn't select it
+     * anymore. If current routine gets blocked, control passes to some other alive routine or to the idle
+     * context if there are none
+     */
+    void block(void *routine = nullptr);
+
+    /**
+     * Returns blocked routine back to the alive list, it will get control on some later yield. Does nothing
+     * if routine is not blocked
+     */
+    void unblock(void *routine);
+
+    /**
+     * Routine which is running now, nullptr if called outside of coroutines
+     */
+    void *current() const { return cur_routine; }
+
+    /**
+     * StackMode::kSeparate: takes some alive routine out of this engine, so that another engine could adopt it.
+     * Current routine is never taken and engine always keeps at least one more alive routine for itself,
+     * returns nullptr if there is nothing to give away
+     */
+    void *detach();
+
+    /**
+     * StackMode::kSeparate: adds routine detached from other engine, possibly running in other thread, to the
+     * alive list. Both engines must use the same stack size
+     */
+    void adopt(void *routine);
+
+    /**
+     * Engine started in the calling thread, nullptr if there is none. Never inlined, so that routine which
+     * moves between threads doesn't see a cached value
+     */
+    static Engine *running();
+
     /**
      * Entry point into the engine. Prepare all internal mechanics and starts given function which is
      * considered as main.
      *
      * Once control returns back to caller of start all coroutines are done execution, in other words,
-     * this function doesn't return control until all coroutines are done.
+     * this function doesn't return control until all coroutines are done. Routines which are still blocked
+     * when there is no unblocker are abandoned
      *
      * @param pointer to the main coroutine
      * @param arguments to be passed to the main coroutine
@@ -113,21 +258,32 @@ public:
         // To acquire stack begin, create variable on stack and remember its address
         char StackStartsHere;
         this->StackBottom = &StackStartsHere;
+        idle_ctx = new context();
+        Engine *outer = Activate(this);
 
         // Start routine execution
-        void *pc = run(main, std::forward<Ta>(args)...);
-        idle_ctx = new context();
+        run(main, std::forward<Ta>(args)...);
 
-        if (setjmp(idle_ctx->Environment) > 0) {
-            // Here: correct finish of the coroutine section
-            yield();
-        } else if (pc != nullptr) {
+        // Idle context gets control back each time some routine is done or there is nothing to run. With copied
+        // stacks that happens through longjmp right here
+        if (mode == StackMode::kCopy && setjmp(idle_ctx->Environment) == 0) {
             Store(*idle_ctx);
-            sched(pc);
+        }
+
+        while (true) {
+            if (alive != nullptr) {
+                sched(alive);
+            } else if (blocked != nullptr && unblocker) {
+                unblocker();
+            } else {
+                break;
+            }
         }
 
         // Shutdown runtime
+        Activate(outer);
         delete idle_ctx;
+        idle_ctx = nullptr;
         this->StackBottom = 0;
     }
 
@@ -141,6 +297,13 @@ public:
             return nullptr;
         }
 
+        if (mode == StackMode::kSeparate) {
+            // Arguments are references to the caller frame, new routine copies them to its own stack before
+            // run() returns
+            Launch<Ta...> launch{this, func, std::forward_as_tuple(std::forward<Ta>(args)...)};
+            return Spawn(&Launch<Ta...>::Entry, &launch);
+        }
+
         // New coroutine context that carries around all information enough to call function
         context *pc = new context();
 
@@ -166,14 +329,14 @@ public:
                 pc->next->prev = pc->prev;
             }
 
-            if (alive == cur_routine) {
+            if (alive == pc) {
                 alive = alive->next;
             }
 
             // current coroutine finished, and the pointer is not relevant now
             cur_routine = nullptr;
             pc->prev = pc->next = nullptr;
-            delete std::get<0>(pc->Stack);
+            delete[] std::get<0>(pc->Stack);
             delete pc;
 
             // We cannot return here, as this function "returned" once already, so here we must select some other
@@ -196,6 +359,39 @@ public:
 
         return pc;
     }
+
+private:
+    // Compile time list of argument indices, to unpack arguments tuple into a call
+    template <std::size_t... I> struct Indices {};
+    template <std::size_t N, std::size_t... I> struct MakeIndices : MakeIndices<N - 1, N - 1, I...> {};
+    template <std::size_t... I> struct MakeIndices<0, I...> {
+        typedef Indices<I...> type;
+    };
+
+    // StackMode::kSeparate: everything new routine needs to start, lives on the stack of run() caller
+    template <typename... Ta> struct Launch {
+        Engine *engine;
+        void (*func)(Ta...);
+        std::tuple<Ta &&...> args;
+
+        static void Entry(void *arg) {
+            Launch *launch = static_cast<Launch *>(arg);
+            Engine *engine = launch->engine;
+            void (*func)(Ta...) = launch->func;
+            std::tuple<Ta...> args(std::move(launch->args));
+
+            // Launch is gone once run() returns, from now on only own copies are used
+            engine->Suspend();
+            Call(func, args, typename MakeIndices<sizeof...(Ta)>::type());
+
+            // Routine could be adopted by other engine meanwhile
+            Engine::running()->Finish();
+        }
+
+        template <std::size_t... I> static void Call(void (*func)(Ta...), std::tuple<Ta...> &args, Indices<I...>) {
+            func(std::forward<Ta>(std::get<I>(args))...);
+        }
+    };
 };
 
 } // namespace Coroutine
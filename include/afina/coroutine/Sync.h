@@ -0,0 +1,115 @@
+#ifndef AFINA_COROUTINE_SYNC_H
+#define AFINA_COROUTINE_SYNC_H
+
+#include <cstddef>
+#include <deque>
+
+#include <afina/coroutine/Engine.h>
+
+namespace Afina {
+namespace Coroutine {
+
+/**
+ * # Routines waiting for some condition
+ * Building block of coroutine synchronization primitives. Waiting routine is moved to the blocked list of the
+ * engine, so that only this routine stops while others on the same thread keep running, and gets back to the
+ * alive list once woken up.
+ *
+ * Same as Engine, not threadsafe: every routine using the list must run in the given engine. Routines are woken
+ * up in the order they started to wait
+ */
+class WaitList {
+public:
+    explicit WaitList(Engine &engine) : _engine(engine) {}
+    WaitList(const WaitList &) = delete;
+    WaitList &operator=(const WaitList &) = delete;
+
+    /**
+     * Blocks current routine until someone wakes it up. Throws if called outside of routine, as there is
+     * nobody to block and nobody else could change the condition
+     */
+    void wait();
+
+    /**
+     * Wakes up routine waiting for the longest time, returns false if there are no waiters
+     */
+    bool wake_one();
+
+    /**
+     * Wakes up all routines
+     */
+    void wake_all();
+
+    bool empty() const { return _routines.empty(); }
+
+private:
+    Engine &_engine;
+    std::deque<void *> _routines;
+};
+
+/**
+ * # Mutual exclusion for routines
+ * Routine that finds mutex locked is parked until unlock, the thread keeps running other routines. Not fair:
+ * the first routine calling lock() after unlock gets the mutex, even if others are waiting. Could be locked
+ * outside of routines as long as it is free
+ */
+class Mutex {
+public:
+    explicit Mutex(Engine &engine) : _locked(false), _waiters(engine) {}
+
+    void lock();
+    bool try_lock();
+    void unlock();
+
+private:
+    bool _locked;
+    WaitList _waiters;
+};
+
+/**
+ * # Condition variable for routines
+ * Same contract as std::condition_variable_any: wait() atomically (in terms of routines) unlocks the mutex and
+ * parks routine until notification, mutex is locked again before wait() returns
+ */
+class CondVar {
+public:
+    explicit CondVar(Engine &engine) : _waiters(engine) {}
+
+    void wait(Mutex &mutex);
+
+    template <typename Predicate> void wait(Mutex &mutex, Predicate pred) {
+        while (!pred()) {
+            wait(mutex);
+        }
+    }
+
+    void notify_one() { _waiters.wake_one(); }
+    void notify_all() { _waiters.wake_all(); }
+
+private:
+    WaitList _waiters;
+};
+
+/**
+ * # Counting semaphore for routines
+ * acquire() parks routine while there are no permits left
+ */
+class Semaphore {
+public:
+    Semaphore(Engine &engine, std::size_t permits) : _permits(permits), _waiters(engine) {}
+
+    void acquire();
+    bool try_acquire();
+    void release();
+
+    std::size_t available() const { return _permits; }
+
+private:
+    std::size_t _permits;
+    WaitList _waiters;
+};
+
+} // namespace Coroutine
+} // namespace Afina
+
+#endif // AFINA_COROUTINE_SYNC_H
@@ -20,6 +20,7 @@ namespace Execute {
  */
 class Add : public InsertCommand {
 public:
+    Add() {}
     Add(const std::string &key, uint32_t flags, int32_t expire) : InsertCommand(key, flags, expire) {}
     ~Add() {}
 
@@ -5,6 +5,7 @@
 #include <vector>
 
 #include "Command.h"
+#include "KeyView.h"
 
 namespace Afina {
 namespace Execute {
@@ -34,15 +35,43 @@ namespace Execute {
  */
 class Get : public Command {
 public:
-    Get(const std::vector<std::string> &keys) : _keys(keys) {}
+    /**
+     * Command owns copies of the given keys
+     */
+    Get(const std::vector<std::string> &keys);
+
+    /**
+     * Command refers to the given keys, both array and keys memory must outlive the command
+     */
+    Get(const KeyView *keys, std::size_t count) : _views(keys), _count(count) {}
     ~Get() {}
 
-    inline const std::vector<std::string> &keys() const { return _keys; }
+    /**
+     * Prepares command to be executed once again for the given keys, which it refers to just like the command
+     * constructed from them
+     */
+    void Assign(const KeyView *keys, std::size_t count) {
+        _views = keys;
+        _count = count;
+        _keys.clear();
+        _owned_views.clear();
+    }
+
+    std::vector<std::string> keys() const;
 
     void Execute(Storage &storage, const std::string &args, std::string &out) override;
 
 private:
+    Get(const Get &) = delete;
+    Get &operator=(const Get &) = delete;
+
+    // Keys being retrieved
+    const KeyView *_views;
+    std::size_t _count;
+
+    // Storage for the keys if command owns them
     std::vector<std::string> _keys;
+    std::vector<KeyView> _owned_views;
 };
 
 } // namespace Execute
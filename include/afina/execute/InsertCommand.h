@@ -1,6 +1,7 @@
 #ifndef AFINA_EXECUTE_INSERT_COMMAND_H
 #define AFINA_EXECUTE_INSERT_COMMAND_H
 
+#include <cstddef>
 #include <cstdint>
 #include <string>
 
@@ -15,17 +16,27 @@ namespace Execute {
  */
 class InsertCommand : public Command {
 public:
+    InsertCommand() : _flags(0), _expire(0) {}
     InsertCommand(const std::string &key, uint32_t flags, int32_t expire) : _key(key), _flags(flags), _expire(expire) {}
     ~InsertCommand() {}
 
+    /**
+     * Prepares command to be executed once again for another item, memory taken by the key is reused
+     */
+    void Assign(const char *key, std::size_t size, uint32_t flags, int32_t expire) {
+        _key.assign(key, size);
+        _flags = flags;
+        _expire = expire;
+    }
+
     inline const std::string &key() const { return _key; }
     inline const uint32_t flags() const { return _flags; }
     inline const int32_t expire() const { return _expire; }
 
 protected:
-    const std::string _key;
-    const uint32_t _flags;
-    const int32_t _expire;
+    std::string _key;
+    uint32_t _flags;
+    int32_t _expire;
 };
 
 } // namespace Execute
@@ -0,0 +1,21 @@
+#ifndef AFINA_EXECUTE_KEY_VIEW_H
+#define AFINA_EXECUTE_KEY_VIEW_H
+
+#include <cstddef>
+
+namespace Afina {
+namespace Execute {
+
+/**
+ * # Key command doesn't own
+ * Points into the memory command was parsed from, so that memory must stay unchanged until command is executed
+ */
+struct KeyView {
+    const char *data;
+    std::size_t size;
+};
+
+} // namespace Execute
+} // namespace Afina
+
+#endif // AFINA_EXECUTE_KEY_VIEW_H
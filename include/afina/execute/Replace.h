@@ -21,6 +21,7 @@ namespace Execute {
  */
 class Replace : public InsertCommand {
 public:
+    Replace() {}
     Replace(const std::string &key, uint32_t flags, int32_t expire) : InsertCommand(key, flags, expire) {}
     ~Replace() {}
 
@@ -1,6 +1,7 @@
 #ifndef AFINA_EXECUTE_STATS_H
 #define AFINA_EXECUTE_STATS_H
 
+#include <cstddef>
 #include <string>
 
 #include "Command.h"
@@ -8,11 +9,36 @@
 namespace Afina {
 namespace Execute {
 
+/**
+ * # Report server statistics
+ * Writes set of "STAT <name> <value>" lines followed by "END". Optional argument selects group of
+ * statistics to report:
+ * - none: general purpose counters, such as hits/misses, connections, memory usage
+ * - "items": per item class counters, there is a single class as storage has no slabs
+ * - "slabs": per slab class counters, single class as well
+ * - "settings": server configuration
+ * - "latency": per command percentiles of time from the first byte read to the response sent
+ * - any group registered by Metrics::AddReport, for example "executor" of the thread pool
+ *
+ * Any other group is reported as "ERROR"
+ */
 class Stats : public Command {
 public:
     Stats() {}
+    Stats(const std::string &group) : _group(group) {}
     ~Stats() {}
+
+    inline const std::string &group() const { return _group; }
+
+    /**
+     * Prepares command to be executed once again for another group
+     */
+    void Assign(const char *group, std::size_t size) { _group.assign(group, size); }
+
     void Execute(Storage &storage, const std::string &args, std::string &out) override;
+
+private:
+    std::string _group;
 };
 
 } // namespace Execute
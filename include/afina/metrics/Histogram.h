@@ -0,0 +1,119 @@
+#ifndef AFINA_METRICS_HISTOGRAM_H
+#define AFINA_METRICS_HISTOGRAM_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace Afina {
+namespace Metrics {
+
+/**
+ * # Log-linear histogram
+ * HDR style histogram of non-negative integer values: each power of two range is split into kSubBuckets linear
+ * buckets, so relative error of any reported value is below 1 / kSubBuckets (~3%). Values below 2 * kSubBuckets
+ * are exact, values above kMaxValue are clamped.
+ *
+ * Only one thread is allowed to Record, any thread could read it concurrently. Record is a couple of bit
+ * operations plus relaxed load/store, i.e no atomic RMW.
+ */
+class Histogram {
+public:
+    static constexpr unsigned kSubBucketBits = 5;
+    static constexpr uint64_t kSubBuckets = uint64_t(1) << kSubBucketBits;
+
+    // Highest trackable value: 2^36 - 1, i.e ~68 seconds if values are nanoseconds
+    static constexpr unsigned kMaxBits = 36;
+    static constexpr uint64_t kMaxValue = (uint64_t(1) << kMaxBits) - 1;
+
+    // 2 * kSubBuckets exact buckets and then kSubBuckets for each power of two above
+    static constexpr std::size_t kBuckets = 2 * kSubBuckets + (kMaxBits - kSubBucketBits - 1) * kSubBuckets;
+
+    Histogram() { Reset(); }
+
+    /**
+     * Adds value to the histogram, must be called by the owning thread only
+     */
+    inline void Record(uint64_t value) {
+        if (value > kMaxValue) {
+            value = kMaxValue;
+        }
+
+        std::atomic<uint64_t> &c = _counts[BucketOf(value)];
+        c.store(c.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        _sum.store(_sum.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+
+    /**
+     * Adds value that was measured by a client which sends next request only after response to the previous one
+     * has arrived, while it expected to send them every expected_interval. Such client doesn't measure requests
+     * it would have sent during a stall, so they are added as well: value - interval, value - 2 * interval and so
+     * on down to the interval. Zero interval means no correction. Must be called by the owning thread
+     */
+    void RecordCorrected(uint64_t value, uint64_t expected_interval);
+
+    /**
+     * Adds all values of the other histogram into this one. Must be called by the owning thread
+     */
+    void Merge(const Histogram &other);
+
+    /**
+     * Drops all recorded values. Must be called by the owning thread
+     */
+    void Reset();
+
+    /**
+     * Total number of recorded values
+     */
+    uint64_t Count() const;
+
+    /**
+     * Mean of recorded values, exact
+     */
+    double Mean() const;
+
+    /**
+     * Returns value below which given percent (0..100) of recorded values fall. Returned value is the
+     * highest value of the bucket, so it never understates. Zero if histogram is empty
+     */
+    uint64_t Percentile(double percent) const;
+
+    /**
+     * Highest recorded value, up to the bucket precision
+     */
+    uint64_t Max() const;
+
+    /**
+     * Index of the bucket holding given value
+     */
+    static inline std::size_t BucketOf(uint64_t value) {
+        if (value < 2 * kSubBuckets) {
+            return value;
+        }
+
+        // Position of the highest bit, at least kSubBucketBits + 1 here
+        unsigned msb = 63 - __builtin_clzll(value);
+        unsigned shift = msb - kSubBucketBits;
+        return 2 * kSubBuckets + (shift - 1) * kSubBuckets + ((value >> shift) - kSubBuckets);
+    }
+
+    /**
+     * Highest value falling into the given bucket
+     */
+    static uint64_t BucketHighest(std::size_t bucket);
+
+private:
+    Histogram(const Histogram &) = delete;
+    Histogram &operator=(const Histogram &) = delete;
+
+    // Number of recorded values per bucket
+    std::atomic<uint64_t> _counts[kBuckets];
+
+    // Sum of all recorded values
+    std::atomic<uint64_t> _sum;
+};
+
+} // namespace Metrics
+} // namespace Afina
+
+#endif // AFINA_METRICS_HISTOGRAM_H
@@ -0,0 +1,102 @@
+#ifndef AFINA_METRICS_LATENCY_H
+#define AFINA_METRICS_LATENCY_H
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include <afina/concurrency/ThreadLocal.h>
+#include <afina/metrics/Histogram.h>
+
+namespace Afina {
+namespace Metrics {
+
+/**
+ * # Cheap monotonic clock
+ * Reads TSC where available: std::chrono::steady_clock goes through clock_gettime and is several times slower,
+ * which matters as every request takes a timestamp. Ticks are converted to nanoseconds using ratio measured
+ * once at startup, TSC is expected to be invariant (constant_tsc, nonstop_tsc)
+ */
+class Clock {
+public:
+    static inline uint64_t Now() {
+#if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+#endif
+    }
+
+    /**
+     * Converts difference between two Now() readings into nanoseconds
+     */
+    static inline uint64_t ToNanoseconds(uint64_t ticks) { return uint64_t(ticks * _ns_per_tick); }
+
+private:
+    // Ratio measured on startup
+    static const double _ns_per_tick;
+};
+
+/**
+ * Request types latency is tracked for
+ */
+enum Operation : uint16_t {
+    kOpGet,
+    kOpSet,
+    kOpAdd,
+    kOpAppend,
+    kOpReplace,
+    kOpStats,
+    kOpOther,
+
+    // Must be the last one
+    kOperationCount
+};
+
+/**
+ * Maps command name, as parser returns it, into operation
+ */
+Operation OperationByName(const std::string &name);
+
+/**
+ * Name of the operation as reported by "stats latency"
+ */
+const char *OperationName(Operation op);
+
+/**
+ * Latency histograms of a single thread, one per operation, in nanoseconds
+ */
+struct LatencyShard {
+    Histogram histograms[kOperationCount];
+};
+
+/**
+ * Returns storage of all per thread histograms
+ */
+inline Concurrency::ThreadLocal<LatencyShard> &LatencyShards() {
+    static Concurrency::ThreadLocal<LatencyShard> *shards = new Concurrency::ThreadLocal<LatencyShard>();
+    return *shards;
+}
+
+/**
+ * Records time passed between two Clock::Now() readings as latency of the operation
+ */
+inline void RecordLatency(Operation op, uint64_t start, uint64_t end) {
+    LatencyShards().get().histograms[op].Record(Clock::ToNanoseconds(end - start));
+}
+
+/**
+ * Merges histograms of all threads for the given operation into the result
+ */
+void CollectLatency(Operation op, Histogram &result);
+
+} // namespace Metrics
+} // namespace Afina
+
+#endif // AFINA_METRICS_LATENCY_H
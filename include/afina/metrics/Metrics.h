@@ -0,0 +1,148 @@
+#ifndef AFINA_METRICS_METRICS_H
+#define AFINA_METRICS_METRICS_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <afina/concurrency/ThreadLocal.h>
+
+namespace Afina {
+namespace Metrics {
+
+/**
+ * # Server wide counters
+ * Every counter is a sum over all threads ever touched it. Gauges, such as curr_connections, are
+ * counters as well: thread that opens connection adds one, thread that closes it subtracts one.
+ */
+enum Counter : uint16_t {
+    // Commands processed, per command name
+    kCmdGet,
+    kCmdSet,
+    kCmdAdd,
+    kCmdAppend,
+    kCmdReplace,
+    kCmdStats,
+
+    // Results of retrival requests, per key
+    kGetHits,
+    kGetMisses,
+
+    // Number of successful storage commands
+    kTotalItems,
+
+    // Network
+    kBytesRead,
+    kBytesWritten,
+    kCurrConnections,
+    kTotalConnections,
+    kRejectedConnections,
+
+    // Must be the last one
+    kCounterCount
+};
+
+/**
+ * Counters of a single thread. Only owning thread writes it, so increment is just a load and a store, no
+ * atomic RMW is required. Atomics are there to let stats readers see values without data race
+ */
+struct Shard {
+    std::atomic<uint64_t> counters[kCounterCount];
+
+    // Keep shards of different threads in the different cache lines
+    char padding[64];
+
+    Shard() {
+        for (auto &c : counters) {
+            c.store(0, std::memory_order_relaxed);
+        }
+    }
+};
+
+/**
+ * Returns storage of all per thread counters
+ */
+inline Concurrency::ThreadLocal<Shard> &Shards() {
+    static Concurrency::ThreadLocal<Shard> *shards = new Concurrency::ThreadLocal<Shard>();
+    return *shards;
+}
+
+/**
+ * Adds delta to the given counter of the calling thread. Never contended, costs the same as
+ * an increment of plain variable
+ */
+inline void Add(Counter counter, uint64_t delta = 1) {
+    std::atomic<uint64_t> &c = Shards().get().counters[counter];
+    c.store(c.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+}
+
+/**
+ * Subtracts delta from the given counter of the calling thread, useful for gauges
+ */
+inline void Sub(Counter counter, uint64_t delta = 1) { Add(counter, ~delta + 1); }
+
+/**
+ * Sum of all threads counters
+ */
+struct Snapshot {
+    uint64_t counters[kCounterCount];
+
+    inline uint64_t operator[](Counter counter) const { return counters[counter]; }
+};
+
+/**
+ * Merges counters of all threads. It is not an atomic snapshot: counters are read one by one
+ * while other threads keep updating them
+ */
+void Collect(Snapshot &snapshot);
+
+/**
+ * Seconds elapsed since the process start
+ */
+uint64_t Uptime();
+
+/**
+ * Registers configuration parameter to be reported by "stats settings". Setting with the same name
+ * gets overwritten
+ */
+void SetSetting(const std::string &name, const std::string &value);
+
+/**
+ * Returns value of the configuration parameter or empty string if there is no such
+ */
+std::string GetSetting(const std::string &name);
+
+/**
+ * Returns all registered configuration parameters in the registration order
+ */
+std::vector<std::pair<std::string, std::string>> Settings();
+
+/**
+ * Callback appending name/value pairs describing state of some component
+ */
+using Report = std::function<void(std::vector<std::pair<std::string, std::string>> &)>;
+
+/**
+ * Registers report to be included into "stats <group>". Several reports could share the same group, they are
+ * called in the registration order. Returns id to be passed to RemoveReport
+ */
+int AddReport(const std::string &group, Report report);
+
+/**
+ * Unregisters report. Once call returns report is not running and won't be called anymore, so it is safe to
+ * destroy whatever it refers to
+ */
+void RemoveReport(int id);
+
+/**
+ * Calls all reports of the group. Returns false if there are no such
+ */
+bool CollectReport(const std::string &group, std::vector<std::pair<std::string, std::string>> &values);
+
+} // namespace Metrics
+} // namespace Afina
+
+#endif // AFINA_METRICS_METRICS_H
@@ -1,9 +1,13 @@
 #ifndef AFINA_NETWORK_SERVER_H
 #define AFINA_NETWORK_SERVER_H
 
+#include <cstdint>
 #include <memory>
+#include <string>
 #include <vector>
 
+#include <sys/socket.h>
+
 namespace Afina {
 class Storage;
 namespace Logging {
@@ -17,10 +21,35 @@ namespace Network {
  */
 class Server {
 public:
+    /**
+     * Network settings besides the ones passed to Start. Every server takes those that apply to it
+     */
+    struct Config {
+        // IPv4 address to listen on
+        std::string address = "0.0.0.0";
+
+        // Connections kernel keeps until they are accepted, kernel caps it by net.core.somaxconn
+        int backlog = SOMAXCONN;
+
+        // Blocking servers: connection that sent nothing for that long is closed, 0 means never
+        uint32_t read_timeout_ms = 5000;
+
+        // Blocking servers: thread pool serving connections, see Concurrency::Executor
+        uint32_t pool_min = 2;
+        uint32_t pool_max = 64;
+        uint32_t pool_queue = 64;
+        uint32_t pool_idle_ms = 5000;
+    };
+
     Server(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Afina::Logging::Service> pl)
         : pStorage(ps), pLogging(pl) {}
     virtual ~Server() {}
 
+    /**
+     * Replaces default settings, must be called before Start
+     */
+    virtual void Configure(const Config &c) { config = c; }
+
     /**
      * Starts network service. After method returns process should
      * listen on the given interface/port pair to process  incomming
@@ -45,6 +74,11 @@ public:
     virtual void Join() = 0;
 
 protected:
+    /**
+     * Settings server is started with
+     */
+    Config config;
+
     /**
      * Instance of backing storeage on which current server should execute
      * each command
@@ -1,29 +1,65 @@
 #include <afina/concurrency/Executor.h>
 
+#include <cstdlib>
+#include <new>
+
 namespace Afina {
 namespace Concurrency {
 
-void perform(Executor *executor);
+namespace {
 
-bool Executor::check_running() {
-    std::unique_lock<std::mutex> _lock(state_mutex);
-    return state == State::kRun;
+// Worker slot of the current thread, if it belongs to some pool
+thread_local void *current_worker = nullptr;
+
+// Cheap per thread random numbers to select steal victim
+uint32_t next_random() {
+    static thread_local uint32_t x = uint32_t(std::hash<std::thread::id>()(std::this_thread::get_id())) | 1;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return x;
 }
 
-bool Executor::check_tasks_left() {
-    std::unique_lock<std::mutex> _lock(state_mutex);
-    return !tasks.empty();
+// Share of each priority lane in weighted round robin, by Executor::Priority
+const int lane_weights[Executor::kPriorities] = {8, 4, 1};
+
+} // namespace
+
+void perform(Executor *executor, Executor::Worker *self);
+
+const int Executor::kPriorities;
+
+Executor::Executor(int th_min, int th_max, int q_max, int wait_max)
+    : low_watermark(th_min), high_watermark(th_max), max_queue_size(q_max), idle_time(wait_max), queued(0),
+      sleeping(0), live_workers(0), free_workers(0), queue_depth_max(0), rejected(0), expired(0), spawned(0),
+      retired(0), state(State::kStopped) {
+    workers.reserve(high_watermark);
+    for (int i = 0; i < high_watermark; i++) {
+        workers.emplace_back(new Worker(this));
+    }
 }
 
+void *Executor::Worker::operator new(std::size_t size) {
+    void *p = nullptr;
+    if (posix_memalign(&p, alignof(Worker), size) != 0) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void Executor::Worker::operator delete(void *p) { free(p); }
+
 void Executor::Start() {
     std::unique_lock<std::mutex> _lock(state_mutex);
 
-    live_workers = low_watermark;
-    free_workers = low_watermark;
-
     state = State::kRun;
     for (int i = 0; i < low_watermark; ++i) {
-        auto worker = std::thread(perform, this);
+        live_workers += 1;
+        free_workers += 1;
+        spawned += 1;
+
+        workers[i]->used = true;
+        auto worker = std::thread(perform, this, workers[i].get());
         worker.detach();
     }
 }
@@ -33,8 +69,8 @@ void Executor::Stop(bool await) {
         std::unique_lock<std::mutex> _lock(state_mutex);
         if (state == State::kRun) {
             state = State::kStopping;
-            empty_condition.notify_one();
         }
+        empty_condition.notify_all();
     }
 
     if (await) {
@@ -42,78 +78,249 @@ void Executor::Stop(bool await) {
         while (live_workers > 0) {
             finish_condition.wait(_lock);
         }
+        state = State::kStopped;
     }
 }
 
-void Executor::try_create_worker() {
-    if (free_workers == 0 && live_workers < high_watermark) {
-        live_workers += 1;
-        free_workers += 1;
+bool Executor::enqueue(Task &&task, Priority priority, Deadline deadline, Task &&expired) {
+    if (state.load() != State::kRun) {
+        rejected.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
 
-        auto worker = std::thread(perform, this);
-        worker.detach();
+    // State is checked once more after the task is counted: pool stopping meanwhile either is seen here or sees
+    // the task in perform and doesn't let the last worker go, see there
+    int depth = queued.fetch_add(1) + 1;
+    if (depth > max_queue_size || state.load() != State::kRun) {
+        queued.fetch_sub(1);
+        rejected.fetch_add(1, std::memory_order_relaxed);
+        return false;
     }
-}
 
-void perform(Executor *executor) {
-    std::chrono::time_point<std::chrono::high_resolution_clock> wait_limit;
+    int depth_max = queue_depth_max.load(std::memory_order_relaxed);
+    while (depth > depth_max && !queue_depth_max.compare_exchange_weak(depth_max, depth, std::memory_order_relaxed)) {
+    }
 
-    while (executor->check_running() || executor->check_tasks_left()) {
-        std::function<void()> task;
-        {
-            std::unique_lock<std::mutex> _lock(executor->state_mutex);
+    // No free worker to pick the task up
+    if (queued.load() > free_workers.load()) {
+        std::unique_lock<std::mutex> _lock(state_mutex);
+        try_create_worker();
+    }
 
-            wait_limit = std::chrono::high_resolution_clock::now() + executor->idle_time;
+    Node *node = new (NodePool::Allocate())
+        Node(std::move(task), priority, deadline, std::move(expired), Metrics::Clock::Now());
 
-            // wait for new task
-            while (executor->tasks.empty() && std::chrono::high_resolution_clock::now() < wait_limit) {
-                // if thread pool is stopping
-                if (executor->state != Executor::State::kRun) {
-                    break;
-                }
-                executor->empty_condition.wait_until(_lock, wait_limit);
-            }
+    // Submitted by one of our workers: keep it local, someone will steal it if worker is busy for too long
+    Worker *self = static_cast<Worker *>(current_worker);
+    if (priority != Priority::kNormal || self == nullptr || self->owner != this || !self->tasks.push(node)) {
+        Lane &lane = lanes[int(priority)];
+        std::unique_lock<std::mutex> _lock(inject_mutex);
+        if (lane.tail == nullptr) {
+            lane.head = node;
+        } else {
+            lane.tail->next = node;
+        }
+        lane.tail = node;
+        lane.size.fetch_add(1);
+    }
 
-            if (executor->state == Executor::State::kRun) {
-                // if woken up because of idleness
-                if (executor->tasks.empty() && std::chrono::high_resolution_clock::now() >= wait_limit) {
-                    if (executor->live_workers > executor->low_watermark) {
-                        break;
-                    } else {
-                        while (executor->tasks.empty()) {
-                            // if thread pool is stopping
-                            if (executor->state != Executor::State::kRun) {
-                                break;
-                            }
-                            executor->empty_condition.wait_until(_lock, wait_limit);
-                        }
-                    }
-                }
+    // Pairs with the check in perform: either sleeper sees queued task or we see sleeper
+    if (sleeping.load() > 0) {
+        std::unique_lock<std::mutex> _lock(state_mutex);
+        empty_condition.notify_one();
+    }
+    return true;
+}
+
+void Executor::try_create_worker() {
+    if (queued.load() > free_workers.load() && live_workers < high_watermark && state == State::kRun) {
+        for (auto &w : workers) {
+            if (!w->used) {
+                live_workers += 1;
+                free_workers += 1;
+                spawned += 1;
+
+                w->used = true;
+                auto worker = std::thread(perform, this, w.get());
+                worker.detach();
+                return;
             }
-            if (executor->state != Executor::State::kRun) {
-                if (executor->tasks.empty()) {
-                    // notify next waiting worker
-                    executor->empty_condition.notify_one();
-                    break;
-                }
+        }
+    }
+}
+
+Executor::Node *Executor::find_task(Worker *self) {
+    Lane &high = lanes[int(Priority::kHigh)];
+    Lane &low = lanes[int(Priority::kLow)];
+    if (high.size.load() == 0 && low.size.load() == 0) {
+        // Usual case, only normal priority tasks around
+        return take_normal(self);
+    }
+
+    // Smooth weighted round robin among non-empty lanes: lane with the highest credit wins and pays for
+    // everyone. Normal lane is considered non-empty as other workers might have something to steal
+    int total = 0, best = -1;
+    for (int p = 0; p < kPriorities; p++) {
+        if (p == int(Priority::kNormal) || lanes[p].size.load() > 0) {
+            self->credit[p] += lane_weights[p];
+            total += lane_weights[p];
+            if (best < 0 || self->credit[p] > self->credit[best]) {
+                best = p;
             }
+        }
+    }
+    self->credit[best] -= total;
 
-            executor->free_workers -= 1;
+    Node *task = best == int(Priority::kNormal) ? take_normal(self) : take_injected(Priority(best));
+    if (task != nullptr) {
+        return task;
+    }
 
-            task = executor->tasks.front();
-            executor->tasks.pop_front();
+    // Lost the race for the chosen lane, anything else is better than sleeping
+    for (int p = 0; p < kPriorities && task == nullptr; p++) {
+        if (p != best) {
+            task = p == int(Priority::kNormal) ? take_normal(self) : take_injected(Priority(p));
         }
-        task();
+    }
+    return task;
+}
 
-        executor->free_workers += 1;
+Executor::Node *Executor::take_injected(Priority priority) {
+    Lane &lane = lanes[int(priority)];
+    if (lane.size.load() == 0) {
+        return nullptr;
     }
 
-    {
+    std::unique_lock<std::mutex> _lock(inject_mutex);
+    Node *task = lane.head;
+    if (task != nullptr) {
+        lane.head = task->next;
+        if (lane.head == nullptr) {
+            lane.tail = nullptr;
+        }
+        lane.size.fetch_sub(1);
+    }
+    return task;
+}
+
+Executor::Node *Executor::take_normal(Worker *self) {
+    Node *task = self->tasks.pop();
+    if (task != nullptr) {
+        return task;
+    }
+
+    task = take_injected(Priority::kNormal);
+    if (task != nullptr) {
+        return task;
+    }
+
+    // Steal from others starting at random position, so that thieves don't crowd on a single victim
+    std::size_t n = workers.size();
+    std::size_t start = next_random() % n;
+    for (std::size_t i = 0; i < n; i++) {
+        Worker *victim = workers[(start + i) % n].get();
+        if (victim == self) {
+            continue;
+        }
+
+        bool lost;
+        task = victim->tasks.steal(lost);
+        if (task != nullptr) {
+            return task;
+        }
+    }
+    return nullptr;
+}
+
+// See Executor.h
+void Executor::GetStatistics(Statistics &stats) {
+    std::unique_lock<std::mutex> _lock(state_mutex);
+    stats.threads_live = live_workers;
+    stats.threads_free = free_workers.load();
+    stats.queue_depth = queued.load();
+    stats.queue_depth_max = queue_depth_max.load(std::memory_order_relaxed);
+    stats.tasks_rejected = rejected.load(std::memory_order_relaxed);
+    stats.tasks_expired = expired.load(std::memory_order_relaxed);
+    stats.threads_spawned = spawned;
+    stats.threads_retired = retired;
+
+    stats.wait_time.Reset();
+    stats.run_time.Reset();
+    for (auto &w : workers) {
+        stats.wait_time.Merge(w->wait_time);
+        stats.run_time.Merge(w->run_time);
+    }
+}
+
+void perform(Executor *executor, Executor::Worker *self) {
+    current_worker = self;
+
+    while (true) {
+        Executor::Node *node = executor->find_task(self);
+        if (node != nullptr) {
+            uint64_t start = Metrics::Clock::Now();
+            self->wait_time.Record(Metrics::Clock::ToNanoseconds(start - node->enqueued));
+
+            // Nobody waits for the result of the late task anymore, run expiration handler instead
+            Task task(std::move(node->task));
+            if (node->deadline != Executor::NoDeadline() && std::chrono::steady_clock::now() > node->deadline) {
+                executor->expired.fetch_add(1, std::memory_order_relaxed);
+                task = std::move(node->expired);
+            }
+            node->~Node();
+            Executor::NodePool::Free(node);
+
+            executor->queued.fetch_sub(1);
+            executor->free_workers.fetch_sub(1);
+
+            if (task) {
+                task();
+                task.reset();
+            }
+
+            self->run_time.Record(Metrics::Clock::ToNanoseconds(Metrics::Clock::Now() - start));
+            executor->free_workers.fetch_add(1);
+            continue;
+        }
+
+        // Nothing to do, wait for new task
         std::unique_lock<std::mutex> _lock(executor->state_mutex);
-        executor->free_workers -= 1;
-        executor->live_workers -= 1;
-        if (executor->live_workers == 0) {
-            executor->finish_condition.notify_one();
+        auto wait_limit = std::chrono::steady_clock::now() + executor->idle_time;
+
+        executor->sleeping.fetch_add(1);
+        bool idle = false;
+        while (executor->queued.load() == 0 && executor->state == Executor::State::kRun) {
+            if (executor->empty_condition.wait_until(_lock, wait_limit) == std::cv_status::timeout) {
+                idle = true;
+                break;
+            }
+        }
+        executor->sleeping.fetch_sub(1);
+
+        // State goes first: task counted before the stop is then seen below, and one counted later is
+        // rejected by enqueue, see there
+        bool stopping = executor->state != Executor::State::kRun;
+        if (executor->queued.load() > 0) {
+            // Some task is somewhere, go find it
+            continue;
+        }
+
+        // Either all tasks are done and pool is stopping or there was nothing to do for too long and
+        // there are too many threads
+        if (stopping || (idle && executor->live_workers > executor->low_watermark)) {
+            // Deque is empty: thread exits only once it wasn't able to find a task and only this thread pushes
+            // into it, so slot could be given to another thread
+            current_worker = nullptr;
+            self->used = false;
+            executor->free_workers.fetch_sub(1);
+            executor->live_workers -= 1;
+            if (idle) {
+                executor->retired += 1;
+            }
+            if (executor->live_workers == 0) {
+                executor->finish_condition.notify_all();
+            }
+            return;
         }
     }
 }
@@ -1,19 +1,436 @@
 #include <afina/coroutine/Engine.h>
 
+#include <alloca.h>
 #include <setjmp.h>
+#include <stdexcept>
 #include <stdio.h>
 #include <string.h>
 
+#include <sys/mman.h>
+#include <unistd.h>
+
+#if !defined(__x86_64__)
+#include <ucontext.h>
+#endif
+
+#if defined(__x86_64__)
+// Context switch for System V x86-64 ABI. Callee saved registers, SSE and x87 control words are pushed onto
+// the current stack, stack pointer is saved to *save and all of that is popped back from the load stack.
+// Caller saved registers are already spilled by the compiler as the call site sees a regular function
+//
+// New routine starts at afina_coroutine_start with its entry function in r13 and argument in r12, entry
+// never returns
+extern "C" void afina_coroutine_swap(void **save, void *load);
+extern "C" void afina_coroutine_start();
+
+asm(R"(
+    .text
+    .globl afina_coroutine_swap
+    .hidden afina_coroutine_swap
+    .type afina_coroutine_swap, @function
+afina_coroutine_swap:
+    pushq %rbp
+    pushq %rbx
+    pushq %r12
+    pushq %r13
+    pushq %r14
+    pushq %r15
+    subq $8, %rsp
+    stmxcsr (%rsp)
+    fnstcw 4(%rsp)
+    movq %rsp, (%rdi)
+    movq %rsi, %rsp
+    ldmxcsr (%rsp)
+    fldcw 4(%rsp)
+    addq $8, %rsp
+    popq %r15
+    popq %r14
+    popq %r13
+    popq %r12
+    popq %rbx
+    popq %rbp
+    ret
+    .size afina_coroutine_swap, .-afina_coroutine_swap
+
+    .globl afina_coroutine_start
+    .hidden afina_coroutine_start
+    .type afina_coroutine_start, @function
+afina_coroutine_start:
+    movq %r12, %rdi
+    callq *%r13
+    ud2
+    .size afina_coroutine_start, .-afina_coroutine_start
+)");
+#endif
+
 namespace Afina {
 namespace Coroutine {
 
-void Engine::Store(context &ctx) {}
+namespace {
+
+std::size_t page_size() {
+    static const std::size_t size = sysconf(_SC_PAGESIZE);
+    return size;
+}
+
+#if !defined(__x86_64__)
+// Portable fallback: machine state is ucontext_t. Routines keep it at the top of own stack, the thread itself
+// uses thread local one
+thread_local ucontext_t native_machine;
+
+// makecontext can pass only int arguments, so entry is handed over through thread local variables
+thread_local void (*pending_entry)(void *);
+thread_local void *pending_arg;
+
+void ucontext_start() {
+    void (*entry)(void *) = pending_entry;
+    entry(pending_arg);
+}
+#endif
+
+// Engine started in this thread
+thread_local Engine *running_engine = nullptr;
+
+} // namespace
+
+// See Engine.h
+Engine::~Engine() {
+    for (char *memory : free_stacks) {
+        munmap(memory, stack_size + page_size());
+    }
+}
+
+// See Engine.h
+void Engine::Store(context &ctx) {
+    char StackNow;
+    if (&StackNow > StackBottom) {
+        ctx.Low = StackBottom;
+        ctx.Hight = &StackNow;
+    } else {
+        ctx.Low = &StackNow;
+        ctx.Hight = StackBottom;
+    }
+
+    // Buffer only grows, so that routine which keeps switching doesn't allocate each time
+    uint32_t size = ctx.Hight - ctx.Low;
+    char *&buffer = std::get<0>(ctx.Stack);
+    uint32_t &capacity = std::get<1>(ctx.Stack);
+    if (capacity < size) {
+        delete[] buffer;
+        buffer = new char[size];
+        capacity = size;
+    }
+    memcpy(buffer, ctx.Low, size);
+}
+
+// See Engine.h
+void Engine::Restore(context &ctx) {
+    // Copying stack over the own frame would break this function, so first move below the restored area: pad
+    // takes the rest of it and Jump gets a frame of its own under the pad
+    char StackNow;
+    if (ctx.Low <= &StackNow && &StackNow <= ctx.Hight) {
+        volatile char *pad = static_cast<char *>(alloca(&StackNow - ctx.Low + 1));
+        pad[0] = 0;
+    }
+    Jump(ctx);
+}
+
+// See Engine.h
+__attribute__((noinline)) void Engine::Jump(context &ctx) {
+    memcpy(ctx.Low, std::get<0>(ctx.Stack), ctx.Hight - ctx.Low);
+    longjmp(ctx.Environment, 1);
+}
+
+// See Engine.h
+void Engine::Enter(context &ctx) {
+    context *from = cur_routine;
+    if (&ctx == (from != nullptr ? from : idle_ctx)) {
+        return;
+    }
+
+    cur_routine = (&ctx == idle_ctx) ? nullptr : &ctx;
+    if (mode == StackMode::kSeparate) {
+        Switch(from != nullptr ? *from : *idle_ctx, ctx);
+        return;
+    }
+
+    // Idle context doesn't need to be stored, it is resumed only from the point in start()
+    if (from != nullptr) {
+        if (setjmp(from->Environment) > 0) {
+            return;
+        }
+        Store(*from);
+    }
+    Restore(ctx);
+}
+
+// See Engine.h
+void Engine::yield() {
+    // Round robin: next after the current one, so that all alive routines get their turn
+    context *next = alive;
+    if (cur_routine != nullptr && cur_routine->next != nullptr) {
+        next = cur_routine->next;
+    }
+
+    if (next != nullptr && next != cur_routine) {
+        Enter(*next);
+    }
+}
+
+// See Engine.h
+void Engine::sched(void *routine_) {
+    if (routine_ == nullptr) {
+        yield();
+        return;
+    }
+
+    context *routine = static_cast<context *>(routine_);
+    if (routine != cur_routine) {
+        Enter(*routine);
+    }
+}
+
+// See Engine.h
+void Engine::block(void *routine_) {
+    context *routine = (routine_ != nullptr) ? static_cast<context *>(routine_) : cur_routine;
+    if (routine == nullptr || routine->Blocked) {
+        return;
+    }
+
+    // Next one to run has to be chosen while routine is still in the alive list
+    context *next = (routine->next != nullptr) ? routine->next : alive;
+
+    if (routine->prev != nullptr) {
+        routine->prev->next = routine->next;
+    }
+    if (routine->next != nullptr) {
+        routine->next->prev = routine->prev;
+    }
+    if (alive == routine) {
+        alive = routine->next;
+    }
+
+    routine->Blocked = true;
+    routine->prev = nullptr;
+    routine->next = blocked;
+    if (blocked != nullptr) {
+        blocked->prev = routine;
+    }
+    blocked = routine;
+
+    if (routine == cur_routine) {
+        Enter((next != nullptr && next != routine) ? *next : *idle_ctx);
+    }
+}
+
+// See Engine.h
+void Engine::unblock(void *routine_) {
+    context *routine = static_cast<context *>(routine_);
+    if (routine == nullptr || !routine->Blocked) {
+        return;
+    }
+
+    if (routine->prev != nullptr) {
+        routine->prev->next = routine->next;
+    }
+    if (routine->next != nullptr) {
+        routine->next->prev = routine->prev;
+    }
+    if (blocked == routine) {
+        blocked = routine->next;
+    }
+
+    routine->Blocked = false;
+    routine->prev = nullptr;
+    routine->next = alive;
+    if (alive != nullptr) {
+        alive->prev = routine;
+    }
+    alive = routine;
+}
+
+// See Engine.h
+Engine::context *Engine::Spawn(void (*entry)(void *), void *arg) {
+    const std::size_t guard = page_size();
+
+    context *pc = new context();
+    if (!free_stacks.empty()) {
+        pc->Memory = free_stacks.back();
+        free_stacks.pop_back();
+    } else {
+        void *memory = mmap(nullptr, stack_size + guard, PROT_READ | PROT_WRITE,
+                            MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_STACK, -1, 0);
+        if (memory == MAP_FAILED) {
+            delete pc;
+            throw std::runtime_error("Failed to allocate coroutine stack");
+        }
+
+        // Stack grows down, so overflow runs into the lowest page
+        if (mprotect(memory, guard, PROT_NONE) != 0) {
+            munmap(memory, stack_size + guard);
+            delete pc;
+            throw std::runtime_error("Failed to protect coroutine stack");
+        }
+        pc->Memory = static_cast<char *>(memory);
+    }
+
+    char *top = pc->Memory + guard + stack_size;
+    pc->Low = pc->Memory + guard;
+    pc->Hight = top;
+
+#if defined(__x86_64__)
+    // Frame as afina_coroutine_swap leaves it: control words, r15, r14, r13, r12, rbx, rbp and return address.
+    // Entry must see stack aligned by 16 before its call instruction
+    uint64_t *sp = reinterpret_cast<uint64_t *>((reinterpret_cast<uintptr_t>(top) & ~uintptr_t(15)) - 80);
+    sp[0] = 0x1F80 | (uint64_t(0x037F) << 32);
+    sp[1] = 0;
+    sp[2] = 0;
+    sp[3] = reinterpret_cast<uint64_t>(entry);
+    sp[4] = reinterpret_cast<uint64_t>(arg);
+    sp[5] = 0;
+    sp[6] = 0;
+    sp[7] = reinterpret_cast<uint64_t>(&afina_coroutine_start);
+    pc->Machine = sp;
+#else
+    ucontext_t *machine = reinterpret_cast<ucontext_t *>(
+        (reinterpret_cast<uintptr_t>(top) - sizeof(ucontext_t)) & ~uintptr_t(alignof(std::max_align_t) - 1));
+    getcontext(machine);
+    machine->uc_stack.ss_sp = pc->Low;
+    machine->uc_stack.ss_size = reinterpret_cast<char *>(machine) - pc->Low;
+    machine->uc_link = nullptr;
+    makecontext(machine, &ucontext_start, 0);
+    pc->Machine = machine;
+    pending_entry = entry;
+    pending_arg = arg;
+#endif
+
+    pc->next = alive;
+    alive = pc;
+    if (pc->next != nullptr) {
+        pc->next->prev = pc;
+    }
+
+    // Let routine copy its arguments while they are still alive, it comes back with Suspend()
+    spawner = cur_routine;
+    Enter(*pc);
+    return pc;
+}
+
+// See Engine.h
+void Engine::Suspend() {
+    context *self = cur_routine;
+    cur_routine = spawner;
+    Switch(*self, spawner != nullptr ? *spawner : *idle_ctx);
+}
+
+// See Engine.h
+void Engine::Finish() {
+    context *self = cur_routine;
+    if (self->prev != nullptr) {
+        self->prev->next = self->next;
+    }
+    if (self->next != nullptr) {
+        self->next->prev = self->prev;
+    }
+    if (alive == self) {
+        alive = self->next;
+    }
+
+    // Stack is in use right now, so it is released by whoever gets control next
+    zombie = self;
+    cur_routine = nullptr;
+    Switch(*self, *idle_ctx);
+}
+
+// See Engine.h
+void Engine::Switch(context &from, context &to) {
+#if defined(__x86_64__)
+    afina_coroutine_swap(&from.Machine, to.Machine);
+#else
+    if (from.Machine == nullptr) {
+        from.Machine = &native_machine;
+    }
+    swapcontext(static_cast<ucontext_t *>(from.Machine), static_cast<ucontext_t *>(to.Machine));
+#endif
+
+    // Routine resumed here could have been adopted by other engine, so "this" is not necessary the one that
+    // has switched to it
+    Engine *self = running();
+    if (self->zombie != nullptr) {
+        self->Release(self->zombie);
+        self->zombie = nullptr;
+    }
+}
+
+// See Engine.h
+void Engine::Release(context *ctx) {
+    // Few stacks are kept for the next routines, the rest goes back to the system
+    const std::size_t max_free = 64;
+    if (free_stacks.size() < max_free) {
+        free_stacks.push_back(ctx->Memory);
+    } else {
+        munmap(ctx->Memory, stack_size + page_size());
+    }
+    delete ctx;
+}
+
+// See Engine.h
+void *Engine::detach() {
+    if (mode != StackMode::kSeparate) {
+        throw std::runtime_error("Only routines with separate stacks could be moved between engines");
+    }
+
+    // First two alive routines besides the current one: the first has been woken up most recently and likely
+    // has its data still in cache, so it stays here, the second is given away
+    context *candidates[2] = {nullptr, nullptr};
+    int found = 0;
+    for (context *routine = alive; routine != nullptr && found < 2; routine = routine->next) {
+        if (routine != cur_routine) {
+            candidates[found++] = routine;
+        }
+    }
+    if (found < 2) {
+        return nullptr;
+    }
+
+    context *routine = candidates[1];
+    if (routine->prev != nullptr) {
+        routine->prev->next = routine->next;
+    }
+    if (routine->next != nullptr) {
+        routine->next->prev = routine->prev;
+    }
+    if (alive == routine) {
+        alive = routine->next;
+    }
+    routine->prev = routine->next = nullptr;
+    return routine;
+}
+
+// See Engine.h
+void Engine::adopt(void *routine_) {
+    if (mode != StackMode::kSeparate) {
+        throw std::runtime_error("Only routines with separate stacks could be moved between engines");
+    }
 
-void Engine::Restore(context &ctx) {}
+    context *routine = static_cast<context *>(routine_);
+    routine->prev = nullptr;
+    routine->next = alive;
+    if (alive != nullptr) {
+        alive->prev = routine;
+    }
+    alive = routine;
+}
 
-void Engine::yield() {}
+// See Engine.h
+__attribute__((noinline)) Engine *Engine::running() { return running_engine; }
 
-void Engine::sched(void *routine_) {}
+// See Engine.h
+Engine *Engine::Activate(Engine *engine) {
+    Engine *previous = running_engine;
+    running_engine = engine;
+    return previous;
+}
 
 } // namespace Coroutine
 } // namespace Afina
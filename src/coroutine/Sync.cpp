@@ -0,0 +1,104 @@
+#include <afina/coroutine/Sync.h>
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace Afina {
+namespace Coroutine {
+
+// See Sync.h
+void WaitList::wait() {
+    void *self = _engine.current();
+    if (self == nullptr) {
+        throw std::runtime_error("Only routine could wait");
+    }
+
+    _routines.push_back(self);
+    _engine.block();
+
+    // Someone else has unblocked routine, it must not be woken up once more later
+    auto it = std::find(_routines.begin(), _routines.end(), self);
+    if (it != _routines.end()) {
+        _routines.erase(it);
+    }
+}
+
+// See Sync.h
+bool WaitList::wake_one() {
+    if (_routines.empty()) {
+        return false;
+    }
+
+    void *routine = _routines.front();
+    _routines.pop_front();
+    _engine.unblock(routine);
+    return true;
+}
+
+// See Sync.h
+void WaitList::wake_all() {
+    while (wake_one()) {
+    }
+}
+
+// See Sync.h
+void Mutex::lock() {
+    while (_locked) {
+        _waiters.wait();
+    }
+    _locked = true;
+}
+
+// See Sync.h
+bool Mutex::try_lock() {
+    if (_locked) {
+        return false;
+    }
+    _locked = true;
+    return true;
+}
+
+// See Sync.h
+void Mutex::unlock() {
+    _locked = false;
+    _waiters.wake_one();
+}
+
+// See Sync.h
+void CondVar::wait(Mutex &mutex) {
+    // Nothing could run in between, so notification sent right after unlock is not lost
+    mutex.unlock();
+    try {
+        _waiters.wait();
+    } catch (...) {
+        mutex.lock();
+        throw;
+    }
+    mutex.lock();
+}
+
+// See Sync.h
+void Semaphore::acquire() {
+    while (_permits == 0) {
+        _waiters.wait();
+    }
+    _permits--;
+}
+
+// See Sync.h
+bool Semaphore::try_acquire() {
+    if (_permits == 0) {
+        return false;
+    }
+    _permits--;
+    return true;
+}
+
+// See Sync.h
+void Semaphore::release() {
+    _permits++;
+    _waiters.wake_one();
+}
+
+} // namespace Coroutine
+} // namespace Afina
@@ -1,7 +1,6 @@
 #include <afina/Storage.h>
 #include <afina/execute/Add.h>
-
-#include <iostream>
+#include <afina/metrics/Metrics.h>
 
 namespace Afina {
 namespace Execute {
@@ -9,8 +8,13 @@ namespace Execute {
 // memcached protocol:  "add" means "store this data, but only if the server *doesn't* already
 // hold data for this key".
 void Add::Execute(Storage &storage, const std::string &args, std::string &out) {
-    std::cout << "Add(" << _key << ")" << args << std::endl;
-    out = storage.PutIfAbsent(_key, args) ? "STORED" : "NOT_STORED";
+    Metrics::Add(Metrics::kCmdAdd);
+    if (storage.PutIfAbsent(_key, args)) {
+        Metrics::Add(Metrics::kTotalItems);
+        out = "STORED";
+    } else {
+        out = "NOT_STORED";
+    }
 }
 
 } // namespace Execute
@@ -1,20 +1,19 @@
 #include <afina/Storage.h>
 #include <afina/execute/Append.h>
-
-#include <iostream>
+#include <afina/metrics/Metrics.h>
 
 namespace Afina {
 namespace Execute {
 
 // memcached protocol: "append" means "add this data to an existing key after existing data".
 void Append::Execute(Storage &storage, const std::string &args, std::string &out) {
-    std::cout << "Append(" << _key << ")" << args << std::endl;
+    Metrics::Add(Metrics::kCmdAppend);
     std::string value;
-    if (!storage.Get(_key, value)) {
+    if (!storage.Get(_key, value) || !storage.Put(_key, value + args)) {
         out.assign("NOT_STORED");
         return;
     }
-    storage.Put(_key, value + args);
+    Metrics::Add(Metrics::kTotalItems);
     out.assign("STORED");
 }
 
@@ -1,13 +1,30 @@
 #include <afina/Storage.h>
 #include <afina/execute/Get.h>
-
-#include <iostream>
-#include <iterator>
-#include <sstream>
+#include <afina/metrics/Metrics.h>
 
 namespace Afina {
 namespace Execute {
 
+// See Get.h
+Get::Get(const std::vector<std::string> &keys) : _keys(keys) {
+    _owned_views.reserve(_keys.size());
+    for (auto &key : _keys) {
+        _owned_views.push_back(KeyView{key.data(), key.size()});
+    }
+    _views = _owned_views.data();
+    _count = _owned_views.size();
+}
+
+// See Get.h
+std::vector<std::string> Get::keys() const {
+    std::vector<std::string> result;
+    result.reserve(_count);
+    for (std::size_t i = 0; i < _count; i++) {
+        result.emplace_back(_views[i].data, _views[i].size);
+    }
+    return result;
+}
+
 /* memcached protocol:
 
 Each item sent by the server looks like this:
@@ -22,22 +39,26 @@ to indicate the end of response.
 */
 
 void Get::Execute(Storage &storage, const std::string &args, std::string &out) {
-    std::stringstream keyStream;
-    copy(_keys.begin(), _keys.end(), std::ostream_iterator<std::string>(keyStream, " "));
-    std::cout << "Get(" << keyStream.str() << ")" << std::endl;
-
-    std::stringstream outStream;
+    out.clear();
 
-    std::string value;
-    for (auto &key : _keys) {
-        if (!storage.Get(key, value))
+    std::string key, value;
+    Metrics::Add(Metrics::kCmdGet, _count);
+    for (std::size_t i = 0; i < _count; i++) {
+        key.assign(_views[i].data, _views[i].size);
+        if (!storage.Get(key, value)) {
+            Metrics::Add(Metrics::kGetMisses);
             continue;
-        outStream << "VALUE " << key << " 0 " << value.size() << "\r\n";
-        outStream << value << "\r\n";
+        }
+        Metrics::Add(Metrics::kGetHits);
+        out.append("VALUE ");
+        out.append(key);
+        out.append(" 0 ");
+        out.append(std::to_string(value.size()));
+        out.append("\r\n");
+        out.append(value);
+        out.append("\r\n");
     }
-    outStream << "END"; // networking layer should add the last \r\n
-
-    out = outStream.str();
+    out.append("END"); // networking layer should add the last \r\n
 }
 
 } // namespace Execute
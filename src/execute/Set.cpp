@@ -1,16 +1,19 @@
 #include <afina/Storage.h>
 #include <afina/execute/Set.h>
-
-#include <iostream>
+#include <afina/metrics/Metrics.h>
 
 namespace Afina {
 namespace Execute {
 
 // memcached protocol: "set" means "store this data".
 void Set::Execute(Storage &storage, const std::string &args, std::string &out) {
-    std::cout << "Set(" << _key << "): " << args << std::endl;
-    storage.Put(_key, args);
-    out = "STORED";
+    Metrics::Add(Metrics::kCmdSet);
+    if (storage.Put(_key, args)) {
+        Metrics::Add(Metrics::kTotalItems);
+        out = "STORED";
+    } else {
+        out = "NOT_STORED";
+    }
 }
 
 } // namespace Execute
@@ -1,14 +1,182 @@
 #include <afina/Storage.h>
 #include <afina/execute/Stats.h>
+#include <afina/metrics/Histogram.h>
+#include <afina/metrics/Latency.h>
+#include <afina/metrics/Metrics.h>
 
+#include <cstdio>
+#include <cstring>
+#include <ctime>
 #include <iostream>
 #include <iterator>
 #include <sstream>
 
+#include <sys/resource.h>
+#include <sys/time.h>
+#include <unistd.h>
+
 namespace Afina {
 namespace Execute {
 
-void Stats::Execute(Storage &storage, const std::string &args, std::string &out) { out.assign("END"); }
+namespace {
+
+template <typename T> void stat(std::stringstream &out, const std::string &name, const T &value) {
+    out << "STAT " << name << " " << value << "\r\n";
+}
+
+std::string format_time(const struct timeval &tv) {
+    char buf[64];
+    snprintf(buf, sizeof(buf), "%ld.%06ld", long(tv.tv_sec), long(tv.tv_usec));
+    return buf;
+}
+
+/* memcached protocol: "stats" with no arguments
+
+STAT <name> <value>\r\n
+...
+END\r\n
+
+*/
+void general(Storage &storage, std::stringstream &out) {
+    Metrics::Snapshot m;
+    Metrics::Collect(m);
+
+    Storage::Usage usage;
+    storage.GetUsage(usage);
+
+    struct rusage ru;
+    std::memset(&ru, 0, sizeof(ru));
+    getrusage(RUSAGE_SELF, &ru);
+
+    stat(out, "pid", getpid());
+    stat(out, "uptime", Metrics::Uptime());
+    stat(out, "time", std::time(nullptr));
+    stat(out, "version", Metrics::GetSetting("version"));
+    stat(out, "pointer_size", 8 * sizeof(void *));
+    stat(out, "rusage_user", format_time(ru.ru_utime));
+    stat(out, "rusage_system", format_time(ru.ru_stime));
+    stat(out, "curr_connections", m[Metrics::kCurrConnections]);
+    stat(out, "total_connections", m[Metrics::kTotalConnections]);
+    stat(out, "rejected_connections", m[Metrics::kRejectedConnections]);
+    stat(out, "cmd_get", m[Metrics::kCmdGet]);
+    stat(out, "cmd_set",
+         m[Metrics::kCmdSet] + m[Metrics::kCmdAdd] + m[Metrics::kCmdAppend] + m[Metrics::kCmdReplace]);
+    stat(out, "cmd_add", m[Metrics::kCmdAdd]);
+    stat(out, "cmd_append", m[Metrics::kCmdAppend]);
+    stat(out, "cmd_replace", m[Metrics::kCmdReplace]);
+    stat(out, "cmd_stats", m[Metrics::kCmdStats]);
+    stat(out, "get_hits", m[Metrics::kGetHits]);
+    stat(out, "get_misses", m[Metrics::kGetMisses]);
+    stat(out, "bytes_read", m[Metrics::kBytesRead]);
+    stat(out, "bytes_written", m[Metrics::kBytesWritten]);
+    stat(out, "limit_maxbytes", usage.limit);
+    stat(out, "threads", Metrics::GetSetting("num_threads"));
+    stat(out, "bytes", usage.bytes);
+    stat(out, "item_overhead", usage.items > 0 ? usage.overhead / usage.items : 0);
+    stat(out, "curr_items", usage.items);
+    stat(out, "total_items", m[Metrics::kTotalItems]);
+    stat(out, "evictions", usage.evictions);
+}
+
+// Storage has no slab allocator, so everything is reported as a single item class
+void items(Storage &storage, std::stringstream &out) {
+    Storage::Usage usage;
+    storage.GetUsage(usage);
+    if (usage.items == 0) {
+        return;
+    }
+
+    stat(out, "items:1:number", usage.items);
+    stat(out, "items:1:evicted", usage.evictions);
+    stat(out, "items:1:outofmemory", 0);
+}
+
+// Storage has no slab allocator, so everything is reported as a single slab class
+void slabs(Storage &storage, std::stringstream &out) {
+    Storage::Usage usage;
+    storage.GetUsage(usage);
+    if (usage.items > 0) {
+        stat(out, "1:chunk_size", usage.bytes / usage.items);
+        stat(out, "1:used_chunks", usage.items);
+        stat(out, "1:mem_requested", usage.bytes - usage.overhead);
+    }
+    stat(out, "active_slabs", usage.items > 0 ? 1 : 0);
+    stat(out, "total_malloced", usage.bytes);
+}
+
+void settings(Storage &storage, std::stringstream &out) {
+    Storage::Usage usage;
+    storage.GetUsage(usage);
+
+    stat(out, "maxbytes", usage.limit);
+    stat(out, "item_size_max", usage.limit);
+    stat(out, "evictions", "on");
+    for (auto &s : Metrics::Settings()) {
+        if (s.first != "version") {
+            stat(out, s.first, s.second);
+        }
+    }
+}
+
+// Nanoseconds as microseconds with fraction
+std::string format_us(double ns) {
+    char buf[64];
+    snprintf(buf, sizeof(buf), "%.3f", ns / 1000.0);
+    return buf;
+}
+
+// Latency of the whole request path, from the first byte read to the response sent, per operation
+void latency(std::stringstream &out) {
+    Metrics::Histogram h;
+    for (uint16_t op = 0; op < Metrics::kOperationCount; op++) {
+        Metrics::CollectLatency(Metrics::Operation(op), h);
+        if (h.Count() == 0) {
+            continue;
+        }
+
+        std::string prefix = std::string(Metrics::OperationName(Metrics::Operation(op))) + ":";
+        stat(out, prefix + "count", h.Count());
+        stat(out, prefix + "mean_us", format_us(h.Mean()));
+        stat(out, prefix + "p50_us", format_us(h.Percentile(50)));
+        stat(out, prefix + "p90_us", format_us(h.Percentile(90)));
+        stat(out, prefix + "p99_us", format_us(h.Percentile(99)));
+        stat(out, prefix + "p999_us", format_us(h.Percentile(99.9)));
+        stat(out, prefix + "max_us", format_us(h.Max()));
+    }
+}
+
+} // namespace
+
+// See Stats.h
+void Stats::Execute(Storage &storage, const std::string &args, std::string &out) {
+    Metrics::Add(Metrics::kCmdStats);
+
+    std::stringstream outStream;
+    if (_group.empty()) {
+        general(storage, outStream);
+    } else if (_group == "items") {
+        items(storage, outStream);
+    } else if (_group == "slabs") {
+        slabs(storage, outStream);
+    } else if (_group == "settings") {
+        settings(storage, outStream);
+    } else if (_group == "latency") {
+        latency(outStream);
+    } else {
+        // Groups reported by the components themselves, such as thread pool
+        std::vector<std::pair<std::string, std::string>> values;
+        if (!Metrics::CollectReport(_group, values)) {
+            out.assign("ERROR");
+            return;
+        }
+        for (auto &v : values) {
+            stat(outStream, v.first, v.second);
+        }
+    }
+    outStream << "END"; // networking layer should add the last \r\n
+
+    out = outStream.str();
+}
 
 } // namespace Execute
 } // namespace Afina
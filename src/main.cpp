@@ -1,6 +1,9 @@
+#include <algorithm>
 #include <chrono>
 #include <iostream>
+#include <limits>
 #include <memory>
+#include <stdexcept>
 
 #include <atomic>
 #include <semaphore.h>
@@ -12,19 +15,58 @@
 #include <afina/Storage.h>
 #include <afina/Version.h>
 #include <afina/logging/Service.h>
+#include <afina/metrics/Metrics.h>
 #include <afina/network/Server.h>
 
 #include "logging/ServiceImpl.h"
 #include "network/mt_blocking/ServerImpl.h"
+#include "network/mt_coroutine/ServerImpl.h"
 #include "network/mt_nonblocking/ServerImpl.h"
+#include "network/st_coroutine/ServerImpl.h"
 #include "network/st_blocking/ServerImpl.h"
 #include "network/st_nonblocking/ServerImpl.h"
+#include "network/uring/ServerImpl.h"
 
+#include "storage/ARC.h"
+#include "storage/ClockLRU.h"
+#include "storage/SegmentedLRU.h"
 #include "storage/SimpleLRU.h"
+#include "storage/ThreadSafe.h"
 #include "storage/ThreadSafeSimpleLRU.h"
 
 using namespace Afina;
 
+// Parses number of bytes with optional K, M or G suffix
+std::size_t parse_size(const std::string &value) {
+    std::size_t pos = 0;
+    unsigned long long size = 0;
+    try {
+        // stoull takes minus and negates the result
+        if (value.find('-') != std::string::npos) {
+            throw std::invalid_argument(value);
+        }
+        size = std::stoull(value, &pos);
+    } catch (std::exception &) {
+        throw std::runtime_error("Invalid size: " + value);
+    }
+
+    const std::string suffix = value.substr(pos);
+    int shift = 0;
+    if (suffix == "K" || suffix == "k") {
+        shift = 10;
+    } else if (suffix == "M" || suffix == "m") {
+        shift = 20;
+    } else if (suffix == "G" || suffix == "g") {
+        shift = 30;
+    } else if (!suffix.empty()) {
+        throw std::runtime_error("Invalid size: " + value);
+    }
+    if (size > (std::numeric_limits<std::size_t>::max() >> shift)) {
+        throw std::runtime_error("Size is too large: " + value);
+    }
+    return size << shift;
+}
+
 /**
  * Whole application class
  */
@@ -50,13 +92,28 @@ public:
             storage_type = options["storage"].as<std::string>();
         }
 
+        std::size_t memory = parse_size(options["memory"].as<std::string>());
+        bool admission = options.count("admission") > 0;
         if (storage_type == "st_lru") {
-            storage = std::make_shared<Afina::Backend::SimpleLRU>();
+            storage = std::make_shared<Afina::Backend::SimpleLRU>(memory, admission);
         } else if (storage_type == "mt_lru") {
-            storage = std::make_shared<Afina::Backend::ThreadSafeSimplLRU>();
+            storage = std::make_shared<Afina::Backend::ThreadSafeSimplLRU>(memory, admission);
+        } else if (storage_type == "st_slru") {
+            storage = std::make_shared<Afina::Backend::SegmentedLRU>(memory, 0.8, admission);
+        } else if (storage_type == "mt_slru") {
+            storage =
+                std::make_shared<Afina::Backend::ThreadSafe<Afina::Backend::SegmentedLRU>>(memory, 0.8, admission);
+        } else if (storage_type == "st_arc") {
+            storage = std::make_shared<Afina::Backend::ARC>(memory);
+        } else if (storage_type == "mt_arc") {
+            storage = std::make_shared<Afina::Backend::ThreadSafe<Afina::Backend::ARC>>(memory);
+        } else if (storage_type == "mt_clock") {
+            storage = std::make_shared<Afina::Backend::ClockLRU>(memory);
         } else {
             throw std::runtime_error("Unknown storage type");
         }
+        Metrics::SetSetting("storage", storage_type);
+        Metrics::SetSetting("admission", admission ? "tinylfu" : "none");
 
         // Step 2: Configure network
         std::string network_type = "st_block";
@@ -72,9 +129,51 @@ public:
             server = std::make_shared<Afina::Network::STnonblock::ServerImpl>(storage, logService);
         } else if (network_type == "mt_nonblock") {
             server = std::make_shared<Afina::Network::MTnonblock::ServerImpl>(storage, logService);
+        } else if (network_type == "st_coroutine") {
+            server = std::make_shared<Afina::Network::STcoroutine::ServerImpl>(storage, logService);
+        } else if (network_type == "mt_coroutine") {
+            server = std::make_shared<Afina::Network::MTcoroutine::ServerImpl>(storage, logService);
+        } else if (network_type == "uring") {
+            server = std::make_shared<Afina::Network::Uring::ServerImpl>(storage, logService);
         } else {
             throw std::runtime_error("Unknown network type");
         }
+        Metrics::SetSetting("network", network_type);
+
+        // Options are read as signed, so that negative values are rejected rather than wrapped around
+        int port_value = options["port"].as<int>();
+        int acceptors_value = options["acceptors"].as<int>();
+        int workers_value = options["workers"].as<int>();
+        int read_timeout = options["read-timeout"].as<int>();
+        int pool_min = options["pool-min"].as<int>();
+        int pool_max = options["pool-max"].as<int>();
+        int pool_queue = options["pool-queue"].as<int>();
+        int pool_idle = options["pool-idle"].as<int>();
+
+        Network::Server::Config config;
+        config.address = options["address"].as<std::string>();
+        config.backlog = options["backlog"].as<int>();
+        if (port_value < 1 || port_value > std::numeric_limits<uint16_t>::max() || acceptors_value < 1 ||
+            workers_value < 0 || config.backlog < 1 || read_timeout < 0 || pool_min < 0 || pool_max < 1 ||
+            pool_min > pool_max || pool_queue < 1 || pool_idle < 0) {
+            throw std::runtime_error("Invalid network options");
+        }
+
+        port = port_value;
+        acceptors = acceptors_value;
+        workers = workers_value;
+        if (workers == 0) {
+            workers = std::max(1u, std::thread::hardware_concurrency());
+        }
+        config.read_timeout_ms = read_timeout;
+        config.pool_min = pool_min;
+        config.pool_max = pool_max;
+        config.pool_queue = pool_queue;
+        config.pool_idle_ms = pool_idle;
+        server->Configure(config);
+
+        Metrics::SetSetting("interface", config.address);
+        Metrics::SetSetting("tcp_backlog", std::to_string(config.backlog));
     }
 
     // Start services in correct order
@@ -86,10 +185,13 @@ public:
         log->warn("Start storage");
         storage->Start();
 
-        // TODO: configure network service
-        const uint16_t port = 8080;
-        log->warn("Start network on {}", port);
-        server->Start(port, 2, 2);
+        Metrics::SetSetting("version", Afina::get_version());
+        Metrics::SetSetting("tcpport", std::to_string(port));
+        Metrics::SetSetting("num_acceptors", std::to_string(acceptors));
+        Metrics::SetSetting("num_threads", std::to_string(workers));
+
+        log->warn("Start network on {}, {} acceptors, {} workers", port, acceptors, workers);
+        server->Start(port, acceptors, workers);
     }
 
     // Stop services in correct order
@@ -109,6 +211,11 @@ private:
 
     std::shared_ptr<Afina::Storage> storage;
     std::shared_ptr<Afina::Network::Server> server;
+
+    // Arguments of Network::Server::Start
+    uint16_t port;
+    uint32_t acceptors;
+    uint32_t workers;
 };
 
 // Signal set that to notify application about time to stop
@@ -129,6 +236,28 @@ int main(int argc, char **argv) {
         // and simplify validation below
         options.add_options()("s,storage", "Type of storage service to use", cxxopts::value<std::string>());
         options.add_options()("n,network", "Type of network service to use", cxxopts::value<std::string>());
+        options.add_options()("m,memory", "Bytes storage may take including items overhead, K, M or G suffixed",
+                              cxxopts::value<std::string>()->default_value("64M"));
+        options.add_options()("admission", "lru, slru: admit new keys by TinyLFU frequency estimate");
+        options.add_options()("a,address", "IPv4 address to listen on",
+                              cxxopts::value<std::string>()->default_value("0.0.0.0"));
+        options.add_options()("p,port", "TCP port to listen on", cxxopts::value<int>()->default_value("8080"));
+        options.add_options()("acceptors", "Number of threads accepting connections, if network has them",
+                              cxxopts::value<int>()->default_value("2"));
+        options.add_options()("w,workers", "Number of threads serving connections, 0 means one per core",
+                              cxxopts::value<int>()->default_value("0"));
+        options.add_options()("backlog", "Connections kernel queues until they are accepted",
+                              cxxopts::value<int>()->default_value(std::to_string(SOMAXCONN)));
+        options.add_options()("read-timeout", "mt_block, st_block: close connection idle for that many ms, 0 is never",
+                              cxxopts::value<int>()->default_value("5000"));
+        options.add_options()("pool-min", "mt_block: threads pool keeps even if idle",
+                              cxxopts::value<int>()->default_value("2"));
+        options.add_options()("pool-max", "mt_block: threads limit, which is connections limit as well",
+                              cxxopts::value<int>()->default_value("64"));
+        options.add_options()("pool-queue", "mt_block: connections not picked by a thread yet, at least 1",
+                              cxxopts::value<int>()->default_value("64"));
+        options.add_options()("pool-idle", "mt_block: ms idle thread above pool-min lives",
+                              cxxopts::value<int>()->default_value("5000"));
         options.add_options()("h,help", "Print usage info");
         options.parse(argc, argv);
 
@@ -143,7 +272,12 @@ int main(int argc, char **argv) {
 
     // Start boot sequence
     Application app;
-    app.Configure(options);
+    try {
+        app.Configure(options);
+    } catch (std::exception &ex) {
+        std::cerr << "Error: " << ex.what() << std::endl;
+        return 1;
+    }
 
     // POSIX specific staff
     {
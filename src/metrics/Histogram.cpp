@@ -0,0 +1,109 @@
+#include <afina/metrics/Histogram.h>
+
+namespace Afina {
+namespace Metrics {
+
+constexpr unsigned Histogram::kSubBucketBits;
+constexpr uint64_t Histogram::kSubBuckets;
+constexpr unsigned Histogram::kMaxBits;
+constexpr uint64_t Histogram::kMaxValue;
+constexpr std::size_t Histogram::kBuckets;
+
+// See Histogram.h
+void Histogram::RecordCorrected(uint64_t value, uint64_t expected_interval) {
+    Record(value);
+    if (expected_interval == 0 || value <= expected_interval) {
+        return;
+    }
+    for (uint64_t missed = value - expected_interval; missed >= expected_interval; missed -= expected_interval) {
+        Record(missed);
+    }
+}
+
+// See Histogram.h
+void Histogram::Merge(const Histogram &other) {
+    for (std::size_t i = 0; i < kBuckets; i++) {
+        uint64_t n = other._counts[i].load(std::memory_order_relaxed);
+        if (n > 0) {
+            _counts[i].store(_counts[i].load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+        }
+    }
+    _sum.store(_sum.load(std::memory_order_relaxed) + other._sum.load(std::memory_order_relaxed),
+               std::memory_order_relaxed);
+}
+
+// See Histogram.h
+void Histogram::Reset() {
+    for (auto &c : _counts) {
+        c.store(0, std::memory_order_relaxed);
+    }
+    _sum.store(0, std::memory_order_relaxed);
+}
+
+// See Histogram.h
+uint64_t Histogram::Count() const {
+    uint64_t result = 0;
+    for (auto &c : _counts) {
+        result += c.load(std::memory_order_relaxed);
+    }
+    return result;
+}
+
+// See Histogram.h
+double Histogram::Mean() const {
+    uint64_t count = Count();
+    if (count == 0) {
+        return 0;
+    }
+    return double(_sum.load(std::memory_order_relaxed)) / count;
+}
+
+// See Histogram.h
+uint64_t Histogram::Percentile(double percent) const {
+    uint64_t count = Count();
+    if (count == 0) {
+        return 0;
+    }
+
+    // Rank of the value to be found, 1-based
+    uint64_t rank = uint64_t(percent / 100.0 * count + 0.5);
+    if (rank < 1) {
+        rank = 1;
+    } else if (rank > count) {
+        rank = count;
+    }
+
+    uint64_t seen = 0;
+    for (std::size_t i = 0; i < kBuckets; i++) {
+        seen += _counts[i].load(std::memory_order_relaxed);
+        if (seen >= rank) {
+            return BucketHighest(i);
+        }
+    }
+    return kMaxValue;
+}
+
+// See Histogram.h
+uint64_t Histogram::Max() const {
+    for (std::size_t i = kBuckets; i > 0; i--) {
+        if (_counts[i - 1].load(std::memory_order_relaxed) > 0) {
+            return BucketHighest(i - 1);
+        }
+    }
+    return 0;
+}
+
+// See Histogram.h
+uint64_t Histogram::BucketHighest(std::size_t bucket) {
+    if (bucket < 2 * kSubBuckets) {
+        return bucket;
+    }
+
+    std::size_t linear = bucket - 2 * kSubBuckets;
+    unsigned shift = linear / kSubBuckets + 1;
+    uint64_t top = linear % kSubBuckets + kSubBuckets;
+    return ((top + 1) << shift) - 1;
+}
+
+} // namespace Metrics
+} // namespace Afina
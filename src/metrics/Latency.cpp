@@ -0,0 +1,50 @@
+#include <afina/metrics/Latency.h>
+
+namespace Afina {
+namespace Metrics {
+
+namespace {
+
+// Measures TSC rate against steady_clock over a short busy loop
+double calibrate() {
+    auto start = std::chrono::steady_clock::now();
+    uint64_t start_ticks = Clock::Now();
+
+    std::chrono::steady_clock::time_point now;
+    do {
+        now = std::chrono::steady_clock::now();
+    } while (now - start < std::chrono::milliseconds(2));
+    uint64_t ticks = Clock::Now() - start_ticks;
+
+    double ns = std::chrono::duration_cast<std::chrono::nanoseconds>(now - start).count();
+    return ticks > 0 ? ns / ticks : 1.0;
+}
+
+const char *operation_names[kOperationCount] = {"get", "set", "add", "append", "replace", "stats", "other"};
+
+} // namespace
+
+// See Latency.h
+const double Clock::_ns_per_tick = calibrate();
+
+// See Latency.h
+Operation OperationByName(const std::string &name) {
+    for (uint16_t op = 0; op < kOpOther; op++) {
+        if (name == operation_names[op]) {
+            return Operation(op);
+        }
+    }
+    return kOpOther;
+}
+
+// See Latency.h
+const char *OperationName(Operation op) { return operation_names[op]; }
+
+// See Latency.h
+void CollectLatency(Operation op, Histogram &result) {
+    result.Reset();
+    LatencyShards().for_each([op, &result](const LatencyShard &shard) { result.Merge(shard.histograms[op]); });
+}
+
+} // namespace Metrics
+} // namespace Afina
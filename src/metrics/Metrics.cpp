@@ -0,0 +1,111 @@
+#include <afina/metrics/Metrics.h>
+
+#include <chrono>
+#include <mutex>
+
+namespace Afina {
+namespace Metrics {
+
+namespace {
+
+// Process start time, initialized once library gets loaded
+const std::chrono::steady_clock::time_point start_time = std::chrono::steady_clock::now();
+
+// Configuration parameters, see SetSetting
+std::mutex settings_mutex;
+std::vector<std::pair<std::string, std::string>> settings;
+
+// Component reports, see AddReport. Mutex is held while report is running
+struct ReportEntry {
+    int id;
+    std::string group;
+    Report report;
+};
+
+std::mutex reports_mutex;
+std::vector<ReportEntry> reports;
+int next_report_id = 0;
+
+} // namespace
+
+// See Metrics.h
+void Collect(Snapshot &snapshot) {
+    for (auto &c : snapshot.counters) {
+        c = 0;
+    }
+
+    Shards().for_each([&snapshot](const Shard &shard) {
+        for (std::size_t i = 0; i < kCounterCount; i++) {
+            snapshot.counters[i] += shard.counters[i].load(std::memory_order_relaxed);
+        }
+    });
+}
+
+// See Metrics.h
+uint64_t Uptime() {
+    return std::chrono::duration_cast<std::chrono::seconds>(std::chrono::steady_clock::now() - start_time).count();
+}
+
+// See Metrics.h
+void SetSetting(const std::string &name, const std::string &value) {
+    std::unique_lock<std::mutex> lock(settings_mutex);
+    for (auto &s : settings) {
+        if (s.first == name) {
+            s.second = value;
+            return;
+        }
+    }
+    settings.emplace_back(name, value);
+}
+
+// See Metrics.h
+std::string GetSetting(const std::string &name) {
+    std::unique_lock<std::mutex> lock(settings_mutex);
+    for (auto &s : settings) {
+        if (s.first == name) {
+            return s.second;
+        }
+    }
+    return std::string();
+}
+
+// See Metrics.h
+std::vector<std::pair<std::string, std::string>> Settings() {
+    std::unique_lock<std::mutex> lock(settings_mutex);
+    return settings;
+}
+
+// See Metrics.h
+int AddReport(const std::string &group, Report report) {
+    std::unique_lock<std::mutex> lock(reports_mutex);
+    int id = next_report_id++;
+    reports.push_back(ReportEntry{id, group, std::move(report)});
+    return id;
+}
+
+// See Metrics.h
+void RemoveReport(int id) {
+    std::unique_lock<std::mutex> lock(reports_mutex);
+    for (auto it = reports.begin(); it != reports.end(); it++) {
+        if (it->id == id) {
+            reports.erase(it);
+            return;
+        }
+    }
+}
+
+// See Metrics.h
+bool CollectReport(const std::string &group, std::vector<std::pair<std::string, std::string>> &values) {
+    std::unique_lock<std::mutex> lock(reports_mutex);
+    bool found = false;
+    for (auto &r : reports) {
+        if (r.group == group) {
+            r.report(values);
+            found = true;
+        }
+    }
+    return found;
+}
+
+} // namespace Metrics
+} // namespace Afina
@@ -0,0 +1,89 @@
+#include "InputBuffer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace Afina {
+namespace Network {
+
+const std::size_t InputBuffer::kBaseline;
+const std::size_t InputBuffer::kCap;
+
+// See InputBuffer.h
+InputBuffer::InputBuffer(std::size_t baseline, std::size_t cap)
+    : _baseline(baseline), _cap(std::max(cap, baseline)), _capacity(0), _read(0), _write(0) {
+    Reallocate(baseline);
+}
+
+// See InputBuffer.h
+void InputBuffer::Consume(std::size_t n) {
+    _read += n;
+    if (_read == _write) {
+        _read = _write = 0;
+    }
+}
+
+// See InputBuffer.h
+char *InputBuffer::Space() {
+    if (_write == _capacity) {
+        Reserve(Size() + 1);
+    }
+    return _data.get() + _write;
+}
+
+// See InputBuffer.h
+void InputBuffer::Append(const char *data, std::size_t size) {
+    if (size == 0) {
+        return;
+    }
+    if (Free() < size) {
+        Reserve(Size() + size);
+    }
+    std::memcpy(_data.get() + _write, data, size);
+    _write += size;
+}
+
+// See InputBuffer.h
+void InputBuffer::Reserve(std::size_t n) {
+    if (_capacity - _read >= n) {
+        return;
+    }
+    if (n > _cap) {
+        throw std::runtime_error("Input is too large");
+    }
+
+    if (n <= _capacity) {
+        // There is enough room, it is just taken by consumed bytes
+        std::memmove(_data.get(), _data.get() + _read, Size());
+        _write -= _read;
+        _read = 0;
+        return;
+    }
+    Reallocate(std::min(std::max(std::max(_capacity * 2, kBaseline), n), _cap));
+}
+
+// See InputBuffer.h
+void InputBuffer::Shrink() {
+    if (_read == _write && _capacity > _baseline) {
+        Reallocate(_baseline);
+    }
+}
+
+// See InputBuffer.h
+void InputBuffer::Reallocate(std::size_t capacity) {
+    std::unique_ptr<char[]> data;
+    if (capacity > 0) {
+        data.reset(new char[capacity]);
+    }
+    if (Size() > 0) {
+        std::memcpy(data.get(), _data.get() + _read, Size());
+    }
+    _data.swap(data);
+    _capacity = capacity;
+    _write -= _read;
+    _read = 0;
+}
+
+} // namespace Network
+} // namespace Afina
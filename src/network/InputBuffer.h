@@ -0,0 +1,90 @@
+#ifndef AFINA_NETWORK_INPUT_BUFFER_H
+#define AFINA_NETWORK_INPUT_BUFFER_H
+
+#include <cstddef>
+#include <memory>
+
+namespace Afina {
+namespace Network {
+
+/**
+ * # Connection input buffer
+ * Bytes are read in at the write cursor and consumed at the read cursor, so nothing is moved while commands are
+ * parsed out of the buffer. Cursors return to the start once everything is consumed. Unconsumed bytes are moved
+ * to the front only when there is no room left at the end, which happens at most once per refill.
+ *
+ * Buffer grows twice at a time up to the cap, so that argument of the command could be taken in one piece once
+ * it has arrived completely. Buffer that has grown returns to the baseline size once it is drained
+ */
+class InputBuffer {
+public:
+    // Default sizes: same as stack buffers servers used to have, memcached limits item to 1MB
+    static const std::size_t kBaseline = 4096;
+    static const std::size_t kCap = 1024 * 1024 + 64;
+
+    explicit InputBuffer(std::size_t baseline = kBaseline, std::size_t cap = kCap);
+
+    InputBuffer(const InputBuffer &) = delete;
+    InputBuffer &operator=(const InputBuffer &) = delete;
+
+    /**
+     * Unconsumed bytes
+     */
+    inline const char *Data() const { return _data.get() + _read; }
+    inline std::size_t Size() const { return _write - _read; }
+
+    /**
+     * Marks given number of bytes at the read cursor as consumed
+     */
+    void Consume(std::size_t n);
+
+    /**
+     * Room to read into, there is at least one byte of it. Throws std::runtime_error if buffer is full and has
+     * reached the cap
+     */
+    char *Space();
+    inline std::size_t Free() const { return _capacity - _write; }
+
+    /**
+     * Marks given number of bytes written into Space() as received
+     */
+    inline void Produce(std::size_t n) { _write += n; }
+
+    /**
+     * Copies bytes in at the write cursor
+     */
+    void Append(const char *data, std::size_t size);
+
+    /**
+     * Makes sure that n bytes starting at the read cursor fit into the buffer without moving them later. Throws
+     * std::runtime_error if n is above the cap
+     */
+    void Reserve(std::size_t n);
+
+    /**
+     * Returns memory above the baseline if there is nothing unconsumed. Buffer with zero baseline doesn't hold any
+     * memory while it is empty
+     */
+    void Shrink();
+
+    inline std::size_t Capacity() const { return _capacity; }
+
+private:
+    // Allocates buffer of the given capacity and moves unconsumed bytes to its start
+    void Reallocate(std::size_t capacity);
+
+    const std::size_t _baseline;
+    const std::size_t _cap;
+
+    std::unique_ptr<char[]> _data;
+    std::size_t _capacity;
+
+    // Cursors: [_read, _write) is unconsumed input
+    std::size_t _read;
+    std::size_t _write;
+};
+
+} // namespace Network
+} // namespace Afina
+
+#endif // AFINA_NETWORK_INPUT_BUFFER_H
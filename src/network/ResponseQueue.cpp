@@ -0,0 +1,93 @@
+#include "ResponseQueue.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <stdexcept>
+
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+#include <afina/metrics/Metrics.h>
+
+namespace Afina {
+namespace Network {
+
+const std::size_t ResponseQueue::kMaxResponses;
+const std::size_t ResponseQueue::kMaxBytes;
+
+// See ResponseQueue.h
+void ResponseQueue::Push(std::string response, Metrics::Operation op, uint64_t start) {
+    _bytes += response.size() + 2;
+    _responses.push_back(std::move(response));
+    _origins.push_back(Origin{op, start});
+}
+
+// See ResponseQueue.h
+ssize_t ResponseQueue::Read(int socket, char *buffer, std::size_t size) {
+    if (_responses.size() >= kMaxResponses || _bytes >= kMaxBytes) {
+        Flush(socket);
+    }
+
+    if (!_responses.empty()) {
+        ssize_t readed_bytes = recv(socket, buffer, size, MSG_DONTWAIT);
+        if (readed_bytes >= 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+            return readed_bytes;
+        }
+        Flush(socket);
+    }
+    return recv(socket, buffer, size, 0);
+}
+
+// See ResponseQueue.h
+void ResponseQueue::Flush(int socket) {
+    static const char terminator[] = "\r\n";
+
+    // Each response takes two entries: response itself and terminator
+    std::vector<struct iovec> iov(_responses.size() * 2);
+    for (std::size_t i = 0; i < _responses.size(); i++) {
+        iov[2 * i].iov_base = const_cast<char *>(_responses[i].data());
+        iov[2 * i].iov_len = _responses[i].size();
+        iov[2 * i + 1].iov_base = const_cast<char *>(terminator);
+        iov[2 * i + 1].iov_len = 2;
+    }
+
+    std::size_t head = 0;
+    std::size_t sent = 0;
+    while (head < iov.size()) {
+        int count = std::min(iov.size() - head, std::size_t(IOV_MAX));
+        ssize_t written = writev(socket, &iov[head], count);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::runtime_error("Failed to send response: " + std::string(strerror(errno)));
+        }
+        Metrics::Add(Metrics::kBytesWritten, written);
+
+        // Skip entries sent completely, the last one could be sent partially
+        std::size_t left = written;
+        while (head < iov.size() && left >= iov[head].iov_len) {
+            left -= iov[head].iov_len;
+            head++;
+        }
+        if (left > 0) {
+            iov[head].iov_base = static_cast<char *>(iov[head].iov_base) + left;
+            iov[head].iov_len -= left;
+        }
+
+        // Response is sent once its terminator is
+        uint64_t now = Metrics::Clock::Now();
+        for (; sent < _origins.size() && 2 * sent + 1 < head; sent++) {
+            Metrics::RecordLatency(_origins[sent].op, _origins[sent].start, now);
+        }
+    }
+
+    _responses.clear();
+    _origins.clear();
+    _bytes = 0;
+}
+
+} // namespace Network
+} // namespace Afina
@@ -0,0 +1,66 @@
+#ifndef AFINA_NETWORK_RESPONSE_QUEUE_H
+#define AFINA_NETWORK_RESPONSE_QUEUE_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include <sys/types.h>
+
+#include <afina/metrics/Latency.h>
+
+namespace Afina {
+namespace Network {
+
+/**
+ * # Responses waiting to be sent by blocking server
+ * Blocking servers don't send each response right away. Responses to commands which came in one batch of input
+ * are collected and sent by a single writev once there is no more input ready, so pipelining client gets them in
+ * a few segments instead of one per command. Response is kept as it is, large value is never copied just to
+ * append line terminator. Latency of the command is recorded once its response is written to the socket, so time
+ * spent in the queue is counted
+ */
+class ResponseQueue {
+public:
+    ResponseQueue() : _bytes(0) {}
+
+    /**
+     * Adds response, line terminator is sent after it. Operation and time its first byte was read are kept to
+     * record latency once response is sent
+     */
+    void Push(std::string response, Metrics::Operation op, uint64_t start);
+
+    inline bool Empty() const { return _responses.empty(); }
+
+    /**
+     * Reads more input from the socket. If nothing is ready yet, queued responses are sent first and then read
+     * blocks as usual. Queue which has grown too large is sent right away. Returns result of recv(2), throws
+     * std::runtime_error if responses could not be sent
+     */
+    ssize_t Read(int socket, char *buffer, std::size_t size);
+
+    /**
+     * Sends all queued responses, blocks until done. Throws std::runtime_error on failure
+     */
+    void Flush(int socket);
+
+private:
+    // Queue is sent without waiting for input to run dry once it is that large
+    static const std::size_t kMaxResponses = 64;
+    static const std::size_t kMaxBytes = 64 * 1024;
+
+    // Command response is sent for, see Push
+    struct Origin {
+        Metrics::Operation op;
+        uint64_t start;
+    };
+
+    std::vector<std::string> _responses;
+    std::vector<Origin> _origins;
+    std::size_t _bytes;
+};
+
+} // namespace Network
+} // namespace Afina
+
+#endif // AFINA_NETWORK_RESPONSE_QUEUE_H
@@ -1,7 +1,10 @@
 #include "ServerImpl.h"
 
 #include <cassert>
+#include <chrono>
+#include <cstdio>
 #include <cstring>
+#include <functional>
 #include <iostream>
 #include <memory>
 #include <stdexcept>
@@ -20,15 +23,56 @@
 #include <afina/Storage.h>
 #include <afina/execute/Command.h>
 #include <afina/logging/Service.h>
+#include <afina/metrics/Latency.h>
+#include <afina/metrics/Metrics.h>
 
 #include <afina/concurrency/Executor.h>
 
+#include "network/InputBuffer.h"
+#include "network/ResponseQueue.h"
 #include "protocol/Parser.h"
 
 namespace Afina {
 namespace Network {
 namespace MTblocking {
 
+namespace {
+
+// Nanoseconds as microseconds with fraction
+std::string format_us(double ns) {
+    char buf[64];
+    snprintf(buf, sizeof(buf), "%.3f", ns / 1000.0);
+    return buf;
+}
+
+// Thread pool state for "stats executor"
+void report_executor(Concurrency::Executor &executor, std::vector<std::pair<std::string, std::string>> &values) {
+    Concurrency::Executor::Statistics s;
+    executor.GetStatistics(s);
+
+    values.emplace_back("threads_live", std::to_string(s.threads_live));
+    values.emplace_back("threads_free", std::to_string(s.threads_free));
+    values.emplace_back("threads_spawned", std::to_string(s.threads_spawned));
+    values.emplace_back("threads_retired", std::to_string(s.threads_retired));
+    values.emplace_back("queue_depth", std::to_string(s.queue_depth));
+    values.emplace_back("queue_depth_max", std::to_string(s.queue_depth_max));
+    values.emplace_back("tasks_rejected", std::to_string(s.tasks_rejected));
+    values.emplace_back("tasks_expired", std::to_string(s.tasks_expired));
+    values.emplace_back("tasks_completed", std::to_string(s.run_time.Count()));
+
+    const std::pair<const char *, const Metrics::Histogram *> times[] = {{"wait", &s.wait_time},
+                                                                          {"run", &s.run_time}};
+    for (auto &t : times) {
+        std::string prefix = std::string(t.first) + "_";
+        values.emplace_back(prefix + "mean_us", format_us(t.second->Mean()));
+        values.emplace_back(prefix + "p50_us", format_us(t.second->Percentile(50)));
+        values.emplace_back(prefix + "p99_us", format_us(t.second->Percentile(99)));
+        values.emplace_back(prefix + "max_us", format_us(t.second->Max()));
+    }
+}
+
+} // namespace
+
 // See Server.h
 ServerImpl::ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl) : Server(ps, pl) {}
 
@@ -51,7 +95,9 @@ void ServerImpl::Start(uint16_t port, uint32_t n_accept, uint32_t n_workers) {
     std::memset(&server_addr, 0, sizeof(server_addr));
     server_addr.sin_family = AF_INET;         // IPv4
     server_addr.sin_port = htons(port);       // TCP port number
-    server_addr.sin_addr.s_addr = INADDR_ANY; // Bind to any address
+    if (inet_pton(AF_INET, config.address.c_str(), &server_addr.sin_addr) != 1) {
+        throw std::runtime_error("Invalid address to listen on: " + config.address);
+    }
 
     _server_socket = socket(PF_INET, SOCK_STREAM, IPPROTO_TCP);
     if (_server_socket == -1) {
@@ -69,16 +115,20 @@ void ServerImpl::Start(uint16_t port, uint32_t n_accept, uint32_t n_workers) {
         throw std::runtime_error("Socket bind() failed");
     }
 
-    if (listen(_server_socket, 5) == -1) {
+    if (listen(_server_socket, config.backlog) == -1) {
         close(_server_socket);
         throw std::runtime_error("Socket listen() failed");
     }
 
-    // min 2 threads, max 4 threads,
-    // max 1 task in queue (to be able to check from only two terminals),
-    // 5 seconds idle time
-    _thread_pool.reset(new Afina::Concurrency::Executor(2, 4, 1, 5000));
+    // Each connection takes a thread for its whole life, so pool_max is the limit of concurrent connections
+    // and pool_queue is how many accepted ones could wait to be picked up by a thread. Even connection handed
+    // over to a free thread passes the queue, so it must hold at least one
+    _thread_pool.reset(new Afina::Concurrency::Executor(config.pool_min, config.pool_max, config.pool_queue,
+                                                        config.pool_idle_ms));
     _thread_pool->Start();
+    _report_id = Metrics::AddReport("executor", [this](std::vector<std::pair<std::string, std::string>> &values) {
+        report_executor(*_thread_pool, values);
+    });
 
     running.store(true);
     _thread = std::thread(&ServerImpl::OnRun, this);
@@ -99,6 +149,7 @@ void ServerImpl::Join() {
 
     _thread_pool->Stop(true);
 
+    Metrics::RemoveReport(_report_id);
     _thread_pool.reset();
 
     assert(_thread.joinable());
@@ -110,13 +161,13 @@ void ServerImpl::Join() {
 void ServerImpl::OnRun() {
     // Here is connection state
     // - parser: parse state of the stream
-    // - command_to_execute: last command parsed out of stream
+    // - command_to_execute: last command parsed out of stream, it is owned and reused by parser
     // - arg_remains: how many bytes to read from stream to get command argument
     // - argument_for_command: buffer stores argument
     std::size_t arg_remains;
 
     std::string argument_for_command;
-    std::unique_ptr<Execute::Command> command_to_execute;
+    Execute::Command *command_to_execute = nullptr;
     while (running.load()) {
         _logger->debug("waiting for connection...");
 
@@ -141,21 +192,26 @@ void ServerImpl::OnRun() {
             _logger->debug("Accepted connection on descriptor {} (host={}, port={})\n", client_socket, host, port);
         }
 
+        Metrics::Add(Metrics::kTotalConnections);
+
         // Configure read timeout
         {
             struct timeval tv;
-            tv.tv_sec = 5; // TODO: make it configurable
-            tv.tv_usec = 0;
+            tv.tv_sec = config.read_timeout_ms / 1000;
+            tv.tv_usec = (config.read_timeout_ms % 1000) * 1000;
             setsockopt(client_socket, SOL_SOCKET, SO_RCVTIMEO, (const char *)&tv, sizeof tv);
         }
 
-        // Push connection processing task into thread pool
-        if (!_thread_pool->Execute(&ServerImpl::OnCommand, this, client_socket)) {
-            static const std::string msg = "Failed to accept task\r\n";
-            if (send(client_socket, msg.data(), msg.size(), 0) <= 0) {
-                _logger->error("Failed to send response to client: {}", strerror(errno));
-            }
-            close(client_socket);
+        // Push connection processing task into thread pool. Connection that waited in the queue longer than
+        // read timeout is likely abandoned by the client already, so it is dropped instead of taking a thread
+        auto deadline = Concurrency::Executor::NoDeadline();
+        if (config.read_timeout_ms > 0) {
+            deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(config.read_timeout_ms);
+        }
+        if (!_thread_pool->Schedule(Concurrency::Executor::Priority::kNormal, deadline,
+                                    std::bind(&ServerImpl::OnCommand, this, client_socket),
+                                    std::bind(&ServerImpl::OnReject, this, client_socket))) {
+            OnReject(client_socket);
         }
     }
 
@@ -163,11 +219,27 @@ void ServerImpl::OnRun() {
     _logger->warn("Network stopped");
 }
 
+// See ServerImpl.h
+void ServerImpl::OnReject(int client_socket) {
+    Metrics::Add(Metrics::kRejectedConnections);
+    static const std::string msg = "Failed to accept task\r\n";
+    if (send(client_socket, msg.data(), msg.size(), 0) <= 0) {
+        _logger->error("Failed to send response to client: {}", strerror(errno));
+    }
+    close(client_socket);
+}
+
 void ServerImpl::OnCommand(int client_socket) {
+    Metrics::Add(Metrics::kCurrConnections);
+
     std::size_t arg_remains;
-    Protocol::Parser parser;
+    uint64_t command_start = 0;
+    Metrics::Operation command_op = Metrics::kOpOther;
+    Protocol::Parser parser(Protocol::Parser::Mode::kView);
     std::string argument_for_command;
-    std::unique_ptr<Execute::Command> command_to_execute;
+    Execute::Command *command_to_execute = nullptr;
+    InputBuffer input;
+    ResponseQueue output;
 
     // Process connection:
     // - read commands until socket alive
@@ -176,24 +248,31 @@ void ServerImpl::OnCommand(int client_socket) {
     try {
         while (running.load()) {
             int readed_bytes = -1;
-            char client_buffer[4096];
-            while ((readed_bytes = read(client_socket, client_buffer, sizeof(client_buffer))) > 0) {
+            while ((readed_bytes = output.Read(client_socket, input.Space(), input.Free())) > 0) {
+                input.Produce(readed_bytes);
                 _logger->debug("Got {} bytes from socket", readed_bytes);
+                Metrics::Add(Metrics::kBytesRead, readed_bytes);
+                uint64_t read_time = Metrics::Clock::Now();
 
                 // Single block of data readed from the socket could trigger inside actions a multiple times,
                 // for example:
                 // - read#0: [<command1 start>]
                 // - read#1: [<command1 end> <argument> <command2> <argument for command 2> <command3> ... ]
-                while (readed_bytes > 0) {
-                    _logger->debug("Process {} bytes", readed_bytes);
+                while (input.Size() > 0) {
+                    _logger->debug("Process {} bytes", input.Size());
                     // There is no command yet
                     if (!command_to_execute) {
+                        if (command_start == 0) {
+                            command_start = read_time;
+                        }
+
                         std::size_t parsed = 0;
-                        if (parser.Parse(client_buffer, readed_bytes, parsed)) {
+                        if (parser.Parse(input.Data(), input.Size(), parsed)) {
                             // There is no command to be launched, continue to parse input stream
                             // Here we are, current chunk finished some command, process it
                             _logger->debug("Found new command: {} in {} bytes", parser.Name(), parsed);
-                            command_to_execute = parser.Build(arg_remains);
+                            command_to_execute = parser.BuildInPlace(arg_remains);
+                            command_op = Metrics::OperationByName(parser.Name());
                             if (arg_remains > 0) {
                                 arg_remains += 2;
                             }
@@ -204,21 +283,23 @@ void ServerImpl::OnCommand(int client_socket) {
                         if (parsed == 0) {
                             break;
                         } else {
-                            std::memmove(client_buffer, client_buffer + parsed, readed_bytes - parsed);
-                            readed_bytes -= parsed;
+                            input.Consume(parsed);
                         }
                     }
 
                     // There is command, but we still wait for argument to arrive...
                     if (command_to_execute && arg_remains > 0) {
-                        _logger->debug("Fill argument: {} bytes of {}", readed_bytes, arg_remains);
-                        // There is some parsed command, and now we are reading argument
-                        std::size_t to_read = std::min(arg_remains, std::size_t(readed_bytes));
-                        argument_for_command.append(client_buffer, to_read);
-
-                        std::memmove(client_buffer, client_buffer + to_read, readed_bytes - to_read);
-                        arg_remains -= to_read;
-                        readed_bytes -= to_read;
+                        // Argument is taken in one piece once it is in the buffer, so the buffer grows to fit it
+                        if (input.Size() < arg_remains) {
+                            _logger->debug("Wait for argument: {} bytes of {}", input.Size(), arg_remains);
+                            input.Reserve(arg_remains);
+                            break;
+                        }
+
+                        // Trailing \r\n is not part of the value
+                        argument_for_command.assign(input.Data(), arg_remains - 2);
+                        input.Consume(arg_remains);
+                        arg_remains = 0;
                     }
 
                     // Thre is command & argument - RUN!
@@ -226,21 +307,24 @@ void ServerImpl::OnCommand(int client_socket) {
                         std::string result;
                         command_to_execute->Execute(*pStorage, argument_for_command, result);
 
-                        // Send response
-                        result += "\r\n";
-                        if (send(client_socket, result.data(), result.size(), 0) <= 0) {
-                            throw std::runtime_error("Failed to send response");
-                        }
+                        // Response and its latency wait until there is no more input ready, see ResponseQueue
+                        output.Push(std::move(result), command_op, command_start);
 
                         // Prepare for the next command
-                        command_to_execute.reset();
+                        command_to_execute = nullptr;
                         argument_for_command.resize(0);
                         parser.Reset();
+                        command_start = 0;
                     }
-                } // while (readed_bytes)
+                } // while (input.Size())
+
+                // Memory taken by a large argument is returned once it is processed
+                input.Shrink();
             }
 
             if (readed_bytes == 0) {
+                // Client could have closed only its side, responses are still expected
+                output.Flush(client_socket);
                 throw std::runtime_error("Connection closed");
             } else {
                 throw std::runtime_error(std::string(strerror(errno)));
@@ -248,9 +332,17 @@ void ServerImpl::OnCommand(int client_socket) {
         }
     } catch (std::runtime_error &ex) {
         _logger->error("Failed to process connection on descriptor {}: {}", client_socket, ex.what());
+
+        // Commands preceding the malformed one are executed already, client still gets their responses
+        try {
+            output.Flush(client_socket);
+        } catch (std::runtime_error &err) {
+            _logger->error("Failed to send responses on descriptor {}: {}", client_socket, err.what());
+        }
     }
 
     close(client_socket);
+    Metrics::Sub(Metrics::kCurrConnections);
 }
 
 } // namespace MTblocking
@@ -43,6 +43,12 @@ protected:
 
     void OnCommand(int client_socket);
 
+    /**
+     * Tells client that server is overloaded and closes connection, used both when thread pool rejects
+     * connection and when it waited in the queue for too long
+     */
+    void OnReject(int client_socket);
+
 private:
     // Logger instance
     std::shared_ptr<spdlog::logger> _logger;
@@ -61,6 +67,9 @@ private:
     // Thread pool
     std::unique_ptr<Afina::Concurrency::Executor> _thread_pool;
 
+    // Thread pool report registered in Metrics
+    int _report_id;
+
     // Number of worker threads and mutex with condvar for access
     std::mutex _work_mutex;
 };
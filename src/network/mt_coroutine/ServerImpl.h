@@ -0,0 +1,60 @@
+#ifndef AFINA_NETWORK_MT_COROUTINE_SERVER_H
+#define AFINA_NETWORK_MT_COROUTINE_SERVER_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <afina/network/Server.h>
+
+namespace spdlog {
+class logger;
+}
+
+namespace Afina {
+namespace Network {
+namespace MTcoroutine {
+
+// Forward declaration, see Worker.h
+class Worker;
+
+/**
+ * # Network resource manager implementation
+ * Coroutine per connection like STcoroutine::ServerImpl, but routines are spread over several threads: each
+ * worker runs own engine and epoll, accepts connections from shared server socket and takes ready routines
+ * from others once it has nothing to do. See Worker
+ */
+class ServerImpl : public Server {
+public:
+    ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl);
+    ~ServerImpl();
+
+    // See Server.h
+    void Start(uint16_t port, uint32_t, uint32_t workers) override;
+
+    // See Server.h
+    void Stop() override;
+
+    // See Server.h
+    void Join() override;
+
+private:
+    // Logger instance
+    std::shared_ptr<spdlog::logger> _logger;
+
+    // Server socket to accept connections on, shared between workers
+    int _server_socket;
+
+    // Flag is cleared on stop, workers check it on each IO
+    std::atomic<bool> _running;
+
+    // Threads serving connections
+    std::vector<std::unique_ptr<Worker>> _workers;
+};
+
+} // namespace MTcoroutine
+} // namespace Network
+} // namespace Afina
+
+#endif // AFINA_NETWORK_MT_COROUTINE_SERVER_H
@@ -0,0 +1,554 @@
+#include "Worker.h"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <netdb.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include <spdlog/logger.h>
+
+#include <afina/Storage.h>
+#include <afina/execute/Command.h>
+#include <afina/metrics/Latency.h>
+#include <afina/metrics/Metrics.h>
+
+#include "network/InputBuffer.h"
+#include "protocol/Parser.h"
+
+namespace Afina {
+namespace Network {
+namespace MTcoroutine {
+
+const uintptr_t Worker::kIdle;
+const uintptr_t Worker::kNotified;
+const std::size_t Worker::kStackSize;
+const int Worker::kMaxReadsWithoutWait;
+
+namespace {
+
+// Worker running in this thread
+thread_local Worker *current_worker = nullptr;
+
+} // namespace
+
+// See Worker.h
+Worker::Worker(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<spdlog::logger> pl,
+               const std::vector<std::unique_ptr<Worker>> &peers, const std::atomic<bool> &running)
+    : _pStorage(ps), _logger(pl), _peers(peers), _running(running), _server_socket(-1), _epoll_fd(-1),
+      _event_fd(-1), _keeper(nullptr), _stopped(false), _reads_without_wait(0), _victim(0), _thief(nullptr),
+      _incoming(0), _adopted_total(0) {}
+
+// See Worker.h
+Worker::~Worker() {
+    // Sockets retired after the owner has stopped are still here
+    for (Socket *socket : _sockets) {
+        delete socket;
+    }
+
+    if (_epoll_fd != -1) {
+        close(_epoll_fd);
+    }
+    if (_event_fd != -1) {
+        close(_event_fd);
+    }
+}
+
+// See Worker.h
+void Worker::Start(int server_socket) {
+    _server_socket = server_socket;
+
+    _epoll_fd = epoll_create1(0);
+    if (_epoll_fd == -1) {
+        throw std::runtime_error("Failed to create epoll file descriptor: " + std::string(strerror(errno)));
+    }
+
+    _event_fd = eventfd(0, EFD_NONBLOCK);
+    if (_event_fd == -1) {
+        throw std::runtime_error("Failed to create event file descriptor: " + std::string(strerror(errno)));
+    }
+
+    // Inbox has no routine waiting for it, it is recognized by null data pointer
+    struct epoll_event event;
+    event.events = EPOLLIN;
+    event.data.ptr = nullptr;
+    if (epoll_ctl(_epoll_fd, EPOLL_CTL_ADD, _event_fd, &event)) {
+        throw std::runtime_error("Failed to add file descriptor to epoll");
+    }
+
+    // Server socket is recognized by the worker itself as data, exclusive so that new connection wakes up single
+    // worker rather than all of them
+    event.events = EPOLLIN | EPOLLEXCLUSIVE;
+    event.data.ptr = this;
+    if (epoll_ctl(_epoll_fd, EPOLL_CTL_ADD, _server_socket, &event)) {
+        throw std::runtime_error("Failed to add file descriptor to epoll");
+    }
+
+    _thread = std::thread(&Worker::OnRun, this);
+}
+
+// See Worker.h
+void Worker::Stop() {
+    if (eventfd_write(_event_fd, 1)) {
+        throw std::runtime_error("Failed to wakeup worker");
+    }
+}
+
+// See Worker.h
+void Worker::Join() {
+    assert(_thread.joinable());
+    _thread.join();
+}
+
+// See Worker.h
+void Worker::OnRun() {
+    current_worker = this;
+    _engine.reset(new Afina::Coroutine::Engine(Afina::Coroutine::Engine::StackMode::kSeparate, kStackSize,
+                                               [this] { Idle(); }));
+
+    // Returns once keeper and all connections are done, that happens only after stop
+    _engine->start(&Worker::RunKeeper, this);
+    _engine.reset();
+    current_worker = nullptr;
+
+    _logger->warn("Worker stopped");
+}
+
+// See Worker.h
+void Worker::OnKeep() {
+    _keeper = _engine->current();
+    while (_running || _incoming > 0) {
+        _engine->block();
+    }
+    _keeper = nullptr;
+}
+
+// See Worker.h
+void Worker::OnAccept() {
+    for (;;) {
+        struct sockaddr client_addr;
+        socklen_t client_addr_len = sizeof(client_addr);
+        int client_socket = accept4(_server_socket, &client_addr, &client_addr_len, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (client_socket == -1) {
+            // Other worker could have taken connection first
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                _logger->error("Failed to accept socket: {}", strerror(errno));
+            }
+            break;
+        }
+
+        if (_logger->should_log(spdlog::level::debug)) {
+            std::string host = "unknown", port = "-1";
+
+            char hbuf[NI_MAXHOST], sbuf[NI_MAXSERV];
+            if (getnameinfo(&client_addr, client_addr_len, hbuf, sizeof(hbuf), sbuf, sizeof(sbuf),
+                            NI_NUMERICHOST | NI_NUMERICSERV) == 0) {
+                host = hbuf;
+                port = sbuf;
+            }
+            _logger->debug("Accepted connection on descriptor {} (host={}, port={})\n", client_socket, host, port);
+        }
+        Metrics::Add(Metrics::kTotalConnections);
+
+        try {
+            _engine->run(&Worker::RunConnection, this, int(client_socket));
+        } catch (std::runtime_error &ex) {
+            _logger->error("Failed to start routine for descriptor {}: {}", client_socket, ex.what());
+            Metrics::Add(Metrics::kRejectedConnections);
+            close(client_socket);
+        }
+    }
+}
+
+// See Worker.h
+void Worker::OnCommand(int client_socket) {
+    Socket *client = Register(client_socket);
+    if (client == nullptr) {
+        close(client_socket);
+        return;
+    }
+    Metrics::Add(Metrics::kCurrConnections);
+
+    std::size_t arg_remains;
+    uint64_t command_start = 0;
+    Metrics::Operation command_op = Metrics::kOpOther;
+    Protocol::Parser parser(Protocol::Parser::Mode::kView);
+    std::string argument_for_command;
+    Execute::Command *command_to_execute = nullptr;
+
+    // Process connection, same as in blocking server:
+    // - read commands until socket alive
+    // - execute each command
+    // - send response
+    try {
+        int readed_bytes = -1;
+        InputBuffer input;
+        while ((readed_bytes = Read(client, input.Space(), input.Free())) > 0) {
+            input.Produce(readed_bytes);
+            _logger->debug("Got {} bytes from socket", readed_bytes);
+            Metrics::Add(Metrics::kBytesRead, readed_bytes);
+            uint64_t read_time = Metrics::Clock::Now();
+
+            // Single block of data readed from the socket could trigger inside actions a multiple times, see
+            // MTblocking::ServerImpl::OnCommand
+            while (input.Size() > 0) {
+                // There is no command yet
+                if (!command_to_execute) {
+                    if (command_start == 0) {
+                        command_start = read_time;
+                    }
+
+                    std::size_t parsed = 0;
+                    if (parser.Parse(input.Data(), input.Size(), parsed)) {
+                        _logger->debug("Found new command: {} in {} bytes", parser.Name(), parsed);
+                        command_to_execute = parser.BuildInPlace(arg_remains);
+                        command_op = Metrics::OperationByName(parser.Name());
+                        if (arg_remains > 0) {
+                            arg_remains += 2;
+                        }
+                    }
+
+                    if (parsed == 0) {
+                        break;
+                    } else {
+                        input.Consume(parsed);
+                    }
+                }
+
+                // There is command, but we still wait for argument to arrive...
+                if (command_to_execute && arg_remains > 0) {
+                    // Argument is taken in one piece once it is in the buffer, so the buffer grows to fit it
+                    if (input.Size() < arg_remains) {
+                        input.Reserve(arg_remains);
+                        break;
+                    }
+
+                    // Trailing \r\n is not part of the value
+                    argument_for_command.assign(input.Data(), arg_remains - 2);
+                    input.Consume(arg_remains);
+                    arg_remains = 0;
+                }
+
+                // Thre is command & argument - RUN!
+                if (command_to_execute && arg_remains == 0) {
+                    std::string result;
+                    command_to_execute->Execute(*_pStorage, argument_for_command, result);
+
+                    // Send response
+                    result += "\r\n";
+                    if (Write(client, result.data(), result.size()) <= 0) {
+                        throw std::runtime_error("Failed to send response");
+                    }
+                    Metrics::Add(Metrics::kBytesWritten, result.size());
+                    Metrics::RecordLatency(command_op, command_start, Metrics::Clock::Now());
+
+                    // Prepare for the next command
+                    command_to_execute = nullptr;
+                    argument_for_command.resize(0);
+                    parser.Reset();
+                    command_start = 0;
+                }
+            } // while (input.Size())
+
+            // Memory taken by a large argument is returned once it is processed
+            input.Shrink();
+        }
+
+        if (readed_bytes == 0) {
+            _logger->debug("Connection on descriptor {} closed", client_socket);
+        } else if (errno == ECANCELED) {
+            _logger->debug("Close connection on descriptor {} due to stop", client_socket);
+        } else {
+            throw std::runtime_error(std::string(strerror(errno)));
+        }
+    } catch (std::runtime_error &ex) {
+        _logger->error("Failed to process connection on descriptor {}: {}", client_socket, ex.what());
+    }
+
+    Unregister(client);
+    Metrics::Sub(Metrics::kCurrConnections);
+}
+
+// See Worker.h
+__attribute__((noinline)) Worker *Worker::Current() { return current_worker; }
+
+// See Worker.h
+Worker::Socket *Worker::Register(int fd) {
+    Worker *self = Current();
+    Socket *socket = new Socket(fd, self);
+
+    // Edge triggered: routine always waits only after it got EAGAIN, so the next edge can't be missed
+    struct epoll_event event;
+    event.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+    event.data.ptr = socket;
+    if (epoll_ctl(self->_epoll_fd, EPOLL_CTL_ADD, fd, &event)) {
+        self->_logger->error("Failed to add descriptor {} to epoll: {}", fd, strerror(errno));
+        delete socket;
+        return nullptr;
+    }
+
+    self->_sockets.insert(socket);
+    return socket;
+}
+
+// See Worker.h
+void Worker::Unregister(Socket *socket) {
+    Worker *self = Current();
+    if (epoll_ctl(socket->owner->_epoll_fd, EPOLL_CTL_DEL, socket->fd, nullptr)) {
+        self->_logger->error("Failed to delete descriptor {} from epoll: {}", socket->fd, strerror(errno));
+    }
+    close(socket->fd);
+
+    // Owner could be in the middle of events batch that has this socket, so only it knows when socket is
+    // not referenced anymore
+    if (socket->owner == self) {
+        self->_sockets.erase(socket);
+        delete socket;
+    } else {
+        socket->owner->Retire(socket);
+    }
+}
+
+// See Worker.h
+void Worker::Wait(Socket *socket) {
+    Worker *self = Current();
+    self->_reads_without_wait = 0;
+
+    // There were events since the last attempt, worth to try once more
+    uintptr_t expected = kNotified;
+    if (socket->state.compare_exchange_strong(expected, kIdle)) {
+        return;
+    }
+
+    Waiter waiter{self->_engine->current(), self};
+    expected = kIdle;
+    if (!socket->state.compare_exchange_strong(expected, reinterpret_cast<uintptr_t>(&waiter))) {
+        // Events came just now
+        socket->state = kIdle;
+        return;
+    }
+
+    // Stop could happen before waiter has been published, then nobody is going to wake it up. Once owner took
+    // the waiter, it is going to wake routine up, so it must block to consume that
+    if (!self->_running) {
+        expected = reinterpret_cast<uintptr_t>(&waiter);
+        if (socket->state.compare_exchange_strong(expected, kIdle)) {
+            return;
+        }
+    }
+    self->_engine->block();
+}
+
+// See Worker.h
+ssize_t Worker::Read(Socket *socket, char *buf, std::size_t size) {
+    while (Current()->_running) {
+        ssize_t n = read(socket->fd, buf, size);
+        if (n >= 0) {
+            // Socket which always has data never blocks, so make sure other routines get their turn as well
+            Worker *self = Current();
+            if (++self->_reads_without_wait >= kMaxReadsWithoutWait) {
+                self->_reads_without_wait = 0;
+                self->Poll(0);
+                self->_engine->yield();
+            }
+            return n;
+        } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            Wait(socket);
+        } else if (errno != EINTR) {
+            return -1;
+        }
+    }
+
+    errno = ECANCELED;
+    return -1;
+}
+
+// See Worker.h
+ssize_t Worker::Write(Socket *socket, const char *buf, std::size_t size) {
+    std::size_t written = 0;
+    while (written < size) {
+        ssize_t n = send(socket->fd, buf + written, size - written, 0);
+        if (n > 0) {
+            written += n;
+        } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK) && Current()->_running) {
+            Wait(socket);
+        } else if (n < 0 && errno == EINTR) {
+            continue;
+        } else {
+            return -1;
+        }
+    }
+    return written;
+}
+
+// See Worker.h
+void Worker::Poll(int timeout) {
+    std::array<struct epoll_event, 64> events;
+    int n = epoll_wait(_epoll_fd, &events[0], events.size(), timeout);
+    if (n == -1 && errno != EINTR) {
+        throw std::runtime_error("Failed to wait for events: " + std::string(strerror(errno)));
+    }
+
+    bool inbox = false, accept = false;
+    for (int i = 0; i < n; i++) {
+        void *data = events[i].data.ptr;
+        if (data == nullptr) {
+            inbox = true;
+        } else if (data == this) {
+            accept = true;
+        } else {
+            Notify(static_cast<Socket *>(data));
+        }
+    }
+
+    // Inbox is processed after the whole batch, retired sockets could be in it
+    if (inbox) {
+        eventfd_t value;
+        eventfd_read(_event_fd, &value);
+        Drain();
+    }
+    if (accept && _running) {
+        OnAccept();
+    }
+    Share();
+}
+
+// See Worker.h
+void Worker::Idle() {
+    // Ask the next worker in turn, those who has been asked by someone else already are skipped
+    std::size_t n = _peers.size();
+    if (_running && n > 1) {
+        Worker *victim = _peers[_victim++ % n].get();
+        if (victim == this) {
+            victim = _peers[_victim++ % n].get();
+        }
+
+        Worker *expected = nullptr;
+        victim->_thief.compare_exchange_strong(expected, this);
+    }
+    Poll(-1);
+}
+
+// See Worker.h
+void Worker::Notify(Socket *socket) {
+    uintptr_t state = socket->state.exchange(kNotified);
+    if (state == kIdle || state == kNotified) {
+        return;
+    }
+
+    // Only owner notifies, so nobody else could change state until waiter is woken up. Routine is going to
+    // retry right away, no need to keep notification for it
+    Waiter *waiter = reinterpret_cast<Waiter *>(state);
+    void *routine = waiter->routine;
+    Worker *worker = waiter->worker;
+    socket->state = kIdle;
+
+    if (worker == this) {
+        _engine->unblock(routine);
+    } else {
+        worker->Wake(routine);
+    }
+}
+
+// See Worker.h
+void Worker::Drain() {
+    {
+        std::unique_lock<std::mutex> lock(_inbox_mutex);
+        std::swap(_inbox, _drained);
+    }
+
+    for (void *routine : _drained.wakeups) {
+        _engine->unblock(routine);
+    }
+    for (void *routine : _drained.handoffs) {
+        _engine->adopt(routine);
+    }
+    if (!_drained.handoffs.empty()) {
+        _logger->debug("Adopted {} routines", _drained.handoffs.size());
+        _adopted_total.fetch_add(_drained.handoffs.size(), std::memory_order_relaxed);
+        _incoming -= _drained.handoffs.size();
+    }
+
+    // Stop: wake up everyone who waits on sockets of this worker, each routine finishes as soon as it sees
+    // the flag. Those waiting elsewhere are woken up by their owners
+    if (!_running && !_stopped) {
+        _logger->debug("Stop all routines");
+        _stopped = true;
+        epoll_ctl(_epoll_fd, EPOLL_CTL_DEL, _server_socket, nullptr);
+        for (Socket *socket : _sockets) {
+            Notify(socket);
+        }
+    }
+
+    for (Socket *socket : _drained.retired) {
+        _sockets.erase(socket);
+        delete socket;
+    }
+
+    if (_stopped && _incoming == 0) {
+        _engine->unblock(_keeper);
+    }
+
+    _drained.wakeups.clear();
+    _drained.handoffs.clear();
+    _drained.retired.clear();
+}
+
+// See Worker.h
+void Worker::Share() {
+    Worker *thief = _thief.load(std::memory_order_relaxed);
+    if (thief == nullptr) {
+        return;
+    }
+
+    // Thief must know that routine is on its way before it could see stop, otherwise it may finish before
+    // routine arrives
+    thief->_incoming++;
+    void *routine = _running ? _engine->detach() : nullptr;
+    if (routine == nullptr) {
+        thief->_incoming--;
+        return;
+    }
+
+    _thief = nullptr;
+    thief->Handoff(routine);
+}
+
+// See Worker.h
+void Worker::Wake(void *routine) {
+    {
+        std::unique_lock<std::mutex> lock(_inbox_mutex);
+        _inbox.wakeups.push_back(routine);
+    }
+    eventfd_write(_event_fd, 1);
+}
+
+// See Worker.h
+void Worker::Handoff(void *routine) {
+    {
+        std::unique_lock<std::mutex> lock(_inbox_mutex);
+        _inbox.handoffs.push_back(routine);
+    }
+    eventfd_write(_event_fd, 1);
+}
+
+// See Worker.h
+void Worker::Retire(Socket *socket) {
+    {
+        std::unique_lock<std::mutex> lock(_inbox_mutex);
+        _inbox.retired.push_back(socket);
+    }
+    eventfd_write(_event_fd, 1);
+}
+
+} // namespace MTcoroutine
+} // namespace Network
+} // namespace Afina
@@ -0,0 +1,226 @@
+#ifndef AFINA_NETWORK_MT_COROUTINE_WORKER_H
+#define AFINA_NETWORK_MT_COROUTINE_WORKER_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include <afina/coroutine/Engine.h>
+
+namespace spdlog {
+class logger;
+}
+
+namespace Afina {
+
+// Forward declaration, see afina/Storage.h
+class Storage;
+
+namespace Network {
+namespace MTcoroutine {
+
+/**
+ * # Thread running coroutine engine
+ * Each worker has own engine, epoll and eventfd. Worker accepts connections from the shared server socket and
+ * starts a routine for each of them, routine serves connection same way as in STcoroutine::ServerImpl.
+ *
+ * Once worker has nothing to run it asks some other worker to share load. Asked worker gives away one of its
+ * ready routines next time it gets control, the routine continues in the thread of the one who asked.
+ * Socket stays registered in the epoll of the worker which has accepted it, so event for the routine moved to
+ * other worker is passed to its new owner through the inbox and eventfd. The same way moved routine returns its
+ * socket to the original worker once connection is done
+ *
+ * Routine which could move between threads must not remember anything thread specific across blocking calls,
+ * so all of the IO helpers look up worker running in the calling thread instead of using "this"
+ */
+class Worker {
+public:
+    Worker(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<spdlog::logger> pl,
+           const std::vector<std::unique_ptr<Worker>> &peers, const std::atomic<bool> &running);
+    ~Worker();
+
+    /**
+     * Spawns background thread accepting connections from the given server socket and serving them
+     */
+    void Start(int server_socket);
+
+    /**
+     * Wakes up background thread, so that it notices that server is not running anymore. Routines get
+     * ECANCELED from their IO and finish, thread stops once all routines are done
+     */
+    void Stop();
+
+    /**
+     * Blocks calling thread until background one is done
+     */
+    void Join();
+
+    /**
+     * Number of routines this worker has received from others
+     */
+    uint64_t Adopted() const { return _adopted_total.load(std::memory_order_relaxed); }
+
+protected:
+    /**
+     * Method executing by background thread
+     */
+    void OnRun();
+
+    /**
+     * Routine which is never given away: keeps engine running while server is running, even if there are no
+     * connections at all
+     */
+    void OnKeep();
+
+    /**
+     * Accepts all pending connections and starts routine for each of them
+     */
+    void OnAccept();
+
+    /**
+     * Routine serving single connection. Could continue on some other worker, so uses only services shared by
+     * all workers
+     */
+    void OnCommand(int client_socket);
+
+private:
+    Worker(const Worker &) = delete;
+    Worker &operator=(const Worker &) = delete;
+
+    // Routine blocked on socket and its worker at the moment it blocked, lives on the routine stack
+    struct Waiter {
+        void *routine;
+        Worker *worker;
+    };
+
+    // Socket registered in the epoll of its owner. State is either kIdle, kNotified or a pointer to the Waiter
+    struct Socket {
+        Socket(int fd, Worker *owner) : fd(fd), owner(owner), state(kIdle) {}
+
+        int fd;
+        Worker *owner;
+        std::atomic<uintptr_t> state;
+    };
+
+    // Things other workers have passed to this one
+    struct Inbox {
+        std::vector<void *> wakeups;
+        std::vector<void *> handoffs;
+        std::vector<Socket *> retired;
+    };
+
+    // Socket got events since routine tried it the last time
+    static const uintptr_t kIdle = 0;
+    static const uintptr_t kNotified = 1;
+
+    // Stack of every routine, reserved but committed only as much as used
+    static const std::size_t kStackSize = 128 * 1024;
+
+    // See STcoroutine::ServerImpl::kMaxReadsWithoutWait
+    static const int kMaxReadsWithoutWait = 2;
+
+    static void RunKeeper(Worker *worker) { worker->OnKeep(); }
+    static void RunConnection(Worker *worker, int client_socket) { worker->OnCommand(client_socket); }
+
+    // Worker running in the calling thread
+    static Worker *Current();
+
+    // Registers socket in the epoll of the current worker, edge triggered on both directions
+    static Socket *Register(int fd);
+
+    // Removes socket from epoll of its owner and closes it. Socket itself is freed by the owner
+    static void Unregister(Socket *socket);
+
+    // Blocks current routine until socket has some events
+    static void Wait(Socket *socket);
+
+    // Like read(2)/send(2) but blocking only current routine. Return -1 with ECANCELED once server is stopping
+    static ssize_t Read(Socket *socket, char *buf, std::size_t size);
+    static ssize_t Write(Socket *socket, const char *buf, std::size_t size);
+
+    // Waits for events up to timeout ms and unblocks routines interested in them
+    void Poll(int timeout);
+
+    // Called by engine once all routines are blocked: asks some other worker for work and waits for events
+    void Idle();
+
+    // Wakes up routine waiting for the socket, wherever it is
+    void Notify(Socket *socket);
+
+    // Processes everything other workers have sent to this one
+    void Drain();
+
+    // Gives one of ready routines to the worker that asked for it, if there is some to spare
+    void Share();
+
+    // Pass something to this worker from other thread
+    void Wake(void *routine);
+    void Handoff(void *routine);
+    void Retire(Socket *socket);
+
+    // afina services
+    std::shared_ptr<Afina::Storage> _pStorage;
+
+    // Logger to be used
+    std::shared_ptr<spdlog::logger> _logger;
+
+    // All workers of the server, including this one
+    const std::vector<std::unique_ptr<Worker>> &_peers;
+
+    // Flag is cleared by server on stop
+    const std::atomic<bool> &_running;
+
+    // Server socket, shared between workers
+    int _server_socket;
+
+    // Descriptor of epoll for sockets accepted by this worker
+    int _epoll_fd;
+
+    // Custom event "device" used to wakeup worker when inbox gets something
+    int _event_fd;
+
+    // Engine running routines, lives in worker thread
+    std::unique_ptr<Afina::Coroutine::Engine> _engine;
+
+    // Routine started by OnRun, it is blocked until stop
+    void *_keeper;
+
+    // Worker has seen stop and woke up everyone
+    bool _stopped;
+
+    // Reads done since the last time any routine waited for events
+    int _reads_without_wait;
+
+    // Next worker to ask for work
+    std::size_t _victim;
+
+    // Sockets registered by this worker, accessed only by its thread
+    std::set<Socket *> _sockets;
+
+    // Inbox filled by other workers and its copy being processed by this one, see Drain
+    std::mutex _inbox_mutex;
+    Inbox _inbox;
+    Inbox _drained;
+
+    // Worker that waits for some routine from this one, nullptr if none
+    std::atomic<Worker *> _thief;
+
+    // Routines being passed to this worker, it can't stop until all of them arrive
+    std::atomic<int> _incoming;
+
+    // See Adopted()
+    std::atomic<uint64_t> _adopted_total;
+
+    // Thread serving routines of this worker
+    std::thread _thread;
+};
+
+} // namespace MTcoroutine
+} // namespace Network
+} // namespace Afina
+
+#endif // AFINA_NETWORK_MT_COROUTINE_WORKER_H
@@ -1,38 +1,19 @@
 #ifndef AFINA_NETWORK_MT_NONBLOCKING_CONNECTION_H
 #define AFINA_NETWORK_MT_NONBLOCKING_CONNECTION_H
 
-#include <cstring>
-
-#include <sys/epoll.h>
+#include "network/st_nonblocking/Connection.h"
 
 namespace Afina {
 namespace Network {
 namespace MTnonblock {
 
-class Connection {
-public:
-    Connection(int s) : _socket(s) {
-        std::memset(&_event, 0, sizeof(struct epoll_event));
-        _event.data.ptr = this;
-    }
-
-    inline bool isAlive() const { return true; }
-
-    void Start();
-
-protected:
-    void OnError();
-    void OnClose();
-    void DoRead();
-    void DoWrite();
-
-private:
-    friend class Worker;
-    friend class ServerImpl;
-
-    int _socket;
-    struct epoll_event _event;
-};
+/**
+ * # Client connection state
+ * Same as STnonblock::Connection, but served by a pool of workers sharing single epoll. Connection is
+ * registered with EPOLLONESHOT, so only one worker at a time processes its events and nothing there needs locks.
+ * Worker rearms connection once it is done with the event
+ */
+using Connection = STnonblock::Connection;
 
 } // namespace MTnonblock
 } // namespace Network
@@ -20,6 +20,7 @@
 
 #include <afina/Storage.h>
 #include <afina/logging/Service.h>
+#include <afina/metrics/Metrics.h>
 
 #include "Connection.h"
 #include "Utils.h"
@@ -52,15 +53,19 @@ void ServerImpl::Start(uint16_t port, uint32_t n_acceptors, uint32_t n_workers)
     std::memset(&server_addr, 0, sizeof(server_addr));
     server_addr.sin_family = AF_INET;         // IPv4
     server_addr.sin_port = htons(port);       // TCP port number
-    server_addr.sin_addr.s_addr = INADDR_ANY; // Bind to any address
+    if (inet_pton(AF_INET, config.address.c_str(), &server_addr.sin_addr) != 1) {
+        throw std::runtime_error("Invalid address to listen on: " + config.address);
+    }
 
     _server_socket = socket(PF_INET, SOCK_STREAM, IPPROTO_TCP);
     if (_server_socket == -1) {
         throw std::runtime_error("Failed to open socket: " + std::string(strerror(errno)));
     }
 
+    // Port stays in TIME_WAIT after restart while there are connections closed by the server, see STblocking
     int opts = 1;
-    if (setsockopt(_server_socket, SOL_SOCKET, (SO_KEEPALIVE), &opts, sizeof(opts)) == -1) {
+    if (setsockopt(_server_socket, SOL_SOCKET, SO_REUSEADDR, &opts, sizeof(opts)) == -1 ||
+        setsockopt(_server_socket, SOL_SOCKET, SO_KEEPALIVE, &opts, sizeof(opts)) == -1) {
         close(_server_socket);
         throw std::runtime_error("Socket setsockopt() failed: " + std::string(strerror(errno)));
     }
@@ -71,7 +76,7 @@ void ServerImpl::Start(uint16_t port, uint32_t n_acceptors, uint32_t n_workers)
     }
 
     make_socket_non_blocking(_server_socket);
-    if (listen(_server_socket, 5) == -1) {
+    if (listen(_server_socket, config.backlog) == -1) {
         close(_server_socket);
         throw std::runtime_error("Socket listen() failed: " + std::string(strerror(errno)));
     }
@@ -130,6 +135,10 @@ void ServerImpl::Join() {
     for (auto &w : _workers) {
         w.Join();
     }
+
+    close(_data_epoll_fd);
+    close(_event_fd);
+    close(_server_socket);
 }
 
 // See ServerImpl.h
@@ -193,23 +202,23 @@ void ServerImpl::OnRun() {
                 }
 
                 // Register the new FD to be monitored by epoll.
-                Connection *pc = new Connection(infd);
-                if (pc == nullptr) {
-                    throw std::runtime_error("Failed to allocate connection");
-                }
+                Connection *pc = new Connection(infd, pStorage, _logger);
+                Metrics::Add(Metrics::kTotalConnections);
 
-                // Register connection in worker's epoll
+                // Register connection in worker's epoll, oneshot so that it is processed by single worker at time
                 pc->Start();
                 if (pc->isAlive()) {
                     pc->_event.events |= EPOLLONESHOT;
-                    if (epoll_ctl(_data_epoll_fd, EPOLL_CTL_MOD, pc->_socket, &pc->_event)) {
+                    if (epoll_ctl(_data_epoll_fd, EPOLL_CTL_ADD, pc->_socket, &pc->_event)) {
                         pc->OnError();
+                        close(pc->_socket);
                         delete pc;
                     }
                 }
             }
         }
     }
+    close(acceptor_epoll);
     _logger->warn("Acceptor stopped");
 }
 
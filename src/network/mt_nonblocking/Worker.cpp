@@ -2,12 +2,12 @@
 
 #include <cassert>
 #include <functional>
-#include <iostream>
 
 #include <netdb.h>
 #include <sys/epoll.h>
 #include <sys/socket.h>
 #include <sys/types.h>
+#include <unistd.h>
 
 #include <spdlog/logger.h>
 
@@ -22,14 +22,10 @@ namespace MTnonblock {
 
 // See Worker.h
 Worker::Worker(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Afina::Logging::Service> pl)
-    : _pStorage(ps), _pLogging(pl), isRunning(false), _epoll_fd(-1) {
-    // TODO: implementation here
-}
+    : _pStorage(ps), _pLogging(pl), isRunning(false), _epoll_fd(-1) {}
 
 // See Worker.h
-Worker::~Worker() {
-    // TODO: implementation here
-}
+Worker::~Worker() {}
 
 // See Worker.h
 Worker::Worker(Worker &&other) { *this = std::move(other); }
@@ -41,6 +37,7 @@ Worker &Worker::operator=(Worker &&other) {
     _logger = std::move(other._logger);
     _thread = std::move(other._thread);
     _epoll_fd = other._epoll_fd;
+    isRunning = other.isRunning.load();
 
     other._epoll_fd = -1;
     return *this;
@@ -94,11 +91,10 @@ void Worker::OnRun() {
             Connection *pconn = static_cast<Connection *>(current_event.data.ptr);
             if ((current_event.events & EPOLLERR) || (current_event.events & EPOLLHUP)) {
                 pconn->OnError();
-            } else if (current_event.events & EPOLLRDHUP) {
-                pconn->OnClose();
             } else {
-                // Depends on what connection wants...
-                if (current_event.events & EPOLLIN) {
+                // Depends on what connection wants... Half closed connection is served until EOF and responses
+                // are sent, see STnonblock::ServerImpl::OnRun
+                if (current_event.events & (EPOLLIN | EPOLLRDHUP)) {
                     pconn->DoRead();
                 }
                 if (current_event.events & EPOLLOUT) {
@@ -106,23 +102,22 @@ void Worker::OnRun() {
                 }
             }
 
-            // Rearm connection
+            // Rearm connection, from now on some other worker could get it
             if (pconn->isAlive()) {
                 pconn->_event.events |= EPOLLONESHOT;
-                if (epoll_ctl(_epoll_fd, EPOLL_CTL_MOD, pconn->_socket, &pconn->_event)) {
-                    pconn->OnError();
-                    delete pconn;
+                if (epoll_ctl(_epoll_fd, EPOLL_CTL_MOD, pconn->_socket, &pconn->_event) == 0) {
+                    continue;
                 }
+                _logger->error("Failed to rearm connection on descriptor {}", pconn->_socket);
             }
+
             // Or delete closed one
-            else {
-                if (epoll_ctl(_epoll_fd, EPOLL_CTL_DEL, pconn->_socket, &pconn->_event)) {
-                    std::cerr << "Failed to delete connection!" << std::endl;
-                }
-                delete pconn;
+            if (epoll_ctl(_epoll_fd, EPOLL_CTL_DEL, pconn->_socket, &pconn->_event)) {
+                _logger->error("Failed to delete connection from epoll");
             }
+            close(pconn->_socket);
+            delete pconn;
         }
-        // TODO: Select timeout...
     }
     _logger->warn("Worker stopped");
 }
@@ -20,7 +20,11 @@
 #include <afina/Storage.h>
 #include <afina/execute/Command.h>
 #include <afina/logging/Service.h>
+#include <afina/metrics/Latency.h>
+#include <afina/metrics/Metrics.h>
 
+#include "network/InputBuffer.h"
+#include "network/ResponseQueue.h"
 #include "protocol/Parser.h"
 
 namespace Afina {
@@ -61,7 +65,9 @@ void ServerImpl::Start(uint16_t port, uint32_t n_accept, uint32_t n_workers) {
     std::memset(&server_addr, 0, sizeof(server_addr));
     server_addr.sin_family = AF_INET;         // IPv4
     server_addr.sin_port = htons(port);       // TCP port number
-    server_addr.sin_addr.s_addr = INADDR_ANY; // Bind to any address
+    if (inet_pton(AF_INET, config.address.c_str(), &server_addr.sin_addr) != 1) {
+        throw std::runtime_error("Invalid address to listen on: " + config.address);
+    }
 
     // Arguments are:
     // - Family: IPv4
@@ -96,7 +102,7 @@ void ServerImpl::Start(uint16_t port, uint32_t n_accept, uint32_t n_workers) {
     // connections that we'll allow to queue up. Note that listen() doesn't block until
     // incoming connections arrive. It just makesthe OS aware that this process is willing
     // to accept connections on this socket (which is bound to a specific IP and port)
-    if (listen(_server_socket, 5) == -1) {
+    if (listen(_server_socket, config.backlog) == -1) {
         close(_server_socket);
         throw std::runtime_error("Socket listen() failed");
     }
@@ -122,13 +128,16 @@ void ServerImpl::Join() {
 void ServerImpl::OnRun() {
     // Here is connection state
     // - parser: parse state of the stream
-    // - command_to_execute: last command parsed out of stream
+    // - command_to_execute: last command parsed out of stream, it is owned and reused by parser
     // - arg_remains: how many bytes to read from stream to get command argument
     // - argument_for_command: buffer stores argument
+    // - command_start, command_op: when first byte of the command was read and its type, for latency tracking
     std::size_t arg_remains;
-    Protocol::Parser parser;
+    uint64_t command_start = 0;
+    Metrics::Operation command_op = Metrics::kOpOther;
+    Protocol::Parser parser(Protocol::Parser::Mode::kView);
     std::string argument_for_command;
-    std::unique_ptr<Execute::Command> command_to_execute;
+    Execute::Command *command_to_execute = nullptr;
     while (running.load()) {
         _logger->debug("waiting for connection...");
 
@@ -153,11 +162,14 @@ void ServerImpl::OnRun() {
             _logger->debug("Accepted connection on descriptor {} (host={}, port={})\n", client_socket, host, port);
         }
 
+        Metrics::Add(Metrics::kTotalConnections);
+        Metrics::Add(Metrics::kCurrConnections);
+
         // Configure read timeout
         {
             struct timeval tv;
-            tv.tv_sec = 5; // TODO: make it configurable
-            tv.tv_usec = 0;
+            tv.tv_sec = config.read_timeout_ms / 1000;
+            tv.tv_usec = (config.read_timeout_ms % 1000) * 1000;
             setsockopt(client_socket, SOL_SOCKET, SO_RCVTIMEO, (const char *)&tv, sizeof tv);
         }
 
@@ -165,26 +177,35 @@ void ServerImpl::OnRun() {
         // - read commands until socket alive
         // - execute each command
         // - send response
+        ResponseQueue output;
         try {
             int readed_bytes = -1;
-            char client_buffer[4096];
-            while ((readed_bytes = read(client_socket, client_buffer, sizeof(client_buffer))) > 0) {
+            InputBuffer input;
+            while ((readed_bytes = output.Read(client_socket, input.Space(), input.Free())) > 0) {
+                input.Produce(readed_bytes);
                 _logger->debug("Got {} bytes from socket", readed_bytes);
+                Metrics::Add(Metrics::kBytesRead, readed_bytes);
+                uint64_t read_time = Metrics::Clock::Now();
 
                 // Single block of data readed from the socket could trigger inside actions a multiple times,
                 // for example:
                 // - read#0: [<command1 start>]
                 // - read#1: [<command1 end> <argument> <command2> <argument for command 2> <command3> ... ]
-                while (readed_bytes > 0) {
-                    _logger->debug("Process {} bytes", readed_bytes);
+                while (input.Size() > 0) {
+                    _logger->debug("Process {} bytes", input.Size());
                     // There is no command yet
                     if (!command_to_execute) {
+                        if (command_start == 0) {
+                            command_start = read_time;
+                        }
+
                         std::size_t parsed = 0;
-                        if (parser.Parse(client_buffer, readed_bytes, parsed)) {
+                        if (parser.Parse(input.Data(), input.Size(), parsed)) {
                             // There is no command to be launched, continue to parse input stream
                             // Here we are, current chunk finished some command, process it
                             _logger->debug("Found new command: {} in {} bytes", parser.Name(), parsed);
-                            command_to_execute = parser.Build(arg_remains);
+                            command_to_execute = parser.BuildInPlace(arg_remains);
+                            command_op = Metrics::OperationByName(parser.Name());
                             if (arg_remains > 0) {
                                 arg_remains += 2;
                             }
@@ -195,21 +216,23 @@ void ServerImpl::OnRun() {
                         if (parsed == 0) {
                             break;
                         } else {
-                            std::memmove(client_buffer, client_buffer + parsed, readed_bytes - parsed);
-                            readed_bytes -= parsed;
+                            input.Consume(parsed);
                         }
                     }
 
                     // There is command, but we still wait for argument to arrive...
                     if (command_to_execute && arg_remains > 0) {
-                        _logger->debug("Fill argument: {} bytes of {}", readed_bytes, arg_remains);
-                        // There is some parsed command, and now we are reading argument
-                        std::size_t to_read = std::min(arg_remains, std::size_t(readed_bytes));
-                        argument_for_command.append(client_buffer, to_read);
-
-                        std::memmove(client_buffer, client_buffer + to_read, readed_bytes - to_read);
-                        arg_remains -= to_read;
-                        readed_bytes -= to_read;
+                        // Argument is taken in one piece once it is in the buffer, so the buffer grows to fit it
+                        if (input.Size() < arg_remains) {
+                            _logger->debug("Wait for argument: {} bytes of {}", input.Size(), arg_remains);
+                            input.Reserve(arg_remains);
+                            break;
+                        }
+
+                        // Trailing \r\n is not part of the value
+                        argument_for_command.assign(input.Data(), arg_remains - 2);
+                        input.Consume(arg_remains);
+                        arg_remains = 0;
                     }
 
                     // Thre is command & argument - RUN!
@@ -219,36 +242,48 @@ void ServerImpl::OnRun() {
                         std::string result;
                         command_to_execute->Execute(*pStorage, argument_for_command, result);
 
-                        // Send response
-                        result += "\r\n";
-                        if (send(client_socket, result.data(), result.size(), 0) <= 0) {
-                            throw std::runtime_error("Failed to send response");
-                        }
+                        // Response and its latency wait until there is no more input ready, see ResponseQueue
+                        output.Push(std::move(result), command_op, command_start);
 
                         // Prepare for the next command
-                        command_to_execute.reset();
+                        command_to_execute = nullptr;
                         argument_for_command.resize(0);
                         parser.Reset();
+                        command_start = 0;
                     }
-                } // while (readed_bytes)
+                } // while (input.Size())
+
+                // Memory taken by a large argument is returned once it is processed
+                input.Shrink();
             }
 
             if (readed_bytes == 0) {
+                // Client could have closed only its side, responses are still expected
+                output.Flush(client_socket);
                 _logger->debug("Connection closed");
             } else {
                 throw std::runtime_error(std::string(strerror(errno)));
             }
         } catch (std::runtime_error &ex) {
             _logger->error("Failed to process connection on descriptor {}: {}", client_socket, ex.what());
+
+            // Commands preceding the malformed one are executed already, client still gets their responses
+            try {
+                output.Flush(client_socket);
+            } catch (std::runtime_error &err) {
+                _logger->error("Failed to send responses on descriptor {}: {}", client_socket, err.what());
+            }
         }
 
         // We are done with this connection
         close(client_socket);
+        Metrics::Sub(Metrics::kCurrConnections);
 
         // Prepare for the next command: just in case if connection was closed in the middle of executing something
-        command_to_execute.reset();
+        command_to_execute = nullptr;
         argument_for_command.resize(0);
         parser.Reset();
+        command_start = 0;
     }
 
     // Cleanup on exit...
@@ -0,0 +1,408 @@
+#include "ServerImpl.h"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include <spdlog/logger.h>
+
+#include <afina/Storage.h>
+#include <afina/execute/Command.h>
+#include <afina/logging/Service.h>
+#include <afina/metrics/Latency.h>
+#include <afina/metrics/Metrics.h>
+
+#include "network/InputBuffer.h"
+#include "protocol/Parser.h"
+
+namespace Afina {
+namespace Network {
+namespace STcoroutine {
+
+const std::size_t ServerImpl::kStackSize;
+const int ServerImpl::kMaxReadsWithoutWait;
+
+// See Server.h
+ServerImpl::ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl)
+    : Server(ps, pl), _server_socket(-1), _event_fd(-1), _epoll_fd(-1), _running(false), _reads_without_wait(0) {}
+
+// See Server.h
+ServerImpl::~ServerImpl() {}
+
+// See Server.h
+void ServerImpl::Start(uint16_t port, uint32_t n_accept, uint32_t n_workers) {
+    _logger = pLogging->select("network");
+    _logger->info("Start st_coroutine network service");
+
+    sigset_t sig_mask;
+    sigemptyset(&sig_mask);
+    sigaddset(&sig_mask, SIGPIPE);
+    if (pthread_sigmask(SIG_BLOCK, &sig_mask, NULL) != 0) {
+        throw std::runtime_error("Unable to mask SIGPIPE");
+    }
+
+    struct sockaddr_in server_addr;
+    std::memset(&server_addr, 0, sizeof(server_addr));
+    server_addr.sin_family = AF_INET;         // IPv4
+    server_addr.sin_port = htons(port);       // TCP port number
+    if (inet_pton(AF_INET, config.address.c_str(), &server_addr.sin_addr) != 1) {
+        throw std::runtime_error("Invalid address to listen on: " + config.address);
+    }
+
+    _server_socket = socket(PF_INET, SOCK_STREAM | SOCK_NONBLOCK, IPPROTO_TCP);
+    if (_server_socket == -1) {
+        throw std::runtime_error("Failed to open socket: " + std::string(strerror(errno)));
+    }
+
+    int opts = 1;
+    if (setsockopt(_server_socket, SOL_SOCKET, SO_REUSEADDR, &opts, sizeof(opts)) == -1) {
+        close(_server_socket);
+        throw std::runtime_error("Socket setsockopt() failed: " + std::string(strerror(errno)));
+    }
+
+    if (bind(_server_socket, (struct sockaddr *)&server_addr, sizeof(server_addr)) == -1) {
+        close(_server_socket);
+        throw std::runtime_error("Socket bind() failed: " + std::string(strerror(errno)));
+    }
+
+    if (listen(_server_socket, config.backlog) == -1) {
+        close(_server_socket);
+        throw std::runtime_error("Socket listen() failed: " + std::string(strerror(errno)));
+    }
+
+    _event_fd = eventfd(0, EFD_NONBLOCK);
+    if (_event_fd == -1) {
+        close(_server_socket);
+        throw std::runtime_error("Failed to create event file descriptor: " + std::string(strerror(errno)));
+    }
+
+    _epoll_fd = epoll_create1(0);
+    if (_epoll_fd == -1) {
+        close(_server_socket);
+        close(_event_fd);
+        throw std::runtime_error("Failed to create epoll file descriptor: " + std::string(strerror(errno)));
+    }
+
+    // Stop event has no routine waiting for it, it is recognized by null data pointer
+    struct epoll_event event;
+    event.events = EPOLLIN;
+    event.data.ptr = nullptr;
+    if (epoll_ctl(_epoll_fd, EPOLL_CTL_ADD, _event_fd, &event)) {
+        throw std::runtime_error("Failed to add file descriptor to epoll");
+    }
+
+    _running = true;
+    _thread = std::thread(&ServerImpl::OnRun, this);
+}
+
+// See Server.h
+void ServerImpl::Stop() {
+    _logger->warn("Stop network service");
+
+    // Wakeup thread that is sleeping on epoll_wait
+    if (eventfd_write(_event_fd, 1)) {
+        throw std::runtime_error("Failed to wakeup network thread");
+    }
+}
+
+// See Server.h
+void ServerImpl::Join() {
+    assert(_thread.joinable());
+    _thread.join();
+
+    close(_epoll_fd);
+    close(_event_fd);
+    close(_server_socket);
+}
+
+// See ServerImpl.h
+void ServerImpl::OnRun() {
+    _engine.reset(new Afina::Coroutine::Engine(Afina::Coroutine::Engine::StackMode::kSeparate, kStackSize,
+                                               [this] { Poll(-1); }));
+
+    // Returns once acceptor and all connections are done, that happens only after stop
+    _engine->start(&ServerImpl::RunAcceptor, this);
+    _engine.reset();
+
+    _logger->warn("Network stopped");
+}
+
+// See ServerImpl.h
+void ServerImpl::OnAccept() {
+    Socket *server = Register(_server_socket);
+    if (server == nullptr) {
+        return;
+    }
+
+    while (_running) {
+        struct sockaddr client_addr;
+        socklen_t client_addr_len = sizeof(client_addr);
+        int client_socket = accept4(_server_socket, &client_addr, &client_addr_len, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (client_socket == -1) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                Wait(server);
+            } else {
+                _logger->error("Failed to accept socket: {}", strerror(errno));
+            }
+            continue;
+        }
+
+        if (_logger->should_log(spdlog::level::debug)) {
+            std::string host = "unknown", port = "-1";
+
+            char hbuf[NI_MAXHOST], sbuf[NI_MAXSERV];
+            if (getnameinfo(&client_addr, client_addr_len, hbuf, sizeof(hbuf), sbuf, sizeof(sbuf),
+                            NI_NUMERICHOST | NI_NUMERICSERV) == 0) {
+                host = hbuf;
+                port = sbuf;
+            }
+            _logger->debug("Accepted connection on descriptor {} (host={}, port={})\n", client_socket, host, port);
+        }
+        Metrics::Add(Metrics::kTotalConnections);
+
+        try {
+            _engine->run(&ServerImpl::RunConnection, this, int(client_socket));
+        } catch (std::runtime_error &ex) {
+            _logger->error("Failed to start routine for descriptor {}: {}", client_socket, ex.what());
+            Metrics::Add(Metrics::kRejectedConnections);
+            close(client_socket);
+        }
+    }
+
+    // Server socket itself is closed in Join
+    epoll_ctl(_epoll_fd, EPOLL_CTL_DEL, server->fd, nullptr);
+    _sockets.erase(server);
+    delete server;
+}
+
+// See ServerImpl.h
+void ServerImpl::OnCommand(int client_socket) {
+    Socket *client = Register(client_socket);
+    if (client == nullptr) {
+        close(client_socket);
+        return;
+    }
+    Metrics::Add(Metrics::kCurrConnections);
+
+    std::size_t arg_remains;
+    uint64_t command_start = 0;
+    Metrics::Operation command_op = Metrics::kOpOther;
+    Protocol::Parser parser(Protocol::Parser::Mode::kView);
+    std::string argument_for_command;
+    Execute::Command *command_to_execute = nullptr;
+
+    // Process connection, same as in blocking server:
+    // - read commands until socket alive
+    // - execute each command
+    // - send response
+    try {
+        int readed_bytes = -1;
+        InputBuffer input;
+        while ((readed_bytes = Read(client, input.Space(), input.Free())) > 0) {
+            input.Produce(readed_bytes);
+            _logger->debug("Got {} bytes from socket", readed_bytes);
+            Metrics::Add(Metrics::kBytesRead, readed_bytes);
+            uint64_t read_time = Metrics::Clock::Now();
+
+            // Single block of data readed from the socket could trigger inside actions a multiple times, see
+            // MTblocking::ServerImpl::OnCommand
+            while (input.Size() > 0) {
+                // There is no command yet
+                if (!command_to_execute) {
+                    if (command_start == 0) {
+                        command_start = read_time;
+                    }
+
+                    std::size_t parsed = 0;
+                    if (parser.Parse(input.Data(), input.Size(), parsed)) {
+                        _logger->debug("Found new command: {} in {} bytes", parser.Name(), parsed);
+                        command_to_execute = parser.BuildInPlace(arg_remains);
+                        command_op = Metrics::OperationByName(parser.Name());
+                        if (arg_remains > 0) {
+                            arg_remains += 2;
+                        }
+                    }
+
+                    if (parsed == 0) {
+                        break;
+                    } else {
+                        input.Consume(parsed);
+                    }
+                }
+
+                // There is command, but we still wait for argument to arrive...
+                if (command_to_execute && arg_remains > 0) {
+                    // Argument is taken in one piece once it is in the buffer, so the buffer grows to fit it
+                    if (input.Size() < arg_remains) {
+                        input.Reserve(arg_remains);
+                        break;
+                    }
+
+                    // Trailing \r\n is not part of the value
+                    argument_for_command.assign(input.Data(), arg_remains - 2);
+                    input.Consume(arg_remains);
+                    arg_remains = 0;
+                }
+
+                // Thre is command & argument - RUN!
+                if (command_to_execute && arg_remains == 0) {
+                    std::string result;
+                    command_to_execute->Execute(*pStorage, argument_for_command, result);
+
+                    // Send response
+                    result += "\r\n";
+                    if (Write(client, result.data(), result.size()) <= 0) {
+                        throw std::runtime_error("Failed to send response");
+                    }
+                    Metrics::Add(Metrics::kBytesWritten, result.size());
+                    Metrics::RecordLatency(command_op, command_start, Metrics::Clock::Now());
+
+                    // Prepare for the next command
+                    command_to_execute = nullptr;
+                    argument_for_command.resize(0);
+                    parser.Reset();
+                    command_start = 0;
+                }
+            } // while (input.Size())
+
+            // Memory taken by a large argument is returned once it is processed
+            input.Shrink();
+        }
+
+        if (readed_bytes == 0) {
+            _logger->debug("Connection on descriptor {} closed", client_socket);
+        } else if (errno == ECANCELED) {
+            _logger->debug("Close connection on descriptor {} due to stop", client_socket);
+        } else {
+            throw std::runtime_error(std::string(strerror(errno)));
+        }
+    } catch (std::runtime_error &ex) {
+        _logger->error("Failed to process connection on descriptor {}: {}", client_socket, ex.what());
+    }
+
+    Unregister(client);
+    Metrics::Sub(Metrics::kCurrConnections);
+}
+
+// See ServerImpl.h
+ServerImpl::Socket *ServerImpl::Register(int fd) {
+    Socket *socket = new Socket{fd, nullptr};
+
+    // Edge triggered: routine always waits only after it got EAGAIN, so the next edge can't be missed
+    struct epoll_event event;
+    event.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+    event.data.ptr = socket;
+    if (epoll_ctl(_epoll_fd, EPOLL_CTL_ADD, fd, &event)) {
+        _logger->error("Failed to add descriptor {} to epoll: {}", fd, strerror(errno));
+        delete socket;
+        return nullptr;
+    }
+
+    _sockets.insert(socket);
+    return socket;
+}
+
+// See ServerImpl.h
+void ServerImpl::Unregister(Socket *socket) {
+    if (epoll_ctl(_epoll_fd, EPOLL_CTL_DEL, socket->fd, nullptr)) {
+        _logger->error("Failed to delete descriptor {} from epoll: {}", socket->fd, strerror(errno));
+    }
+    close(socket->fd);
+    _sockets.erase(socket);
+    delete socket;
+}
+
+// See ServerImpl.h
+void ServerImpl::Wait(Socket *socket) {
+    _reads_without_wait = 0;
+    socket->routine = _engine->current();
+    _engine->block();
+}
+
+// See ServerImpl.h
+void ServerImpl::Poll(int timeout) {
+    std::array<struct epoll_event, 64> events;
+    int n = epoll_wait(_epoll_fd, &events[0], events.size(), timeout);
+    if (n == -1 && errno != EINTR) {
+        throw std::runtime_error("Failed to wait for events: " + std::string(strerror(errno)));
+    }
+
+    for (int i = 0; i < n; i++) {
+        Socket *socket = static_cast<Socket *>(events[i].data.ptr);
+        if (socket == nullptr) {
+            // Stop: wake up everyone, each routine finishes as soon as it sees the flag
+            _logger->debug("Stop all routines");
+            _running = false;
+            for (Socket *s : _sockets) {
+                _engine->unblock(s->routine);
+                s->routine = nullptr;
+            }
+            continue;
+        }
+
+        if (socket->routine != nullptr) {
+            _engine->unblock(socket->routine);
+            socket->routine = nullptr;
+        }
+    }
+}
+
+// See ServerImpl.h
+ssize_t ServerImpl::Read(Socket *socket, char *buf, std::size_t size) {
+    while (_running) {
+        ssize_t n = read(socket->fd, buf, size);
+        if (n >= 0) {
+            // Socket which always has data never blocks, so make sure other routines get their turn as well
+            if (++_reads_without_wait >= kMaxReadsWithoutWait) {
+                _reads_without_wait = 0;
+                Poll(0);
+                _engine->yield();
+            }
+            return n;
+        } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            Wait(socket);
+        } else if (errno != EINTR) {
+            return -1;
+        }
+    }
+
+    errno = ECANCELED;
+    return -1;
+}
+
+// See ServerImpl.h
+ssize_t ServerImpl::Write(Socket *socket, const char *buf, std::size_t size) {
+    std::size_t written = 0;
+    while (written < size) {
+        ssize_t n = send(socket->fd, buf + written, size - written, 0);
+        if (n > 0) {
+            written += n;
+        } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK) && _running) {
+            Wait(socket);
+        } else if (n < 0 && errno == EINTR) {
+            continue;
+        } else {
+            return -1;
+        }
+    }
+    return written;
+}
+
+} // namespace STcoroutine
+} // namespace Network
+} // namespace Afina
@@ -0,0 +1,123 @@
+#ifndef AFINA_NETWORK_ST_COROUTINE_SERVER_H
+#define AFINA_NETWORK_ST_COROUTINE_SERVER_H
+
+#include <cstdint>
+#include <memory>
+#include <set>
+#include <thread>
+
+#include <afina/coroutine/Engine.h>
+#include <afina/network/Server.h>
+
+namespace spdlog {
+class logger;
+}
+
+namespace Afina {
+namespace Network {
+namespace STcoroutine {
+
+/**
+ * # Network resource manager implementation
+ * Server that is serving all connections in single thread, each connection is a coroutine. Connection code is
+ * a plain loop of read/execute/send, like in the blocking server, but when socket isn't ready the routine
+ * blocks in the engine instead of the thread. Once all routines are blocked engine waits for socket events
+ * with epoll and unblocks routines waiting on ready sockets
+ */
+class ServerImpl : public Server {
+public:
+    ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl);
+    ~ServerImpl();
+
+    // See Server.h
+    void Start(uint16_t port, uint32_t, uint32_t) override;
+
+    // See Server.h
+    void Stop() override;
+
+    // See Server.h
+    void Join() override;
+
+protected:
+    /**
+     * Method is running in the network thread, runs engine until all routines are done
+     */
+    void OnRun();
+
+    /**
+     * Routine accepting new connections and starting routine for each of them
+     */
+    void OnAccept();
+
+    /**
+     * Routine serving single connection
+     */
+    void OnCommand(int client_socket);
+
+private:
+    // Socket registered in epoll, along with routine waiting for it to become ready
+    struct Socket {
+        int fd;
+        void *routine;
+    };
+
+    // Stack of every routine, reserved but committed only as much as used
+    static const std::size_t kStackSize = 128 * 1024;
+
+    // Routine that keeps getting data without blocking lets others run after that many reads. Fast client
+    // often sends the next request before routine reads again, so without that single chatty connection
+    // could keep the thread for long while others wait for epoll to be polled
+    static const int kMaxReadsWithoutWait = 2;
+
+    static void RunAcceptor(ServerImpl *server) { server->OnAccept(); }
+    static void RunConnection(ServerImpl *server, int client_socket) { server->OnCommand(client_socket); }
+
+    // Registers socket in epoll, edge triggered on both directions
+    Socket *Register(int fd);
+
+    // Removes socket from epoll and closes it
+    void Unregister(Socket *socket);
+
+    // Blocks current routine until socket has some events
+    void Wait(Socket *socket);
+
+    // Waits for socket events up to timeout ms and unblocks routines interested in them
+    void Poll(int timeout);
+
+    // Like read(2)/send(2) but blocking only current routine. Return -1 with ECANCELED once server is stopping
+    ssize_t Read(Socket *socket, char *buf, std::size_t size);
+    ssize_t Write(Socket *socket, const char *buf, std::size_t size);
+
+    // Logger instance
+    std::shared_ptr<spdlog::logger> _logger;
+
+    // Server socket to accept connections on
+    int _server_socket;
+
+    // Custom event "device" used to wakeup network thread on stop
+    int _event_fd;
+
+    // Descriptor of epoll for all sockets
+    int _epoll_fd;
+
+    // Flag is changed only by network thread, once it sees stop event
+    bool _running;
+
+    // Reads done since the last time any routine waited for events
+    int _reads_without_wait;
+
+    // Engine running all routines, lives in network thread
+    std::unique_ptr<Afina::Coroutine::Engine> _engine;
+
+    // All registered sockets, to wake up everyone on stop
+    std::set<Socket *> _sockets;
+
+    // Thread to run network on
+    std::thread _thread;
+};
+
+} // namespace STcoroutine
+} // namespace Network
+} // namespace Afina
+
+#endif // AFINA_NETWORK_ST_COROUTINE_SERVER_H
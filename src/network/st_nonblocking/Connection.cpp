@@ -1,25 +1,191 @@
 #include "Connection.h"
 
-#include <iostream>
+#include <cerrno>
+#include <stdexcept>
+
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <spdlog/logger.h>
+
+#include <afina/Storage.h>
+#include <afina/metrics/Metrics.h>
 
 namespace Afina {
 namespace Network {
 namespace STnonblock {
 
+const std::size_t Connection::kMaxOutput;
+
+// See Connection.h
+Connection::~Connection() { Metrics::Sub(Metrics::kCurrConnections); }
+
 // See Connection.h
-void Connection::Start() { std::cout << "Start" << std::endl; }
+void Connection::Start() {
+    Metrics::Add(Metrics::kCurrConnections);
+    _event.events = EPOLLIN | EPOLLRDHUP | EPOLLERR;
+}
 
 // See Connection.h
-void Connection::OnError() { std::cout << "OnError" << std::endl; }
+void Connection::OnError() {
+    _logger->error("Failed to process connection on descriptor {}", _socket);
+    _alive = false;
+}
 
 // See Connection.h
-void Connection::OnClose() { std::cout << "OnClose" << std::endl; }
+void Connection::OnClose() {
+    _logger->debug("Connection on descriptor {} closed", _socket);
+    _alive = false;
+}
 
 // See Connection.h
-void Connection::DoRead() { std::cout << "DoRead" << std::endl; }
+void Connection::DoRead() {
+    try {
+        while (_output.size() < kMaxOutput) {
+            int readed_bytes = read(_socket, _input.Space(), _input.Free());
+            if (readed_bytes > 0) {
+                _logger->debug("Got {} bytes from socket", readed_bytes);
+                Metrics::Add(Metrics::kBytesRead, readed_bytes);
+                _input.Produce(readed_bytes);
+                Process();
+                continue;
+            }
+
+            if (readed_bytes == 0) {
+                _eof = true;
+            } else if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                throw std::runtime_error(std::string(strerror(errno)));
+            }
+            break;
+        }
+    } catch (std::runtime_error &ex) {
+        _logger->error("Failed to process connection on descriptor {}: {}", _socket, ex.what());
+        _alive = false;
+        return;
+    }
+
+    // Try to send responses right away, most of the time socket is writable and there is no need to wait
+    DoWrite();
+}
+
+// See Connection.h
+void Connection::DoWrite() {
+    while (!_output.empty()) {
+        struct iovec iov[64];
+        std::size_t iov_count = 0;
+        for (auto it = _output.begin(); it != _output.end() && iov_count < 64; it++, iov_count++) {
+            std::size_t offset = (iov_count == 0) ? _head_offset : 0;
+            iov[iov_count].iov_base = const_cast<char *>(it->data()) + offset;
+            iov[iov_count].iov_len = it->size() - offset;
+        }
+
+        ssize_t written = writev(_socket, iov, iov_count);
+        if (written < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                break;
+            }
+            _logger->error("Failed to send response on descriptor {}: {}", _socket, strerror(errno));
+            _alive = false;
+            return;
+        }
+        Metrics::Add(Metrics::kBytesWritten, written);
+
+        // Drop responses sent completely
+        std::size_t left = written;
+        uint64_t now = Metrics::Clock::Now();
+        while (left > 0 && left >= _output.front().size() - _head_offset) {
+            left -= _output.front().size() - _head_offset;
+            _output.pop_front();
+            _head_offset = 0;
+            Metrics::RecordLatency(_origins.front().op, _origins.front().start, now);
+            _origins.pop_front();
+        }
+        _head_offset += left;
+    }
+
+    if (_eof && _output.empty()) {
+        _alive = false;
+        return;
+    }
+    UpdateEvents();
+}
+
+// See Connection.h
+void Connection::Process() {
+    uint64_t read_time = Metrics::Clock::Now();
+
+    // Single block of data readed from the socket could trigger inside actions a multiple times, see
+    // MTblocking::ServerImpl::OnCommand
+    while (_input.Size() > 0) {
+        // There is no command yet
+        if (!_command_to_execute) {
+            if (_command_start == 0) {
+                _command_start = read_time;
+            }
+
+            std::size_t parsed = 0;
+            if (_parser.Parse(_input.Data(), _input.Size(), parsed)) {
+                _logger->debug("Found new command: {} in {} bytes", _parser.Name(), parsed);
+                _command_to_execute = _parser.BuildInPlace(_arg_remains);
+                _command_op = Metrics::OperationByName(_parser.Name());
+                if (_arg_remains > 0) {
+                    _arg_remains += 2;
+                }
+            }
+
+            if (parsed == 0) {
+                break;
+            }
+            _input.Consume(parsed);
+        }
+
+        // There is command, but we still wait for argument to arrive...
+        if (_command_to_execute && _arg_remains > 0) {
+            // Argument is taken in one piece once it is in the buffer, so the buffer grows to fit it
+            if (_input.Size() < _arg_remains) {
+                _input.Reserve(_arg_remains);
+                break;
+            }
+
+            // Trailing \r\n is not part of the value
+            _argument_for_command.assign(_input.Data(), _arg_remains - 2);
+            _input.Consume(_arg_remains);
+            _arg_remains = 0;
+        }
+
+        // Thre is command & argument - RUN!
+        if (_command_to_execute && _arg_remains == 0) {
+            std::string result;
+            _command_to_execute->Execute(*_pStorage, _argument_for_command, result);
+            result += "\r\n";
+            _output.push_back(std::move(result));
+            _origins.push_back(Origin{_command_op, _command_start});
+
+            // Prepare for the next command
+            _command_to_execute = nullptr;
+            _argument_for_command.resize(0);
+            _parser.Reset();
+            _command_start = 0;
+        }
+    }
+
+    // Memory taken by a large argument is returned once it is processed
+    _input.Shrink();
+}
 
 // See Connection.h
-void Connection::DoWrite() { std::cout << "DoWrite" << std::endl; }
+void Connection::UpdateEvents() {
+    // Once reading is over RDHUP is of no interest, otherwise it would be reported over and over while
+    // responses are waiting to be sent
+    _event.events = EPOLLERR;
+    if (!_eof && _output.size() < kMaxOutput) {
+        _event.events |= EPOLLIN | EPOLLRDHUP;
+    }
+    if (!_output.empty()) {
+        _event.events |= EPOLLOUT;
+    }
+}
 
 } // namespace STnonblock
 } // namespace Network
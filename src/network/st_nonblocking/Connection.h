@@ -2,21 +2,56 @@
 #define AFINA_NETWORK_ST_NONBLOCKING_CONNECTION_H
 
 #include <cstring>
+#include <deque>
+#include <memory>
+#include <string>
 
 #include <sys/epoll.h>
 
+#include <afina/execute/Command.h>
+#include <afina/metrics/Latency.h>
+
+#include "network/InputBuffer.h"
+#include "protocol/Parser.h"
+
+namespace spdlog {
+class logger;
+}
+
 namespace Afina {
+
+// Forward declaration, see afina/Storage.h
+class Storage;
+
 namespace Network {
+
+// Forward declaration, MTnonblock serves the same connections, see mt_nonblocking/Connection.h
+namespace MTnonblock {
+class ServerImpl;
+class Worker;
+} // namespace MTnonblock
+
 namespace STnonblock {
 
+/**
+ * # Client connection state
+ * Everything blocking server keeps on the stack of the connection thread: parser, partially received
+ * command and responses that are not sent yet. Reads until socket is drained, executes all complete commands
+ * and queues responses, which are written once socket becomes writable
+ */
 class Connection {
 public:
-    Connection(int s) : _socket(s) {
+    Connection(int s, std::shared_ptr<Afina::Storage> ps, std::shared_ptr<spdlog::logger> pl)
+        : _socket(s), _pStorage(ps), _logger(pl), _alive(true), _eof(false),
+          _parser(Protocol::Parser::Mode::kView), _arg_remains(0), _command_to_execute(nullptr), _command_start(0),
+          _command_op(Metrics::kOpOther), _head_offset(0) {
         std::memset(&_event, 0, sizeof(struct epoll_event));
         _event.data.ptr = this;
     }
 
-    inline bool isAlive() const { return true; }
+    ~Connection();
+
+    inline bool isAlive() const { return _alive; }
 
     void Start();
 
@@ -28,9 +63,51 @@ protected:
 
 private:
     friend class ServerImpl;
+    friend class MTnonblock::ServerImpl;
+    friend class MTnonblock::Worker;
+
+    // Connection stops reading when that many responses are waiting to be sent, so that client that doesn't
+    // read responses can't make server to buffer unlimited amount of them
+    static const std::size_t kMaxOutput = 128;
+
+    // Runs all commands fully contained in the read buffer
+    void Process();
+
+    // Updates event mask according to what connection waits for
+    void UpdateEvents();
 
     int _socket;
     struct epoll_event _event;
+
+    std::shared_ptr<Afina::Storage> _pStorage;
+    std::shared_ptr<spdlog::logger> _logger;
+
+    bool _alive;
+
+    // Client has closed its side, connection lives until all responses are sent
+    bool _eof;
+
+    // Input that isn't consumed yet
+    InputBuffer _input;
+
+    // Command being parsed, see MTblocking::ServerImpl::OnCommand
+    Protocol::Parser _parser;
+    std::size_t _arg_remains;
+    std::string _argument_for_command;
+    Execute::Command *_command_to_execute;
+    uint64_t _command_start;
+    Metrics::Operation _command_op;
+
+    // Responses to be sent, first one could be sent partially already
+    std::deque<std::string> _output;
+    std::size_t _head_offset;
+
+    // Operation and time the first byte was read for each response, latency is recorded once it is sent
+    struct Origin {
+        Metrics::Operation op;
+        uint64_t start;
+    };
+    std::deque<Origin> _origins;
 };
 
 } // namespace STnonblock
@@ -20,6 +20,7 @@
 
 #include <afina/Storage.h>
 #include <afina/logging/Service.h>
+#include <afina/metrics/Metrics.h>
 
 #include "Connection.h"
 #include "Utils.h"
@@ -51,15 +52,19 @@ void ServerImpl::Start(uint16_t port, uint32_t n_acceptors, uint32_t n_workers)
     std::memset(&server_addr, 0, sizeof(server_addr));
     server_addr.sin_family = AF_INET;         // IPv4
     server_addr.sin_port = htons(port);       // TCP port number
-    server_addr.sin_addr.s_addr = INADDR_ANY; // Bind to any address
+    if (inet_pton(AF_INET, config.address.c_str(), &server_addr.sin_addr) != 1) {
+        throw std::runtime_error("Invalid address to listen on: " + config.address);
+    }
 
     _server_socket = socket(PF_INET, SOCK_STREAM, IPPROTO_TCP);
     if (_server_socket == -1) {
         throw std::runtime_error("Failed to open socket: " + std::string(strerror(errno)));
     }
 
+    // Port stays in TIME_WAIT after restart while there are connections closed by the server, see STblocking
     int opts = 1;
-    if (setsockopt(_server_socket, SOL_SOCKET, (SO_KEEPALIVE), &opts, sizeof(opts)) == -1) {
+    if (setsockopt(_server_socket, SOL_SOCKET, SO_REUSEADDR, &opts, sizeof(opts)) == -1 ||
+        setsockopt(_server_socket, SOL_SOCKET, SO_KEEPALIVE, &opts, sizeof(opts)) == -1) {
         close(_server_socket);
         throw std::runtime_error("Socket setsockopt() failed: " + std::string(strerror(errno)));
     }
@@ -70,7 +75,7 @@ void ServerImpl::Start(uint16_t port, uint32_t n_acceptors, uint32_t n_workers)
     }
 
     make_socket_non_blocking(_server_socket);
-    if (listen(_server_socket, 5) == -1) {
+    if (listen(_server_socket, config.backlog) == -1) {
         close(_server_socket);
         throw std::runtime_error("Socket listen() failed: " + std::string(strerror(errno)));
     }
@@ -144,11 +149,10 @@ void ServerImpl::OnRun() {
             auto old_mask = pc->_event.events;
             if ((current_event.events & EPOLLERR) || (current_event.events & EPOLLHUP)) {
                 pc->OnError();
-            } else if (current_event.events & EPOLLRDHUP) {
-                pc->OnClose();
             } else {
-                // Depends on what connection wants...
-                if (current_event.events & EPOLLIN) {
+                // Depends on what connection wants... Client that has closed its side could still have sent
+                // commands before, connection reads them up to EOF and lives until responses are sent
+                if (current_event.events & (EPOLLIN | EPOLLRDHUP)) {
                     pc->DoRead();
                 }
                 if (current_event.events & EPOLLOUT) {
@@ -165,6 +169,7 @@ void ServerImpl::OnRun() {
                 close(pc->_socket);
                 pc->OnClose();
 
+                _connections.erase(pc);
                 delete pc;
             } else if (pc->_event.events != old_mask) {
                 if (epoll_ctl(epoll_descr, EPOLL_CTL_MOD, pc->_socket, &pc->_event)) {
@@ -173,11 +178,21 @@ void ServerImpl::OnRun() {
                     close(pc->_socket);
                     pc->OnClose();
 
+                    _connections.erase(pc);
                     delete pc;
                 }
             }
         }
     }
+
+    // Connections left are dropped, including ones that have commands in progress
+    for (Connection *pc : _connections) {
+        close(pc->_socket);
+        pc->OnClose();
+        delete pc;
+    }
+    _connections.clear();
+    close(epoll_descr);
     _logger->warn("Acceptor stopped");
 }
 
@@ -207,17 +222,21 @@ void ServerImpl::OnNewConnection(int epoll_descr) {
         }
 
         // Register the new FD to be monitored by epoll.
-        Connection *pc = new Connection(infd);
+        Connection *pc = new Connection(infd, pStorage, _logger);
         if (pc == nullptr) {
             throw std::runtime_error("Failed to allocate connection");
         }
+        Metrics::Add(Metrics::kTotalConnections);
 
         // Register connection in worker's epoll
         pc->Start();
         if (pc->isAlive()) {
             if (epoll_ctl(epoll_descr, EPOLL_CTL_ADD, pc->_socket, &pc->_event)) {
                 pc->OnError();
+                close(pc->_socket);
                 delete pc;
+            } else {
+                _connections.insert(pc);
             }
         }
     }
@@ -1,6 +1,7 @@
 #ifndef AFINA_NETWORK_ST_NONBLOCKING_SERVER_H
 #define AFINA_NETWORK_ST_NONBLOCKING_SERVER_H
 
+#include <set>
 #include <thread>
 #include <vector>
 
@@ -14,8 +15,8 @@ namespace Afina {
 namespace Network {
 namespace STnonblock {
 
-// Forward declaration, see Worker.h
-class Worker;
+// Forward declaration, see Connection.h
+class Connection;
 
 /**
  * # Network resource manager implementation
@@ -56,6 +57,9 @@ private:
 
     // IO thread
     std::thread _work_thread;
+
+    // Connections registered in epoll, accessed only from IO thread
+    std::set<Connection *> _connections;
 };
 
 } // namespace STnonblock
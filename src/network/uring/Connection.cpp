@@ -0,0 +1,109 @@
+#include "Connection.h"
+
+#include <stdexcept>
+
+#include <spdlog/logger.h>
+
+#include <afina/Storage.h>
+#include <afina/metrics/Metrics.h>
+
+namespace Afina {
+namespace Network {
+namespace Uring {
+
+// See Connection.h
+Connection::Connection(int slot, std::shared_ptr<Afina::Storage> ps, std::shared_ptr<spdlog::logger> pl)
+    : _slot(slot), _pStorage(ps), _logger(pl), _alive(true), _draining(false), _pending(0), _output_slot(-1), _input(0),
+      _parser(Protocol::Parser::Mode::kView), _arg_remains(0), _command_to_execute(nullptr), _command_start(0),
+      _command_op(Metrics::kOpOther), _sent(0) {
+    Metrics::Add(Metrics::kCurrConnections);
+}
+
+// See Connection.h
+Connection::~Connection() { Metrics::Sub(Metrics::kCurrConnections); }
+
+// See Connection.h
+void Connection::Process(const char *data, std::size_t size) {
+    uint64_t read_time = Metrics::Clock::Now();
+
+    // Most of the time there is nothing left from the previous receive and commands could be parsed right
+    // from the kernel buffer
+    if (_input.Size() == 0) {
+        std::size_t consumed = Parse(data, size, read_time);
+        _input.Append(data + consumed, size - consumed);
+    } else {
+        _input.Append(data, size);
+        _input.Consume(Parse(_input.Data(), _input.Size(), read_time));
+    }
+
+    // Argument is taken in one piece once it is in the buffer, so the buffer grows to fit it
+    if (_command_to_execute && _arg_remains > 0) {
+        _input.Reserve(_arg_remains);
+    }
+    _input.Shrink();
+}
+
+// See Connection.h
+std::size_t Connection::Parse(const char *data, std::size_t size, uint64_t read_time) {
+    std::size_t consumed = 0;
+
+    // Single block of data readed from the socket could trigger inside actions a multiple times, see
+    // MTblocking::ServerImpl::OnCommand
+    while (size > 0) {
+        // There is no command yet
+        if (!_command_to_execute) {
+            if (_command_start == 0) {
+                _command_start = read_time;
+            }
+
+            std::size_t parsed = 0;
+            if (_parser.Parse(data + consumed, size, parsed)) {
+                _logger->debug("Found new command: {} in {} bytes", _parser.Name(), parsed);
+                _command_to_execute = _parser.BuildInPlace(_arg_remains);
+                _command_op = Metrics::OperationByName(_parser.Name());
+                if (_arg_remains > 0) {
+                    _arg_remains += 2;
+                }
+            }
+
+            if (parsed == 0) {
+                break;
+            }
+            consumed += parsed;
+            size -= parsed;
+        }
+
+        // There is command, but we still wait for argument to arrive...
+        if (_command_to_execute && _arg_remains > 0) {
+            if (size < _arg_remains) {
+                break;
+            }
+
+            // Trailing \r\n is not part of the value
+            _argument_for_command.assign(data + consumed, _arg_remains - 2);
+            consumed += _arg_remains;
+            size -= _arg_remains;
+            _arg_remains = 0;
+        }
+
+        // Thre is command & argument - RUN!
+        if (_command_to_execute && _arg_remains == 0) {
+            std::string result;
+            _command_to_execute->Execute(*_pStorage, _argument_for_command, result);
+            _output += result;
+            _output += "\r\n";
+            _origins.push_back(Origin{_command_op, _command_start, _output.size()});
+
+            // Prepare for the next command
+            _command_to_execute = nullptr;
+            _argument_for_command.resize(0);
+            _parser.Reset();
+            _command_start = 0;
+        }
+    }
+    return consumed;
+}
+
+} // namespace Uring
+} // namespace Network
+} // namespace Afina
@@ -0,0 +1,100 @@
+#ifndef AFINA_NETWORK_URING_CONNECTION_H
+#define AFINA_NETWORK_URING_CONNECTION_H
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+
+#include <afina/execute/Command.h>
+#include <afina/metrics/Latency.h>
+
+#include "network/InputBuffer.h"
+#include "protocol/Parser.h"
+
+namespace spdlog {
+class logger;
+}
+
+namespace Afina {
+
+// Forward declaration, see afina/Storage.h
+class Storage;
+
+namespace Network {
+namespace Uring {
+
+/**
+ * # Client connection state
+ * Socket lives in the registered file table of the worker ring, so connection knows only index of the slot
+ * there. Protocol state is the same as in STnonblock::Connection, but data comes from the buffers kernel has
+ * picked for receive and all responses for a single receive are sent by one operation
+ */
+class Connection {
+public:
+    Connection(int slot, std::shared_ptr<Afina::Storage> ps, std::shared_ptr<spdlog::logger> pl);
+    ~Connection();
+
+    inline bool isAlive() const { return _alive; }
+
+private:
+    friend class Worker;
+
+    // Runs all commands fully contained in the received data, responses are appended to the output. Tail
+    // that isn't a complete command is kept for the next time. Throws std::runtime_error on protocol error
+    void Process(const char *data, std::size_t size);
+
+    // Runs commands in the given data, returns number of bytes consumed
+    std::size_t Parse(const char *data, std::size_t size, uint64_t read_time);
+
+    // Index in the registered file table
+    int _slot;
+
+    std::shared_ptr<Afina::Storage> _pStorage;
+    std::shared_ptr<spdlog::logger> _logger;
+
+    bool _alive;
+
+    // Nothing is received anymore, connection is closed once responses already produced are sent. Set on
+    // protocol error, so the client gets replies for the commands preceding the bad one
+    bool _draining;
+
+    // Number of submitted operations which haven't completed yet. Connection could be closed and freed only
+    // once there are none
+    int _pending;
+
+    // Index of the registered output buffer owned by connection, -1 if all of them were taken
+    int _output_slot;
+
+    // Input that isn't consumed yet, it takes no memory while empty just like idle connection takes no receive
+    // buffer
+    InputBuffer _input;
+
+    // Command being parsed, see MTblocking::ServerImpl::OnCommand
+    Protocol::Parser _parser;
+    std::size_t _arg_remains;
+    std::string _argument_for_command;
+    Execute::Command *_command_to_execute;
+    uint64_t _command_start;
+    Metrics::Operation _command_op;
+
+    // Responses to be sent and how much of them is sent already
+    std::string _output;
+    std::size_t _sent;
+
+    // Operation, time the first byte was read and output size with the response for each response not sent yet,
+    // latency is recorded once output is sent up to its end
+    struct Origin {
+        Metrics::Operation op;
+        uint64_t start;
+        std::size_t end;
+    };
+    std::deque<Origin> _origins;
+};
+
+} // namespace Uring
+} // namespace Network
+} // namespace Afina
+
+#endif // AFINA_NETWORK_URING_CONNECTION_H
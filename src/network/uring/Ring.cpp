@@ -0,0 +1,203 @@
+#include "Ring.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace Afina {
+namespace Network {
+namespace Uring {
+
+namespace {
+
+// There is no liburing, syscalls are made directly
+int io_uring_setup(unsigned entries, struct io_uring_params *p) { return syscall(__NR_io_uring_setup, entries, p); }
+
+int io_uring_enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags) {
+    return syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, nullptr, 0);
+}
+
+int io_uring_register(int fd, unsigned opcode, const void *arg, unsigned nr_args) {
+    return syscall(__NR_io_uring_register, fd, opcode, arg, nr_args);
+}
+
+} // namespace
+
+// See Ring.h
+Ring::Ring(unsigned entries)
+    : _fd(-1), _sq_ring(MAP_FAILED), _sq_ring_size(0), _cq_ring(MAP_FAILED), _cq_ring_size(0), _sqes(nullptr),
+      _sqes_size(0), _sq_local_tail(0) {
+    std::memset(_supported, 0, sizeof(_supported));
+
+    // Completions of the cooperative task work are delivered on the next syscall instead of interrupting the
+    // thread. Older kernels don't know the flag
+    struct io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    params.flags = IORING_SETUP_CQSIZE | IORING_SETUP_COOP_TASKRUN;
+    params.cq_entries = entries * 4;
+    _fd = io_uring_setup(entries, &params);
+    if (_fd < 0 && errno == EINVAL) {
+        std::memset(&params, 0, sizeof(params));
+        params.flags = IORING_SETUP_CQSIZE;
+        params.cq_entries = entries * 4;
+        _fd = io_uring_setup(entries, &params);
+    }
+    if (_fd < 0) {
+        throw std::runtime_error("io_uring_setup() failed: " + std::string(strerror(errno)));
+    }
+    _features = params.features;
+
+    _sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    _cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    if (_features & IORING_FEAT_SINGLE_MMAP) {
+        _sq_ring_size = _cq_ring_size = std::max(_sq_ring_size, _cq_ring_size);
+    }
+
+    _sq_ring = mmap(nullptr, _sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _fd, IORING_OFF_SQ_RING);
+    if (_sq_ring == MAP_FAILED) {
+        close(_fd);
+        throw std::runtime_error("Failed to map submission queue: " + std::string(strerror(errno)));
+    }
+
+    if (_features & IORING_FEAT_SINGLE_MMAP) {
+        _cq_ring = _sq_ring;
+    } else {
+        _cq_ring =
+            mmap(nullptr, _cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _fd, IORING_OFF_CQ_RING);
+        if (_cq_ring == MAP_FAILED) {
+            munmap(_sq_ring, _sq_ring_size);
+            close(_fd);
+            throw std::runtime_error("Failed to map completion queue: " + std::string(strerror(errno)));
+        }
+    }
+
+    _sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    void *sqes = mmap(nullptr, _sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _fd, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) {
+        if (_cq_ring != _sq_ring) {
+            munmap(_cq_ring, _cq_ring_size);
+        }
+        munmap(_sq_ring, _sq_ring_size);
+        close(_fd);
+        throw std::runtime_error("Failed to map submission entries: " + std::string(strerror(errno)));
+    }
+    _sqes = static_cast<struct io_uring_sqe *>(sqes);
+
+    char *sq = static_cast<char *>(_sq_ring);
+    _sq_head = reinterpret_cast<unsigned *>(sq + params.sq_off.head);
+    _sq_tail = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+    _sq_mask = *reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+    _sq_entries = params.sq_entries;
+    _sq_local_tail = *_sq_tail;
+
+    // Entries are always used in order, so index array is identity
+    unsigned *array = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+    for (unsigned i = 0; i < _sq_entries; i++) {
+        array[i] = i;
+    }
+
+    char *cq = static_cast<char *>(_cq_ring);
+    _cq_head = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+    _cq_tail = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+    _cq_mask = *reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+    _cqes = reinterpret_cast<struct io_uring_cqe *>(cq + params.cq_off.cqes);
+    _stash.reserve(params.cq_entries);
+
+    // Probe is optional, kernel without it supports only the very first operations
+    const unsigned probe_ops = 256;
+    std::vector<char> probe_buffer(sizeof(struct io_uring_probe) + probe_ops * sizeof(struct io_uring_probe_op));
+    struct io_uring_probe *probe = reinterpret_cast<struct io_uring_probe *>(probe_buffer.data());
+    if (io_uring_register(_fd, IORING_REGISTER_PROBE, probe, probe_ops) == 0) {
+        for (unsigned i = 0; i < probe->ops_len && i < probe_ops; i++) {
+            if (probe->ops[i].flags & IO_URING_OP_SUPPORTED) {
+                _supported[probe->ops[i].op] = 1;
+            }
+        }
+    }
+}
+
+// See Ring.h
+Ring::~Ring() {
+    munmap(_sqes, _sqes_size);
+    if (_cq_ring != _sq_ring) {
+        munmap(_cq_ring, _cq_ring_size);
+    }
+    munmap(_sq_ring, _sq_ring_size);
+    close(_fd);
+}
+
+// See Ring.h
+void Ring::Reserve(unsigned n) {
+    unsigned head = __atomic_load_n(_sq_head, __ATOMIC_ACQUIRE);
+    while (_sq_local_tail - head + n > _sq_entries) {
+        Stash();
+        Submit(0);
+        head = __atomic_load_n(_sq_head, __ATOMIC_ACQUIRE);
+    }
+}
+
+// See Ring.h
+struct io_uring_sqe *Ring::Sqe() {
+    Reserve(1);
+
+    struct io_uring_sqe *sqe = &_sqes[_sq_local_tail & _sq_mask];
+    _sq_local_tail++;
+    std::memset(sqe, 0, sizeof(*sqe));
+    return sqe;
+}
+
+// See Ring.h
+bool Ring::Submit(unsigned wait_nr) {
+    unsigned to_submit = _sq_local_tail - *_sq_tail;
+    __atomic_store_n(_sq_tail, _sq_local_tail, __ATOMIC_RELEASE);
+
+    // Without waiting the flag still makes kernel move completions it has kept aside while queue was full
+    if (!_stash.empty()) {
+        wait_nr = 0;
+    }
+    if (io_uring_enter(_fd, to_submit, wait_nr, IORING_ENTER_GETEVENTS) < 0) {
+        if (errno == EINTR) {
+            return false;
+        }
+
+        // Completion queue is full, caller has to reap or stash some first. Entries that are not consumed yet
+        // are submitted next time
+        if (errno == EBUSY || errno == EAGAIN) {
+            return true;
+        }
+        throw std::runtime_error("io_uring_enter() failed: " + std::string(strerror(errno)));
+    }
+    return true;
+}
+
+// See Ring.h
+void Ring::Stash() {
+    unsigned head = *_cq_head;
+    unsigned tail = __atomic_load_n(_cq_tail, __ATOMIC_ACQUIRE);
+    for (; head != tail; head++) {
+        _stash.push_back(_cqes[head & _cq_mask]);
+    }
+    __atomic_store_n(_cq_head, head, __ATOMIC_RELEASE);
+}
+
+// See Ring.h
+void Ring::Register(unsigned opcode, const void *arg, unsigned nr_args) {
+    if (io_uring_register(_fd, opcode, arg, nr_args) < 0) {
+        throw std::runtime_error("io_uring_register(" + std::to_string(opcode) +
+                                 ") failed: " + std::string(strerror(errno)));
+    }
+}
+
+// See Ring.h
+bool Ring::Supports(uint8_t opcode) const { return _supported[opcode] != 0; }
+
+} // namespace Uring
+} // namespace Network
+} // namespace Afina
@@ -0,0 +1,115 @@
+#ifndef AFINA_NETWORK_URING_RING_H
+#define AFINA_NETWORK_URING_RING_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <linux/io_uring.h>
+
+namespace Afina {
+namespace Network {
+namespace Uring {
+
+/**
+ * # io_uring instance
+ * Thin wrapper over raw io_uring syscalls: maps submission and completion queues, hands out SQEs and walks
+ * CQEs. Constructor throws std::runtime_error if kernel has no io_uring or it is disabled, so that caller could
+ * choose another way to do IO. Not threadsafe, ring is expected to be used by a single thread
+ */
+class Ring {
+public:
+    /**
+     * Creates ring with the given number of submission entries, completion queue is four times larger
+     */
+    explicit Ring(unsigned entries);
+    ~Ring();
+
+    Ring(const Ring &) = delete;
+    Ring &operator=(const Ring &) = delete;
+
+    /**
+     * Next free SQE, cleared. If submission queue is full, pending entries are submitted first
+     */
+    struct io_uring_sqe *Sqe();
+
+    /**
+     * Makes sure that next n calls to Sqe() won't submit anything, so that linked entries go to kernel together.
+     * If kernel takes no entries because completion queue is full, completions are moved aside to be handled by
+     * the next Reap, so it is safe to call from the Reap callback
+     */
+    void Reserve(unsigned n);
+
+    /**
+     * Submits pending SQEs and waits until there are at least wait_nr completions, doesn't wait if some were
+     * stashed already. Returns false if wait was interrupted by signal
+     */
+    bool Submit(unsigned wait_nr);
+
+    /**
+     * Calls f for each available completion and then marks them consumed, returns number of completions. Ones
+     * that arrive while f submits more are left to the next call, so the caller gets to finish its batch
+     */
+    template <typename F> unsigned Reap(F f) {
+        Stash();
+
+        // Stash may grow under f, so completion is copied out first
+        unsigned count = _stash.size();
+        for (unsigned i = 0; i < count; i++) {
+            struct io_uring_cqe cqe = _stash[i];
+            f(cqe);
+        }
+        _stash.erase(_stash.begin(), _stash.begin() + count);
+        return count;
+    }
+
+    /**
+     * io_uring_register(2) wrapper, throws std::runtime_error on failure
+     */
+    void Register(unsigned opcode, const void *arg, unsigned nr_args);
+
+    /**
+     * Checks that kernel supports given operation
+     */
+    bool Supports(uint8_t opcode) const;
+
+private:
+    // Moves all available completions to the stash and frees their room in the completion queue
+    void Stash();
+
+    int _fd;
+    unsigned _features;
+
+    // Mappings of the rings
+    void *_sq_ring;
+    std::size_t _sq_ring_size;
+    void *_cq_ring;
+    std::size_t _cq_ring_size;
+    struct io_uring_sqe *_sqes;
+    std::size_t _sqes_size;
+
+    // Submission queue, tail is published to kernel on Submit
+    unsigned *_sq_head;
+    unsigned *_sq_tail;
+    unsigned _sq_mask;
+    unsigned _sq_entries;
+    unsigned _sq_local_tail;
+
+    // Completion queue
+    unsigned *_cq_head;
+    unsigned *_cq_tail;
+    unsigned _cq_mask;
+    struct io_uring_cqe *_cqes;
+
+    // Completions consumed from the queue but not handled yet
+    std::vector<struct io_uring_cqe> _stash;
+
+    // Operations supported by kernel
+    uint8_t _supported[256];
+};
+
+} // namespace Uring
+} // namespace Network
+} // namespace Afina
+
+#endif // AFINA_NETWORK_URING_RING_H
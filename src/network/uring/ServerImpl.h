@@ -0,0 +1,59 @@
+#ifndef AFINA_NETWORK_URING_SERVER_H
+#define AFINA_NETWORK_URING_SERVER_H
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <afina/network/Server.h>
+
+namespace spdlog {
+class logger;
+}
+
+namespace Afina {
+namespace Network {
+namespace Uring {
+
+// Forward declaration, see Worker.h
+class Worker;
+
+/**
+ * # Network resource manager implementation
+ * io_uring based server: each worker has own ring and accepts connections from the shared server socket, see
+ * Worker. If kernel has no io_uring, it is disabled or lacks something worker relies on, server logs warning
+ * and works as MTnonblock::ServerImpl
+ */
+class ServerImpl : public Server {
+public:
+    ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl);
+    ~ServerImpl();
+
+    // See Server.h
+    void Start(uint16_t port, uint32_t acceptors, uint32_t workers) override;
+
+    // See Server.h
+    void Stop() override;
+
+    // See Server.h
+    void Join() override;
+
+private:
+    // Logger instance
+    std::shared_ptr<spdlog::logger> _logger;
+
+    // Server socket to accept connections on, shared between workers
+    int _server_socket;
+
+    // Threads serving connections
+    std::vector<std::unique_ptr<Worker>> _workers;
+
+    // Server doing all the work if io_uring can't be used
+    std::unique_ptr<Server> _fallback;
+};
+
+} // namespace Uring
+} // namespace Network
+} // namespace Afina
+
+#endif // AFINA_NETWORK_URING_SERVER_H
@@ -0,0 +1,399 @@
+#include "Worker.h"
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <spdlog/logger.h>
+
+#include <afina/Storage.h>
+#include <afina/metrics/Metrics.h>
+
+#include "Connection.h"
+
+namespace Afina {
+namespace Network {
+namespace Uring {
+
+const unsigned Worker::kEntries;
+const unsigned Worker::kMaxConnections;
+const unsigned Worker::kBuffers;
+const std::size_t Worker::kBufferSize;
+const unsigned Worker::kOutputSlots;
+const std::size_t Worker::kOutputSlotSize;
+const uint64_t Worker::kTagMask;
+
+// See Worker.h
+Worker::Worker(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<spdlog::logger> pl)
+    : _pStorage(ps), _logger(pl), _server_socket(-1), _event_fd(-1), _event_value(0), _cancelled(false),
+      _buf_ring(nullptr), _buf_ring_size(0), _buffers(nullptr), _buf_tail(0), _outputs(nullptr),
+      _accepting(false), _table_full(false), _connections(0), _closing(0) {
+    try {
+        _ring.reset(new Ring(kEntries));
+        const uint8_t required[] = {IORING_OP_ACCEPT, IORING_OP_RECV,  IORING_OP_SEND,        IORING_OP_WRITE_FIXED,
+                                    IORING_OP_READ,   IORING_OP_CLOSE, IORING_OP_ASYNC_CANCEL};
+        for (uint8_t op : required) {
+            if (!_ring->Supports(op)) {
+                throw std::runtime_error("Kernel doesn't support io_uring operation " + std::to_string(op));
+            }
+        }
+
+        // Table is empty, kernel picks free slot for each accepted socket
+        struct io_uring_rsrc_register files;
+        std::memset(&files, 0, sizeof(files));
+        files.nr = kMaxConnections;
+        files.flags = IORING_RSRC_REGISTER_SPARSE;
+        _ring->Register(IORING_REGISTER_FILES2, &files, sizeof(files));
+
+        // Ring of receive buffers must be page aligned
+        _buf_ring_size = kBuffers * sizeof(struct io_uring_buf);
+        void *buf_ring = mmap(nullptr, _buf_ring_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (buf_ring == MAP_FAILED) {
+            throw std::runtime_error("Failed to allocate buffer ring: " + std::string(strerror(errno)));
+        }
+        _buf_ring = static_cast<struct io_uring_buf_ring *>(buf_ring);
+
+        struct io_uring_buf_reg reg;
+        std::memset(&reg, 0, sizeof(reg));
+        reg.ring_addr = reinterpret_cast<uint64_t>(_buf_ring);
+        reg.ring_entries = kBuffers;
+        reg.bgid = 0;
+        _ring->Register(IORING_REGISTER_PBUF_RING, &reg, 1);
+
+        _buffers = new char[kBuffers * kBufferSize];
+        for (unsigned i = 0; i < kBuffers; i++) {
+            Recycle(i);
+        }
+        Publish();
+
+        _event_fd = eventfd(0, EFD_CLOEXEC);
+        if (_event_fd == -1) {
+            throw std::runtime_error("Failed to create eventfd: " + std::string(strerror(errno)));
+        }
+    } catch (...) {
+        Free();
+        throw;
+    }
+
+    // Pinned memory is limited by RLIMIT_MEMLOCK, without registered buffers all responses are just sent
+    std::size_t outputs_size = kOutputSlots * kOutputSlotSize;
+    void *outputs = mmap(nullptr, outputs_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (outputs != MAP_FAILED) {
+        struct iovec iov;
+        iov.iov_base = outputs;
+        iov.iov_len = outputs_size;
+        try {
+            _ring->Register(IORING_REGISTER_BUFFERS, &iov, 1);
+            _outputs = static_cast<char *>(outputs);
+            for (int i = kOutputSlots - 1; i >= 0; i--) {
+                _free_outputs.push_back(i);
+            }
+        } catch (std::runtime_error &ex) {
+            _logger->warn("Output buffers are not registered: {}", ex.what());
+            munmap(outputs, outputs_size);
+        }
+    }
+}
+
+// See Worker.h
+Worker::~Worker() { Free(); }
+
+// See Worker.h
+void Worker::Start(int server_socket) {
+    _server_socket = server_socket;
+    _thread = std::thread(&Worker::OnRun, this);
+}
+
+// See Worker.h
+void Worker::Stop() { eventfd_write(_event_fd, 1); }
+
+// See Worker.h
+void Worker::Join() {
+    if (_thread.joinable()) {
+        _thread.join();
+    }
+}
+
+// See Worker.h
+void Worker::OnRun() {
+    struct io_uring_sqe *sqe = _ring->Sqe();
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = _event_fd;
+    sqe->addr = reinterpret_cast<uint64_t>(&_event_value);
+    sqe->len = sizeof(_event_value);
+    sqe->user_data = kWake;
+
+    Accept();
+
+    // Everything submitted while completions are processed goes to kernel by a single syscall, which waits
+    // for the next completions as well
+    try {
+        while (!_cancelled || _accepting || _connections > 0 || _closing > 0) {
+            _ring->Submit(1);
+            _ring->Reap([this](const struct io_uring_cqe &cqe) { OnComplete(cqe); });
+            Publish();
+        }
+    } catch (std::runtime_error &ex) {
+        _logger->error("Worker failed: {}", ex.what());
+    }
+}
+
+// See Worker.h
+void Worker::OnComplete(const struct io_uring_cqe &cqe) {
+    Connection *pc = reinterpret_cast<Connection *>(cqe.user_data & ~kTagMask);
+    switch (cqe.user_data & kTagMask) {
+    case kAccept:
+        OnAccept(cqe);
+        break;
+
+    case kRecv:
+        OnRecv(pc, cqe);
+        pc->_pending--;
+        Advance(pc);
+        break;
+
+    case kSend:
+        OnSend(pc, cqe);
+        pc->_pending--;
+        Advance(pc);
+        break;
+
+    case kClose:
+        _closing--;
+        if (cqe.res < 0) {
+            _logger->error("Failed to close socket: {}", strerror(-cqe.res));
+        }
+
+        // There is a free slot in the file table now
+        if (_table_full && !_accepting && !_cancelled) {
+            _table_full = false;
+            Accept();
+        }
+        break;
+
+    case kWake: {
+        // Connections are closed once their operations complete
+        _logger->debug("Cancel all operations");
+        _cancelled = true;
+        struct io_uring_sqe *sqe = _ring->Sqe();
+        sqe->opcode = IORING_OP_ASYNC_CANCEL;
+        sqe->fd = -1;
+        sqe->cancel_flags = IORING_ASYNC_CANCEL_ANY;
+        sqe->user_data = kCancel;
+        break;
+    }
+
+    default:
+        break;
+    }
+}
+
+// See Worker.h
+void Worker::OnAccept(const struct io_uring_cqe &cqe) {
+    if (!(cqe.flags & IORING_CQE_F_MORE)) {
+        _accepting = false;
+    }
+
+    if (cqe.res >= 0) {
+        Metrics::Add(Metrics::kTotalConnections);
+        Connection *pc = new Connection(cqe.res, _pStorage, _logger);
+        _connections++;
+        if (!_free_outputs.empty()) {
+            pc->_output_slot = _free_outputs.back();
+            _free_outputs.pop_back();
+        }
+        Advance(pc);
+    } else if (cqe.res == -ENFILE) {
+        _logger->warn("Worker has no room for new connection");
+        Metrics::Add(Metrics::kRejectedConnections);
+        _table_full = !_accepting;
+    } else if (cqe.res != -ECANCELED) {
+        _logger->error("Failed to accept connection: {}", strerror(-cqe.res));
+    }
+
+    if (!_accepting && !_table_full && !_cancelled) {
+        Accept();
+    }
+}
+
+// See Worker.h
+void Worker::OnRecv(Connection *pc, const struct io_uring_cqe &cqe) {
+    if (cqe.res > 0) {
+        uint16_t bid = cqe.flags >> IORING_CQE_BUFFER_SHIFT;
+        _logger->debug("Got {} bytes from slot {}", cqe.res, pc->_slot);
+        Metrics::Add(Metrics::kBytesRead, cqe.res);
+        try {
+            pc->Process(_buffers + bid * kBufferSize, cqe.res);
+        } catch (std::runtime_error &ex) {
+            _logger->error("Failed to process connection on slot {}: {}", pc->_slot, ex.what());
+            pc->_draining = true;
+        }
+        Recycle(bid);
+    } else if (cqe.res == 0) {
+        _logger->debug("Connection on slot {} closed", pc->_slot);
+        pc->_alive = false;
+    } else if (cqe.res == -ENOBUFS) {
+        // All buffers are in use, next receive is submitted after they are recycled
+        _logger->debug("No receive buffers for slot {}", pc->_slot);
+    } else if (cqe.res != -ECANCELED) {
+        _logger->error("Failed to receive on slot {}: {}", pc->_slot, strerror(-cqe.res));
+        pc->_alive = false;
+    }
+}
+
+// See Worker.h
+void Worker::OnSend(Connection *pc, const struct io_uring_cqe &cqe) {
+    if (cqe.res < 0) {
+        if (cqe.res != -ECANCELED) {
+            _logger->error("Failed to send response on slot {}: {}", pc->_slot, strerror(-cqe.res));
+        }
+        pc->_alive = false;
+        return;
+    }
+
+    // Short send cancels linked receive, the rest is sent once it completes
+    Metrics::Add(Metrics::kBytesWritten, cqe.res);
+    pc->_sent += cqe.res;
+
+    uint64_t now = Metrics::Clock::Now();
+    while (!pc->_origins.empty() && pc->_origins.front().end <= pc->_sent) {
+        Metrics::RecordLatency(pc->_origins.front().op, pc->_origins.front().start, now);
+        pc->_origins.pop_front();
+    }
+}
+
+// See Worker.h
+void Worker::Advance(Connection *pc) {
+    if (pc->_pending > 0) {
+        return;
+    }
+
+    if (_cancelled) {
+        pc->_alive = false;
+    }
+    if (!pc->_alive) {
+        Close(pc);
+        return;
+    }
+
+    if (pc->_sent < pc->_output.size()) {
+        Send(pc);
+    } else if (pc->_draining) {
+        Close(pc);
+    } else {
+        pc->_output.resize(0);
+        pc->_sent = 0;
+        Recv(pc, 0);
+    }
+}
+
+// See Worker.h
+void Worker::Accept() {
+    struct io_uring_sqe *sqe = _ring->Sqe();
+    sqe->opcode = IORING_OP_ACCEPT;
+    sqe->fd = _server_socket;
+    sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+    sqe->file_index = IORING_FILE_INDEX_ALLOC;
+    sqe->user_data = kAccept;
+    _accepting = true;
+}
+
+// See Worker.h
+void Worker::Recv(Connection *pc, uint8_t flags) {
+    struct io_uring_sqe *sqe = _ring->Sqe();
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = pc->_slot;
+    sqe->flags = IOSQE_FIXED_FILE | IOSQE_BUFFER_SELECT | flags;
+    sqe->buf_group = 0;
+    sqe->len = kBufferSize;
+    sqe->user_data = reinterpret_cast<uint64_t>(pc) | kRecv;
+    pc->_pending++;
+}
+
+// See Worker.h
+void Worker::Send(Connection *pc) {
+    const char *data = pc->_output.data() + pc->_sent;
+    std::size_t size = pc->_output.size() - pc->_sent;
+
+    // Chain must not be split between submissions, otherwise receive could run along with send
+    _ring->Reserve(pc->_draining ? 1 : 2);
+    struct io_uring_sqe *sqe = _ring->Sqe();
+    if (pc->_output_slot >= 0 && size <= kOutputSlotSize) {
+        char *out = _outputs + pc->_output_slot * kOutputSlotSize;
+        std::memcpy(out, data, size);
+        sqe->opcode = IORING_OP_WRITE_FIXED;
+        sqe->addr = reinterpret_cast<uint64_t>(out);
+        sqe->buf_index = 0;
+    } else {
+        sqe->opcode = IORING_OP_SEND;
+        sqe->addr = reinterpret_cast<uint64_t>(data);
+        sqe->msg_flags = MSG_NOSIGNAL;
+    }
+    sqe->fd = pc->_slot;
+    sqe->len = size;
+    sqe->flags = IOSQE_FIXED_FILE;
+    sqe->user_data = reinterpret_cast<uint64_t>(pc) | kSend;
+    pc->_pending++;
+
+    // Connection being drained is closed once send completes
+    if (!pc->_draining) {
+        sqe->flags |= IOSQE_IO_LINK;
+        Recv(pc, 0);
+    }
+}
+
+// See Worker.h
+void Worker::Close(Connection *pc) {
+    struct io_uring_sqe *sqe = _ring->Sqe();
+    sqe->opcode = IORING_OP_CLOSE;
+    sqe->file_index = pc->_slot + 1;
+    sqe->user_data = kClose;
+    _closing++;
+
+    if (pc->_output_slot >= 0) {
+        _free_outputs.push_back(pc->_output_slot);
+    }
+    delete pc;
+    _connections--;
+}
+
+// See Worker.h
+void Worker::Recycle(uint16_t bid) {
+    // Ring is an array of entries with tail sharing memory with the first one, so fields are set one by one.
+    // Flexible array from the kernel header gets wrong offset in C++, it is not used
+    struct io_uring_buf *buf = reinterpret_cast<struct io_uring_buf *>(_buf_ring) + (_buf_tail & (kBuffers - 1));
+    buf->addr = reinterpret_cast<uint64_t>(_buffers + bid * kBufferSize);
+    buf->len = kBufferSize;
+    buf->bid = bid;
+    _buf_tail++;
+}
+
+// See Worker.h
+void Worker::Publish() { __atomic_store_n(&_buf_ring->tail, _buf_tail, __ATOMIC_RELEASE); }
+
+// See Worker.h
+void Worker::Free() {
+    // Ring goes first, kernel must not use any of the buffers after they are freed
+    _ring.reset();
+    if (_event_fd != -1) {
+        close(_event_fd);
+    }
+    if (_outputs != nullptr) {
+        munmap(_outputs, kOutputSlots * kOutputSlotSize);
+    }
+    delete[] _buffers;
+    if (_buf_ring != nullptr) {
+        munmap(_buf_ring, _buf_ring_size);
+    }
+}
+
+} // namespace Uring
+} // namespace Network
+} // namespace Afina
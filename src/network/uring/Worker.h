@@ -0,0 +1,150 @@
+#ifndef AFINA_NETWORK_URING_WORKER_H
+#define AFINA_NETWORK_URING_WORKER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "Ring.h"
+
+namespace spdlog {
+class logger;
+}
+
+namespace Afina {
+
+// Forward declaration, see afina/Storage.h
+class Storage;
+
+namespace Network {
+namespace Uring {
+
+// Forward declaration, see Connection.h
+class Connection;
+
+/**
+ * # Thread running io_uring instance
+ * Each worker has own ring with resources registered up front:
+ * - sparse file table, accepted sockets are put right there and never get regular descriptors;
+ * - ring of buffers kernel picks from when data arrives, so idle connection doesn't hold any buffer;
+ * - arena of output buffers, responses which fit into a slot are written without pinning pages on each send.
+ *
+ * Worker keeps multishot accept armed on the shared server socket. Each connection has either receive or
+ * "send, then receive" chain in flight: once received data is processed, all responses are sent by a single
+ * operation and receive linked to it starts right after the send completes. Short send breaks the chain,
+ * rest of the output is sent again
+ */
+class Worker {
+public:
+    /**
+     * Creates ring and registers resources, throws std::runtime_error if io_uring can't be used
+     */
+    Worker(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<spdlog::logger> pl);
+    ~Worker();
+
+    /**
+     * Spawns background thread accepting connections from the given server socket and serving them
+     */
+    void Start(int server_socket);
+
+    /**
+     * Wakes up background thread, so that it cancels everything in flight. Thread stops once all connections
+     * are closed
+     */
+    void Stop();
+
+    /**
+     * Blocks calling thread until background one is done
+     */
+    void Join();
+
+private:
+    Worker(const Worker &) = delete;
+    Worker &operator=(const Worker &) = delete;
+
+    // Size of the submission queue
+    static const unsigned kEntries = 256;
+
+    // Size of the registered file table, that many connections worker could serve at once
+    static const unsigned kMaxConnections = 1024;
+
+    // Buffers for receive, number must be power of 2
+    static const unsigned kBuffers = 256;
+    static const std::size_t kBufferSize = 4096;
+
+    // Registered output buffers
+    static const unsigned kOutputSlots = 256;
+    static const std::size_t kOutputSlotSize = 4096;
+
+    // Operation is encoded in the lowest bits of user data, the rest is pointer to connection
+    enum Tag : uint64_t { kAccept = 1, kRecv = 2, kSend = 3, kClose = 4, kWake = 5, kCancel = 6 };
+    static const uint64_t kTagMask = 7;
+
+    // Thread entry point
+    void OnRun();
+
+    // Completion handlers
+    void OnComplete(const struct io_uring_cqe &cqe);
+    void OnAccept(const struct io_uring_cqe &cqe);
+    void OnRecv(Connection *pc, const struct io_uring_cqe &cqe);
+    void OnSend(Connection *pc, const struct io_uring_cqe &cqe);
+
+    // Submits next operation for connection which has nothing in flight, frees closed one
+    void Advance(Connection *pc);
+
+    // Operation builders
+    void Accept();
+    void Recv(Connection *pc, uint8_t flags);
+    void Send(Connection *pc);
+    void Close(Connection *pc);
+
+    // Gives receive buffer back to kernel, buffers are published in batches
+    void Recycle(uint16_t bid);
+    void Publish();
+
+    // Releases ring and memory
+    void Free();
+
+    std::shared_ptr<Afina::Storage> _pStorage;
+    std::shared_ptr<spdlog::logger> _logger;
+
+    std::unique_ptr<Ring> _ring;
+    std::thread _thread;
+    int _server_socket;
+
+    // Written to wake up the thread, counter stays set so that stop is noticed even if it comes before the
+    // thread has started
+    int _event_fd;
+    uint64_t _event_value;
+
+    // Stop was noticed and all operations in flight were cancelled
+    bool _cancelled;
+
+    // Receive buffers and the ring kernel takes them from
+    struct io_uring_buf_ring *_buf_ring;
+    std::size_t _buf_ring_size;
+    char *_buffers;
+    uint16_t _buf_tail;
+
+    // Registered output buffers, nullptr if kernel has refused to pin them
+    char *_outputs;
+    std::vector<int> _free_outputs;
+
+    // Accept is armed
+    bool _accepting;
+
+    // File table is full, accept is re-armed once some connection is closed
+    bool _table_full;
+
+    // Alive connections and close operations in flight, thread is done when both are zero after stop
+    std::size_t _connections;
+    std::size_t _closing;
+};
+
+} // namespace Uring
+} // namespace Network
+} // namespace Afina
+
+#endif // AFINA_NETWORK_URING_WORKER_H
@@ -15,6 +15,26 @@
 namespace Afina {
 namespace Protocol {
 
+// See Parser.h
+struct Parser::Commands {
+    Execute::Set set;
+    Execute::Add add;
+    Execute::Append append;
+    Execute::Get get;
+    Execute::Stats stats;
+
+    Commands() : get(nullptr, 0) {}
+};
+
+// Command line longer than that is an error
+static const std::size_t kMaxLine = 64 * 1024;
+
+// See Parse.h
+Parser::Parser(Mode mode) : mode(mode) { Reset(); }
+
+// See Parse.h
+Parser::~Parser() {}
+
 // See Parse.h
 bool Parser::Parse(const char *input, const size_t size, size_t &parsed) {
     size_t pos;
@@ -22,22 +42,40 @@ bool Parser::Parse(const char *input, const size_t size, size_t &parsed) {
 
     for (pos = 0; pos < size && !parse_complete; pos++) {
         char c = input[pos];
+        // Position of the char in the command line
+        std::size_t offset = line_size + pos;
         // std::cout << "[" << pos << "] '" << c << "': state=" << int(state) << std::endl;
 
         switch (state) {
         case State::sName: {
             if (c == ' ' || c == '\r') {
                 // std::cout << "parser debug: name='" << name << "'" << std::endl;
-                if (name == "set" || name == "add" || name == "append" || name == "prepend") {
-                    state = State::spKey;
-                } else if (name == "get" || name == "gets") {
-                    state = State::sgKey;
+                if (name == "set") {
+                    type = Type::kSet;
+                } else if (name == "add") {
+                    type = Type::kAdd;
+                } else if (name == "append") {
+                    type = Type::kAppend;
+                } else if (name == "prepend") {
+                    type = Type::kPrepend;
+                } else if (name == "get") {
+                    type = Type::kGet;
+                } else if (name == "gets") {
+                    type = Type::kGets;
                 } else if (name == "stats") {
-                    state = State::sLF;
-                    continue;
+                    type = Type::kStats;
                 } else {
                     throw std::runtime_error("Unknown command name: " + name);
                 }
+
+                if (type == Type::kGet || type == Type::kGets) {
+                    state = State::sgKey;
+                } else if (type == Type::kStats) {
+                    state = (c == ' ') ? State::ssArgs : State::sLF;
+                } else {
+                    state = State::spKey;
+                }
+                key_start = offset + 1;
             } else {
                 name.push_back(c);
             }
@@ -47,32 +85,28 @@ bool Parser::Parse(const char *input, const size_t size, size_t &parsed) {
         case State::spKey: {
             if (c == ' ') {
                 state = State::spFlags;
-                keys.push_back(curKey);
-                // std::cout << "parser debug: key[" << keys.size() - 1 << "]='" << curKey << "'" << std::endl;
-            } else {
-                curKey.push_back(c);
+                AddKey(offset);
             }
             break;
         }
 
         case State::sgKey: {
             if (c == '\r') {
-                keys.push_back(curKey);
-                // std::cout << "parser debug: total '" << keys.size() << " keys" << std::endl;
+                AddKey(offset);
+                state = State::sLF;
+            } else if (c == ' ') {
+                AddKey(offset);
+                key_start = offset + 1;
+            }
+            break;
+        }
 
-                if (keys.size() == 0) {
-                    throw std::runtime_error("Client provides no key to retrive");
+        case State::ssArgs: {
+            if (c == '\r') {
+                if (offset > key_start) {
+                    AddKey(offset);
                 }
-
-                curKey.clear();
                 state = State::sLF;
-            } else if (c == ' ') {
-                // std::cout << "parser debug: key[" << keys.size() << "]='" << curKey << "'" << std::endl;
-                state = State::sgKey;
-                keys.push_back(curKey);
-                curKey.clear();
-            } else {
-                curKey.push_back(c);
             }
             break;
         }
@@ -83,12 +117,11 @@ bool Parser::Parse(const char *input, const size_t size, size_t &parsed) {
                 state = State::spExprTimeStart;
                 // std::cout << "parser debug: flags='" << flags << "'" << std::endl;
             } else if (c >= '0' && c <= '9') {
-                uint32_t f = (flags * 10) + (c - '0');
-                if (f < flags) {
-                    // Overflow
+                uint32_t digit = c - '0';
+                if (flags > (UINT32_MAX - digit) / 10) {
                     throw std::runtime_error("Flags field overflow");
                 }
-                flags = f;
+                flags = flags * 10 + digit;
             }
             break;
         }
@@ -109,19 +142,19 @@ bool Parser::Parse(const char *input, const size_t size, size_t &parsed) {
                 state = State::spBytes;
                 // std::cout << "parser debug: ExprTime='" << exprtime << "'" << std::endl;
             } else if (c >= '0' && c <= '9') {
-                int32_t et = exprtime;
+                // Checks are made before the math, signed overflow is undefined
+                int32_t digit = c - '0';
                 if (negative) {
-                    et -= (c - '0');
-                    if (et > exprtime) {
+                    if (exprtime < (INT32_MIN + digit) / 10) {
                         throw std::runtime_error("Expire time field overflow");
                     }
+                    exprtime = exprtime * 10 - digit;
                 } else {
-                    et += (c - '0');
-                    if (et < exprtime) {
+                    if (exprtime > (INT32_MAX - digit) / 10) {
                         throw std::runtime_error("Expire time field overflow");
                     }
+                    exprtime = exprtime * 10 + digit;
                 }
-                exprtime = et;
             }
             break;
         }
@@ -131,12 +164,11 @@ bool Parser::Parse(const char *input, const size_t size, size_t &parsed) {
                 state = State::sLF;
                 // std::cout << "parser debug: bytes='" << bytes << "'" << std::endl;
             } else if (c >= '0' && c <= '9') {
-                uint32_t b = (bytes * 10) + (c - '0');
-                if (b < bytes) {
-                    // Overflow
+                uint32_t digit = c - '0';
+                if (bytes > (UINT32_MAX - digit) / 10) {
                     throw std::runtime_error("Bytes field overflow");
                 }
-                bytes = b;
+                bytes = bytes * 10 + digit;
             }
             break;
         }
@@ -157,10 +189,31 @@ bool Parser::Parse(const char *input, const size_t size, size_t &parsed) {
         }
     }
 
+    // In view mode keys point right into the input if the whole command line is there, otherwise it is copied
+    const char *base = input;
+    if (mode == Mode::kCopy || line_size > 0 || !parse_complete) {
+        line.append(input, pos);
+        base = line.data();
+    }
+    line_size += pos;
+    if (line_size > kMaxLine) {
+        throw std::runtime_error("Command is too long");
+    }
+
+    if (parse_complete) {
+        views.clear();
+        for (auto &key : keys) {
+            views.push_back(Execute::KeyView{base + key.offset, key.size});
+        }
+    }
+
     parsed += pos;
     return parse_complete;
 }
 
+// See Parse.h
+void Parser::AddKey(std::size_t offset) { keys.push_back(Span{key_start, offset - key_start}); }
+
 // See Parse.h
 std::unique_ptr<Execute::Command> Parser::Build(size_t &body_size) const {
     if (state != State::sLF) {
@@ -168,17 +221,66 @@ std::unique_ptr<Execute::Command> Parser::Build(size_t &body_size) const {
     }
 
     body_size = bytes;
-    if (name == "set") {
-        return std::unique_ptr<Execute::Command>(new Execute::Set(keys[0], flags, exprtime));
-    } else if (name == "add") {
-        return std::unique_ptr<Execute::Command>(new Execute::Add(keys[0], flags, exprtime));
-    } else if (name == "append") {
-        return std::unique_ptr<Execute::Command>(new Execute::Append(keys[0], flags, exprtime));
-    } else if (name == "get") {
+    std::string key;
+    if (!views.empty()) {
+        key.assign(views[0].data, views[0].size);
+    }
+
+    switch (type) {
+    case Type::kSet:
+        return std::unique_ptr<Execute::Command>(new Execute::Set(key, flags, exprtime));
+    case Type::kAdd:
+        return std::unique_ptr<Execute::Command>(new Execute::Add(key, flags, exprtime));
+    case Type::kAppend:
+        return std::unique_ptr<Execute::Command>(new Execute::Append(key, flags, exprtime));
+    case Type::kGet: {
+        if (mode == Mode::kView) {
+            return std::unique_ptr<Execute::Command>(new Execute::Get(views.data(), views.size()));
+        }
+
+        std::vector<std::string> keys;
+        for (auto &view : views) {
+            keys.emplace_back(view.data, view.size);
+        }
         return std::unique_ptr<Execute::Command>(new Execute::Get(keys));
-    } else if (name == "stats") {
-        return std::unique_ptr<Execute::Command>(new Execute::Stats());
-    } else {
+    }
+    case Type::kStats:
+        return std::unique_ptr<Execute::Command>(new Execute::Stats(key));
+    default:
+        throw std::runtime_error("Unsupported command");
+    }
+}
+
+// See Parse.h
+Execute::Command *Parser::BuildInPlace(size_t &body_size) {
+    if (state != State::sLF) {
+        return nullptr;
+    }
+    if (!commands) {
+        commands.reset(new Commands());
+    }
+
+    body_size = bytes;
+    const char *key = views.empty() ? "" : views[0].data;
+    std::size_t key_size = views.empty() ? 0 : views[0].size;
+
+    switch (type) {
+    case Type::kSet:
+        commands->set.Assign(key, key_size, flags, exprtime);
+        return &commands->set;
+    case Type::kAdd:
+        commands->add.Assign(key, key_size, flags, exprtime);
+        return &commands->add;
+    case Type::kAppend:
+        commands->append.Assign(key, key_size, flags, exprtime);
+        return &commands->append;
+    case Type::kGet:
+        commands->get.Assign(views.data(), views.size());
+        return &commands->get;
+    case Type::kStats:
+        commands->stats.Assign(key, key_size);
+        return &commands->stats;
+    default:
         throw std::runtime_error("Unsupported command");
     }
 }
@@ -187,8 +289,12 @@ std::unique_ptr<Execute::Command> Parser::Build(size_t &body_size) const {
 void Parser::Reset() {
     state = State::sName;
     name.clear();
+    type = Type::kNone;
     keys.clear();
-    curKey.clear();
+    views.clear();
+    line.clear();
+    line_size = 0;
+    key_start = 0;
     parse_complete = false;
     flags = 0;
     bytes = 0;
@@ -8,6 +8,8 @@
 #include <cstddef>
 #include <cstdint>
 
+#include <afina/execute/KeyView.h>
+
 namespace Afina {
 namespace Execute {
 class Command;
@@ -17,10 +19,24 @@ namespace Protocol {
 /**
  * # Memcached protocol parser
  * Parser supports subset of memcached protocol
+ *
+ * Keys are recorded as positions in the command line. In view mode bytes are copied only if command line comes in
+ * more than one piece. Memory parser holds is kept between commands, so once it has seen the longest command line
+ * parsing doesn't allocate
  */
 class Parser {
 public:
-    Parser() { Reset(); }
+    /**
+     * How commands built by parser keep keys of the get command:
+     * - kCopy: parser copies command line, so input could be released right after Parse call. Command owns
+     *   copies of the keys;
+     * - kView: command refers to the input given to the last Parse call or to the parser itself, so that input must
+     *   stay unchanged and parser must not be reset until command is executed
+     */
+    enum class Mode { kCopy, kView };
+
+    explicit Parser(Mode mode = Mode::kCopy);
+    ~Parser();
     /**
      * Push given string into parser input. Method returns true if it was a command parsed out
      * from comulative input. In a such case method Build will return new command
@@ -48,6 +64,13 @@ public:
      */
     std::unique_ptr<Execute::Command> Build(size_t &body_size) const;
 
+    /**
+     * Same as Build, but command is owned by parser: there is a single instance for each command type, which is
+     * prepared again for every parsed command of that type. Once parser has seen every type, no allocation happens.
+     * Returned command is valid until the next call, keys of get are valid as in kView mode
+     */
+    Execute::Command *BuildInPlace(size_t &body_size);
+
     /**
      * Reset parse so that it could be used to parse out new command
      */
@@ -55,21 +78,46 @@ public:
 
     inline const std::string &Name() const { return name; }
 
+    /**
+     * Keys of the parsed command, valid under the same conditions as command built in kView mode
+     */
+    inline const Execute::KeyView *Keys() const { return views.data(); }
+    inline std::size_t KeysCount() const { return views.size(); }
+
 private:
     /**
      * State of the command parser. Prefixes are:
      * - s: state for PUT and GET commands
      * - sp: for PUT commands only
      * - sg: for GET commands only
+     * - ss: for STATS command only
      */
-    enum State : uint16_t { sCR, sLF, sName, spKey, spFlags, spExprTimeStart, spExprTime, spBytes, sgKey };
+    enum State : uint16_t { sCR, sLF, sName, spKey, spFlags, spExprTimeStart, spExprTime, spBytes, sgKey, ssArgs };
+
+    // Command found in the name, commands are dispatched on it
+    enum class Type : uint8_t { kNone, kSet, kAdd, kAppend, kPrepend, kGet, kGets, kStats };
+
+    // Commands reused by BuildInPlace
+    struct Commands;
+
+    // Position of the key in the command line
+    struct Span {
+        std::size_t offset;
+        std::size_t size;
+    };
+
+    // Appends key that has started at key_start and ends right before the given command line offset
+    void AddKey(std::size_t offset);
+
+    const Mode mode;
 
     // Current parser state
     State state;
 
     // vrious fields of the command
     std::string name;
-    std::vector<std::string> keys;
+    Type type;
+    std::vector<Span> keys;
 
     // <flags> is an arbitrary 16-bit unsigned integer (written out in decimal) that the server stores along with
     // the data and sends back when the item is retrieved. Clients may use this as a bit field to store data-specific
@@ -89,8 +137,22 @@ private:
     uint32_t bytes;
 
     bool negative;
-    std::string curKey;
     bool parse_complete;
+
+    // Command line offset of the key being parsed
+    std::size_t key_start;
+
+    // Number of the command line bytes consumed by previous Parse calls
+    std::size_t line_size;
+
+    // Copy of the command line, made only if it doesn't come in a single piece
+    std::string line;
+
+    // Keys of the complete command
+    std::vector<Execute::KeyView> views;
+
+    // Created once BuildInPlace is called for the first time
+    std::unique_ptr<Commands> commands;
 };
 
 } // namespace Protocol
@@ -0,0 +1,233 @@
+#include "ARC.h"
+
+#include <algorithm>
+#include <iterator>
+
+#include "Allocated.h"
+
+namespace Afina {
+namespace Backend {
+
+// See ARC.h
+ARC::ARC(size_t max_size, double ghost_share)
+    : _max_size(max_size / (1 + ghost_share)), _ghost_max(max_size - _max_size), _target(0), _t1_size(0),
+      _t2_size(0), _b1_size(0), _b2_size(0), _ghost_bytes(0), _payload(0), _evictions(0) {}
+
+// See ARC.h
+std::size_t ARC::Charge(const Item &item) {
+    // List node is two pointers followed by the item, index node is color and three pointers followed by the entry
+    static const std::size_t list_node = Allocated(2 * sizeof(void *) + sizeof(Item));
+    static const std::size_t index_node = Allocated(3 * sizeof(void *) + sizeof(int) + sizeof(Index::value_type));
+
+    return list_node + index_node + Allocated(item.key) + Allocated(item.value);
+}
+
+// See ARC.h
+std::size_t ARC::GhostCharge() {
+    // Hash table node is a pointer followed by the entry, and there is about a bucket pointer for each of them
+    static const std::size_t charge = Allocated(2 * sizeof(void *) + sizeof(Ghost)) +
+                                      Allocated(sizeof(void *) + sizeof(GhostIndex::value_type)) + sizeof(void *);
+    return charge;
+}
+
+// See ARC.h
+bool ARC::Put(const std::string &key, const std::string &value) {
+    auto found = _index.find(key);
+    if (found == _index.end()) {
+        return Insert(key, value);
+    } else {
+        return Replace(found, value);
+    }
+}
+
+// See ARC.h
+bool ARC::PutIfAbsent(const std::string &key, const std::string &value) {
+    if (_index.find(key) != _index.end()) {
+        return false;
+    }
+    return Insert(key, value);
+}
+
+// See ARC.h
+bool ARC::Set(const std::string &key, const std::string &value) {
+    auto found = _index.find(key);
+    if (found == _index.end()) {
+        return false;
+    }
+    return Replace(found, value);
+}
+
+// See ARC.h
+bool ARC::Delete(const std::string &key) {
+    auto found = _index.find(key);
+    if (found == _index.end()) {
+        return false;
+    }
+    Remove(found);
+    return true;
+}
+
+// See ARC.h
+bool ARC::Get(const std::string &key, std::string &value) {
+    auto found = _index.find(key);
+    if (found == _index.end()) {
+        return false;
+    }
+
+    value = found->second->value;
+    Promote(found->second);
+    return true;
+}
+
+// See ARC.h
+void ARC::GetUsage(Usage &usage) {
+    usage.items = _index.size();
+    usage.bytes = _t1_size + _t2_size + _ghost_bytes;
+    usage.overhead = usage.bytes - _payload;
+    usage.limit = _max_size + _ghost_max;
+    usage.evictions = _evictions;
+}
+
+// See ARC.h
+bool ARC::Insert(const std::string &key, const std::string &value) {
+    if (key.size() + value.size() > _max_size) {
+        return false;
+    }
+
+    // Item is built aside, so that room for it is made knowing its size and without evicting it
+    Resident fresh;
+    fresh.emplace_front(key, value);
+    Item &item = fresh.front();
+    item.charge = Charge(item);
+    if (item.charge > _max_size) {
+        return false;
+    }
+
+    auto ghost = _ghost_index.find(std::hash<std::string>()(key));
+    bool frequent_ghost = false;
+    if (ghost != _ghost_index.end()) {
+        // Key would have been found if the list it was evicted from had been larger, so target moves that way.
+        // Step is larger when the other ghost list is, as hits there are more likely then
+        frequent_ghost = ghost->second->frequent;
+        if (frequent_ghost) {
+            std::size_t step = item.charge * std::max(1.0, double(_b1_size) / _b2_size);
+            _target = _target > step ? _target - step : 0;
+        } else {
+            std::size_t step = item.charge * std::max(1.0, double(_b2_size) / _b1_size);
+            _target = std::min(_max_size, _target + step);
+        }
+        RemoveGhost(ghost);
+        item.frequent = true;
+    } else {
+        // Directory keeps T1 with B1 within max_size and all the lists within twice of it
+        while (_t1_size + _b1_size + item.charge > _max_size && !_b1.empty()) {
+            DropGhost(_b1);
+        }
+        while (_t1_size + _t2_size + _b1_size + _b2_size + item.charge > 2 * _max_size && !_b2.empty()) {
+            DropGhost(_b2);
+        }
+    }
+
+    while (_t1_size + _t2_size + item.charge > _max_size) {
+        Evict(frequent_ghost);
+    }
+
+    Resident &list = item.frequent ? _t2 : _t1;
+    (item.frequent ? _t2_size : _t1_size) += item.charge;
+    list.splice(list.begin(), fresh);
+    _payload += key.size() + value.size();
+    _index.emplace(std::cref(item.key), list.begin());
+    return true;
+}
+
+// See ARC.h
+bool ARC::Replace(Index::iterator found, const std::string &value) {
+    // Key is copied before the item holding it goes away
+    const std::string key = found->first.get();
+    if (key.size() + value.size() > _max_size) {
+        return false;
+    }
+
+    // Item is built anew, as it may need a room that could be made only by evicting the old one. Update
+    // is a request for the key, so it goes to T2 as the old item would
+    Remove(found);
+    if (!Insert(key, value)) {
+        return false;
+    }
+    Promote(_index.find(key)->second);
+    return true;
+}
+
+// See ARC.h
+void ARC::Promote(Resident::iterator item) {
+    if (item->frequent) {
+        _t2.splice(_t2.begin(), _t2, item);
+        return;
+    }
+
+    item->frequent = true;
+    _t1_size -= item->charge;
+    _t2_size += item->charge;
+    _t2.splice(_t2.begin(), _t1, item);
+}
+
+// See ARC.h
+void ARC::Evict(bool frequent_ghost) {
+    bool recent = !_t1.empty() && (_t2.empty() || _t1_size > _target || (frequent_ghost && _t1_size >= _target));
+    Resident &victims = recent ? _t1 : _t2;
+    if (victims.empty()) {
+        return;
+    }
+
+    const Item &victim = victims.back();
+    std::size_t hash = std::hash<std::string>()(victim.key);
+    Ghosts &ghosts = recent ? _b1 : _b2;
+
+    // Keys of the same hash share the ghost, the later one is not remembered
+    if (_ghost_index.find(hash) == _ghost_index.end()) {
+        ghosts.push_front(Ghost{hash, victim.charge, !recent});
+        _ghost_index.emplace(hash, ghosts.begin());
+        (recent ? _b1_size : _b2_size) += victim.charge;
+        _ghost_bytes += GhostCharge();
+
+        // B1 goes first when it is over its limit, as it would in the original ARC
+        while (_ghost_bytes > _ghost_max) {
+            DropGhost(_t1_size + _b1_size > _max_size || _b2.empty() ? _b1 : _b2);
+        }
+    }
+
+    Remove(_index.find(victim.key));
+    _evictions++;
+}
+
+// See ARC.h
+void ARC::DropGhost(Ghosts &ghosts) {
+    if (ghosts.empty()) {
+        return;
+    }
+    RemoveGhost(_ghost_index.find(ghosts.back().hash));
+}
+
+// See ARC.h
+void ARC::RemoveGhost(GhostIndex::iterator found) {
+    Ghosts::iterator ghost = found->second;
+    (ghost->frequent ? _b2_size : _b1_size) -= ghost->charge;
+    _ghost_bytes -= GhostCharge();
+
+    _ghost_index.erase(found);
+    (ghost->frequent ? _b2 : _b1).erase(ghost);
+}
+
+// See ARC.h
+void ARC::Remove(Index::iterator found) {
+    Resident::iterator item = found->second;
+    (item->frequent ? _t2_size : _t1_size) -= item->charge;
+    _payload -= item->key.size() + item->value.size();
+
+    // Index refers to the key kept in the item, so it goes first
+    _index.erase(found);
+    (item->frequent ? _t2 : _t1).erase(item);
+}
+
+} // namespace Backend
+} // namespace Afina
@@ -0,0 +1,143 @@
+#ifndef AFINA_STORAGE_ARC_H
+#define AFINA_STORAGE_ARC_H
+
+#include <functional>
+#include <list>
+#include <map>
+#include <string>
+#include <unordered_map>
+
+#include <afina/Storage.h>
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Adaptive replacement cache
+ * That is NOT thread safe implementaiton!!
+ *
+ * Items are kept in two LRU lists: T1 of keys requested once and T2 of ones requested at least twice. Keys evicted
+ * from each of them are remembered for a while in ghost lists B1 and B2. Request of a key from B1 tells that T1
+ * had been too small to keep it, so the target size of T1 grows, while request of one from B2 shrinks it. Eviction
+ * takes T1 tail while T1 is above its target and T2 tail otherwise, so the split between recency and frequency
+ * follows the workload.
+ *
+ * Sizes are bytes: items are charged with all the heap they take, same as in SimpleLRU, and each ghost counts
+ * with the charge its item had. As in the original ARC, T1 and B1 take at most the items budget together and all
+ * four lists at most twice of it. Ghost keeps only the hash of the key, but for items of a few hundred bytes full
+ * ghost lists still take a third of what items do. Items evicted to make room for ghosts cost more hits than
+ * adapting wins back, as do ghost lists cut short, so ghosts have memory of their own: max_size is split into
+ * items budget and ghost_share of it for the ghosts, and both together never take more than max_size
+ */
+class ARC : public Afina::Storage {
+public:
+    ARC(size_t max_size = 1024, double ghost_share = 0.25);
+    ~ARC() {}
+
+    // Implements Afina::Storage interface
+    bool Put(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsent(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Set(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Delete(const std::string &key) override;
+
+    // Implements Afina::Storage interface
+    bool Get(const std::string &key, std::string &value) override;
+
+    // Implements Afina::Storage interface
+    void GetUsage(Usage &usage) override;
+
+private:
+    struct Item {
+        Item(const std::string &k, const std::string &v) : key(k), value(v), charge(0), frequent(false) {}
+
+        const std::string key;
+        std::string value;
+
+        // Bytes item is charged with, see Charge
+        std::size_t charge;
+
+        // Item is in T2 rather than T1
+        bool frequent;
+    };
+
+    // Evicted key, as much of it as needed to adapt
+    struct Ghost {
+        std::size_t hash;
+
+        // Charge of the evicted item
+        std::size_t charge;
+
+        // Ghost is in B2 rather than B1
+        bool frequent;
+    };
+
+    // Lists are ordered from the most recently used entry to the least one
+    using Resident = std::list<Item>;
+    using Ghosts = std::list<Ghost>;
+    using Index = std::map<std::reference_wrapper<const std::string>, Resident::iterator, std::less<std::string>>;
+    using GhostIndex = std::unordered_map<std::size_t, Ghosts::iterator>;
+
+    // Bytes of heap taken by the item together with its list and index nodes
+    static std::size_t Charge(const Item &item);
+
+    // Bytes of heap taken by the ghost with its list and index nodes
+    static std::size_t GhostCharge();
+
+    // Inserts new item into T1, or into T2 if it has a ghost
+    bool Insert(const std::string &key, const std::string &value);
+
+    // Replaces value of the existing item, which counts as a hit
+    bool Replace(Index::iterator found, const std::string &value);
+
+    // Moves requested item to the head of T2
+    void Promote(Resident::iterator item);
+
+    // Moves tail of T1 or T2 to the ghost list, depending on target size of T1. Key requested is from B2
+    void Evict(bool frequent_ghost);
+
+    // Removes least recent ghost of the list
+    void DropGhost(Ghosts &ghosts);
+
+    // Removes ghost from its list and index
+    void RemoveGhost(GhostIndex::iterator found);
+
+    // Removes item from its list and index
+    void Remove(Index::iterator found);
+
+    // Maximum number of bytes items may take and ghosts may take above that, max_size in total
+    const std::size_t _max_size;
+    const std::size_t _ghost_max;
+
+    // Target size of T1, moves between zero and items budget
+    std::size_t _target;
+
+    // Bytes items of T1 and T2 and ghosts of B1 and B2 account for, see Ghost
+    std::size_t _t1_size;
+    std::size_t _t2_size;
+    std::size_t _b1_size;
+    std::size_t _b2_size;
+
+    // Bytes ghosts really take and total size of keys and values
+    std::size_t _ghost_bytes;
+    std::size_t _payload;
+
+    uint64_t _evictions;
+
+    Resident _t1;
+    Resident _t2;
+    Ghosts _b1;
+    Ghosts _b2;
+    Index _index;
+    GhostIndex _ghost_index;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_ARC_H
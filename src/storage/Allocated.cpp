@@ -0,0 +1,36 @@
+#include "Allocated.h"
+
+namespace Afina {
+namespace Backend {
+
+namespace {
+
+// Chunk header, alignment and the smallest chunk of glibc malloc on 64-bit targets
+const std::size_t header = sizeof(std::size_t);
+const std::size_t alignment = 2 * sizeof(std::size_t);
+const std::size_t min_chunk = 4 * sizeof(std::size_t);
+
+// Blocks that large are mapped on their own, in whole pages
+const std::size_t mmap_threshold = 128 * 1024;
+const std::size_t page = 4096;
+
+} // namespace
+
+// See Allocated.h
+std::size_t Allocated(std::size_t size) {
+    if (size >= mmap_threshold) {
+        return (size + header + page - 1) & ~(page - 1);
+    }
+
+    std::size_t chunk = (size + header + alignment - 1) & ~(alignment - 1);
+    return chunk < min_chunk ? min_chunk : chunk;
+}
+
+// See Allocated.h
+std::size_t Allocated(const std::string &s) {
+    static const std::size_t inline_capacity = std::string().capacity();
+    return s.capacity() > inline_capacity ? Allocated(s.capacity() + 1) : 0;
+}
+
+} // namespace Backend
+} // namespace Afina
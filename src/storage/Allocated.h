@@ -0,0 +1,25 @@
+#ifndef AFINA_STORAGE_ALLOCATED_H
+#define AFINA_STORAGE_ALLOCATED_H
+
+#include <cstddef>
+#include <string>
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * Bytes allocator takes for the block of the given size, including its header and alignment. Computed the way
+ * glibc malloc sizes its chunks rather than asked from the allocator, as a block reused from the free lists may be
+ * larger than requested and the charge would then depend on the heap history
+ */
+std::size_t Allocated(std::size_t size);
+
+/**
+ * Bytes allocator takes for the string data: short strings are kept inline, longer ones in a block of their own
+ */
+std::size_t Allocated(const std::string &s);
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_ALLOCATED_H
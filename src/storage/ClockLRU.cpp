@@ -0,0 +1,309 @@
+#include "ClockLRU.h"
+
+#include <algorithm>
+#include <functional>
+
+#include "Allocated.h"
+
+namespace Afina {
+namespace Backend {
+
+namespace {
+
+// Number of buckets for the storage of the given size: power of two with a few hundred bytes per bucket, so chains
+// of small items stay short and buckets take a few percent of the memory
+std::size_t Buckets(std::size_t max_size) {
+    std::size_t buckets = 16;
+    while (buckets < max_size / 256) {
+        buckets <<= 1;
+    }
+    return buckets;
+}
+
+} // namespace
+
+// See ClockLRU.h
+ClockLRU::ClockLRU(size_t max_size)
+    : _max_size(max_size), _mask(Buckets(max_size) - 1), _buckets(new std::atomic<Entry *>[_mask + 1]), _hand(0),
+      _items(0), _size(0), _payload(0), _retired_size(0), _evictions(0) {
+    for (std::size_t i = 0; i <= _mask; i++) {
+        _buckets[i].store(nullptr, std::memory_order_relaxed);
+    }
+}
+
+// See ClockLRU.h
+ClockLRU::~ClockLRU() {
+    for (Entry *entry : _slots) {
+        delete entry;
+    }
+    for (Entry *entry : _retired) {
+        delete entry;
+    }
+}
+
+// See ClockLRU.h
+std::size_t ClockLRU::Charge(const Entry &entry) {
+    return Allocated(sizeof(Entry)) + Allocated(entry.key) + Allocated(entry.value);
+}
+
+// See ClockLRU.h
+bool ClockLRU::Put(const std::string &key, const std::string &value) {
+    std::size_t hash = std::hash<std::string>()(key);
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    Entry *found = Find(key, hash).load(std::memory_order_relaxed);
+    bool result = found == nullptr ? Insert(key, value, hash) : Replace(found, value);
+    Reclaim();
+    return result;
+}
+
+// See ClockLRU.h
+bool ClockLRU::PutIfAbsent(const std::string &key, const std::string &value) {
+    std::size_t hash = std::hash<std::string>()(key);
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    if (Find(key, hash).load(std::memory_order_relaxed) != nullptr) {
+        return false;
+    }
+    bool result = Insert(key, value, hash);
+    Reclaim();
+    return result;
+}
+
+// See ClockLRU.h
+bool ClockLRU::Set(const std::string &key, const std::string &value) {
+    std::size_t hash = std::hash<std::string>()(key);
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    Entry *found = Find(key, hash).load(std::memory_order_relaxed);
+    if (found == nullptr) {
+        return false;
+    }
+    bool result = Replace(found, value);
+    Reclaim();
+    return result;
+}
+
+// See ClockLRU.h
+bool ClockLRU::Delete(const std::string &key) {
+    std::size_t hash = std::hash<std::string>()(key);
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    std::atomic<Entry *> &link = Find(key, hash);
+    if (link.load(std::memory_order_relaxed) == nullptr) {
+        return false;
+    }
+    Unlink(link);
+    Reclaim();
+    return true;
+}
+
+// See ClockLRU.h
+bool ClockLRU::Get(const std::string &key, std::string &value) {
+    std::size_t hash = std::hash<std::string>()(key);
+    Concurrency::Epoch::Guard guard(_epoch);
+
+    // Acquire pairs with the release store linking the entry, so it is seen fully built
+    Entry *entry = _buckets[hash & _mask].load(std::memory_order_acquire);
+    for (; entry != nullptr; entry = entry->next.load(std::memory_order_acquire)) {
+        if (entry->hash == hash && entry->key == key) {
+            break;
+        }
+    }
+    if (entry == nullptr) {
+        return false;
+    }
+
+    // Bit of a hot key is mostly set already, reading it first leaves its cache line shared between readers
+    if (!entry->referenced.load(std::memory_order_relaxed)) {
+        entry->referenced.store(true, std::memory_order_relaxed);
+    }
+    value = entry->value;
+    return true;
+}
+
+// See ClockLRU.h
+void ClockLRU::GetUsage(Usage &usage) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    usage.items = _items;
+    usage.bytes = _size + Overhead() + _retired_size;
+    usage.overhead = usage.bytes - _payload;
+    usage.limit = _max_size;
+    usage.evictions = _evictions;
+}
+
+// See ClockLRU.h
+std::atomic<ClockLRU::Entry *> &ClockLRU::Find(const std::string &key, std::size_t hash) {
+    // Only writers change links and they hold the mutex, so nothing has to be synchronized here
+    std::atomic<Entry *> *link = &_buckets[hash & _mask];
+    for (Entry *entry = link->load(std::memory_order_relaxed); entry != nullptr;
+         entry = link->load(std::memory_order_relaxed)) {
+        if (entry->hash == hash && entry->key == key) {
+            break;
+        }
+        link = &entry->next;
+    }
+    return *link;
+}
+
+// See ClockLRU.h
+bool ClockLRU::Insert(const std::string &key, const std::string &value, std::size_t hash) {
+    if (key.size() + value.size() > _max_size) {
+        return false;
+    }
+
+    std::unique_ptr<Entry> entry(new Entry(key, value, hash));
+    entry->charge = Charge(*entry);
+    if (!MakeRoom(entry->charge, nullptr)) {
+        return false;
+    }
+
+    if (_free_slots.empty()) {
+        entry->slot = _slots.size();
+        _slots.push_back(entry.get());
+
+        // Each slot could be freed at once, so freeing one never allocates
+        _free_slots.reserve(_slots.capacity());
+    } else {
+        entry->slot = _free_slots.back();
+        _free_slots.pop_back();
+        _slots[entry->slot] = entry.get();
+    }
+
+    _items++;
+    _size += entry->charge;
+    _payload += key.size() + value.size();
+
+    // Entry is complete before it becomes reachable
+    Find(key, hash).store(entry.release(), std::memory_order_release);
+    return true;
+}
+
+// See ClockLRU.h
+bool ClockLRU::Replace(Entry *old, const std::string &value) {
+    if (old->key.size() + value.size() > _max_size) {
+        return false;
+    }
+
+    std::unique_ptr<Entry> entry(new Entry(old->key, value, old->hash));
+    entry->charge = Charge(*entry);
+
+    // Old entry leaves as the new one comes, so room is made as if it was gone already
+    _size -= old->charge;
+    bool fits = MakeRoom(entry->charge, old);
+    _size += old->charge;
+
+    // Item doesn't fit even alone, old value is stale anyway
+    std::atomic<Entry *> &link = Find(old->key, old->hash);
+    if (!fits) {
+        Unlink(link);
+        return false;
+    }
+
+    // Update is a request for the key, as in the other storages it makes item the most recent one
+    entry->slot = old->slot;
+    entry->referenced.store(true, std::memory_order_relaxed);
+    entry->next.store(old->next.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    _slots[entry->slot] = entry.get();
+
+    _size += entry->charge - old->charge;
+    _payload += value.size() - old->value.size();
+
+    // Readers holding the old entry still walk the chain on from it
+    link.store(entry.release(), std::memory_order_release);
+    Retire(old);
+    return true;
+}
+
+// See ClockLRU.h
+bool ClockLRU::MakeRoom(std::size_t bytes, const Entry *keep) {
+    // Retired entries are not counted: they are freed as soon as readers let, and evicting more wouldn't help that
+    std::size_t evictable = _items - (keep != nullptr ? 1 : 0);
+    while (_size + Overhead() + Growth() + bytes > _max_size) {
+        if (evictable == 0) {
+            return false;
+        }
+        Evict(keep);
+        evictable--;
+    }
+    return true;
+}
+
+// See ClockLRU.h
+void ClockLRU::Evict(const Entry *keep) {
+    // Readers may set bits again behind the hand, after two full turns the entry goes anyway
+    for (std::size_t step = 0;; step++) {
+        if (_hand >= _slots.size()) {
+            _hand = 0;
+        }
+
+        Entry *entry = _slots[_hand++];
+        if (entry == nullptr || entry == keep) {
+            continue;
+        }
+        if (entry->referenced.load(std::memory_order_relaxed) && step < 2 * _slots.size()) {
+            entry->referenced.store(false, std::memory_order_relaxed);
+            continue;
+        }
+
+        Unlink(Find(entry->key, entry->hash));
+        _evictions++;
+        return;
+    }
+}
+
+// See ClockLRU.h
+void ClockLRU::Unlink(std::atomic<Entry *> &link) {
+    Entry *entry = link.load(std::memory_order_relaxed);
+
+    // Entry keeps its next link, so readers standing on it still reach the rest of the chain
+    link.store(entry->next.load(std::memory_order_relaxed), std::memory_order_release);
+    _slots[entry->slot] = nullptr;
+    _free_slots.push_back(entry->slot);
+
+    _items--;
+    _size -= entry->charge;
+    _payload -= entry->key.size() + entry->value.size();
+    Retire(entry);
+}
+
+// See ClockLRU.h
+void ClockLRU::Retire(Entry *entry) {
+    entry->slot = _epoch.Current();
+    _retired.push_back(entry);
+    _retired_size += entry->charge;
+}
+
+// See ClockLRU.h
+void ClockLRU::Reclaim() {
+    if (_retired.empty()) {
+        return;
+    }
+
+    uint64_t oldest = _epoch.Advance();
+    auto kept = std::partition(_retired.begin(), _retired.end(), [oldest](Entry *entry) {
+        return entry->slot >= oldest;
+    });
+    for (auto it = kept; it != _retired.end(); ++it) {
+        _retired_size -= (*it)->charge;
+        delete *it;
+    }
+    _retired.erase(kept, _retired.end());
+}
+
+// See ClockLRU.h
+std::size_t ClockLRU::Overhead() const {
+    return Allocated((_mask + 1) * sizeof(std::atomic<Entry *>)) + _slots.capacity() * sizeof(Entry *) +
+           _free_slots.capacity() * sizeof(std::size_t);
+}
+
+// See ClockLRU.h
+std::size_t ClockLRU::Growth() const {
+    if (!_free_slots.empty() || _slots.size() < _slots.capacity()) {
+        return 0;
+    }
+    return std::max<std::size_t>(_slots.capacity(), 1) * (sizeof(Entry *) + sizeof(std::size_t));
+}
+
+} // namespace Backend
+} // namespace Afina
@@ -0,0 +1,141 @@
+#ifndef AFINA_STORAGE_CLOCK_LRU_H
+#define AFINA_STORAGE_CLOCK_LRU_H
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <afina/Storage.h>
+#include <afina/concurrency/Epoch.h>
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # CLOCK approximation of LRU
+ * That is thread safe implementation, Get never takes a lock.
+ *
+ * Entries sit in a circular array of slots. Hit only sets the entry reference bit, and does it with a relaxed
+ * store if the bit is not set yet, so hot keys are read by many threads without writing shared memory. To make
+ * room the hand sweeps slots: referenced entry gets its bit cleared and the second chance, the first one found
+ * unreferenced is evicted. New entries start unreferenced, so keys requested once go first, as in SegmentedLRU.
+ *
+ * Index is a hash table of a fixed number of buckets with chains linked by atomic pointers. Writers take the
+ * mutex and publish changes with release stores, Get walks the chain with acquire loads inside an epoch guard.
+ * Entry is never changed once linked: update links the new one instead and the old one is freed only when no
+ * reader may be holding it, see Concurrency::Epoch.
+ *
+ * Items are charged with all the heap they take, as in SimpleLRU. Buckets, slots and entries waiting for readers
+ * to leave are charged as well, the latter are few and may briefly take memory above max_size
+ */
+class ClockLRU : public Afina::Storage {
+public:
+    ClockLRU(size_t max_size = 1024);
+    ~ClockLRU();
+
+    // Implements Afina::Storage interface
+    bool Put(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsent(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Set(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Delete(const std::string &key) override;
+
+    // Implements Afina::Storage interface
+    bool Get(const std::string &key, std::string &value) override;
+
+    // Implements Afina::Storage interface
+    void GetUsage(Usage &usage) override;
+
+private:
+    struct Entry {
+        Entry(const std::string &k, const std::string &v, std::size_t h)
+            : key(k), value(v), hash(h), charge(0), slot(0), next(nullptr), referenced(false) {}
+
+        const std::string key;
+        const std::string value;
+        const std::size_t hash;
+
+        // Bytes entry is charged with, see Charge
+        std::size_t charge;
+
+        // Position in slots, once entry is retired it is the epoch it was unlinked in
+        std::size_t slot;
+
+        std::atomic<Entry *> next;
+        std::atomic<bool> referenced;
+    };
+
+    // Bytes of heap taken by the entry
+    static std::size_t Charge(const Entry &entry);
+
+    // Returns link pointing to the entry of the key, or the null one ending the chain if there is none. Eviction
+    // may unlink entry holding the link, so it is looked up again after room is made
+    std::atomic<Entry *> &Find(const std::string &key, std::size_t hash);
+
+    // Links new entry to the chain end and places it into a free slot
+    bool Insert(const std::string &key, const std::string &value, std::size_t hash);
+
+    // Links new entry in place of the existing one
+    bool Replace(Entry *old, const std::string &value);
+
+    // Evicts entries until that many bytes more fit, the one to keep is never evicted
+    bool MakeRoom(std::size_t bytes, const Entry *keep);
+
+    // Moves the hand to the first unreferenced entry and evicts it
+    void Evict(const Entry *keep);
+
+    // Unlinks entry the link points to from its chain and slot
+    void Unlink(std::atomic<Entry *> &link);
+
+    // Leaves unlinked entry to be freed once readers are done with it
+    void Retire(Entry *entry);
+
+    // Frees retired entries that no reader holds anymore
+    void Reclaim();
+
+    // Bytes taken by buckets and slots
+    std::size_t Overhead() const;
+
+    // Bytes slots would grow by if one more entry was placed
+    std::size_t Growth() const;
+
+    // Maximum number of bytes storage may take
+    const std::size_t _max_size;
+
+    // Index buckets, number of them is a power of two
+    const std::size_t _mask;
+    std::unique_ptr<std::atomic<Entry *>[]> _buckets;
+
+    // Serializes writers
+    std::mutex _mutex;
+
+    // Circular array hand sweeps, empty slots are null and listed in _free_slots
+    std::vector<Entry *> _slots;
+    std::vector<std::size_t> _free_slots;
+    std::size_t _hand;
+
+    // Entries in the index, bytes they are charged with and total size of their keys and values
+    std::size_t _items;
+    std::size_t _size;
+    std::size_t _payload;
+
+    // Entries unlinked but maybe still held by readers, and bytes they are charged with
+    std::vector<Entry *> _retired;
+    std::size_t _retired_size;
+
+    uint64_t _evictions;
+
+    Concurrency::Epoch _epoch;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_CLOCK_LRU_H
@@ -0,0 +1,115 @@
+#include "FrequencySketch.h"
+
+#include <algorithm>
+#include <functional>
+
+namespace Afina {
+namespace Backend {
+
+namespace {
+
+const int rows = 4;
+const int counter_bits = 4;
+const unsigned counter_max = (1 << counter_bits) - 1;
+const std::size_t counters_per_word = 64 / counter_bits;
+
+// Doorkeeper has that many bits for each counter of the row and sets that many of them for a key
+const std::size_t doorkeeper_bits = 4;
+const int doorkeeper_probes = 2;
+
+// Spreads hash bits evenly over both halves, as each of them makes an index on its own
+uint64_t Mix(uint64_t x) {
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x >> 33;
+    return x;
+}
+
+} // namespace
+
+// See FrequencySketch.h
+FrequencySketch::FrequencySketch(std::size_t items) : _width(counters_per_word), _samples(0) {
+    while (_width * 2 <= items) {
+        _width *= 2;
+    }
+    _counters.assign(rows * _width / counters_per_word, 0);
+    _doorkeeper.assign(doorkeeper_bits * _width / 64, 0);
+    _sample_limit = 10 * _width;
+}
+
+// See FrequencySketch.h
+std::size_t FrequencySketch::Counter(uint64_t hash, int row) const {
+    // Rows take different hashes made of two halves of the one, as in Kirsch and Mitzenmacher
+    uint32_t h1 = hash, h2 = (hash >> 32) | 1;
+    return row * _width + ((h1 + row * h2) & (_width - 1));
+}
+
+// See FrequencySketch.h
+std::size_t FrequencySketch::Bit(uint64_t hash, int probe) const {
+    uint32_t h1 = hash, h2 = (hash >> 32) | 1;
+    return (h1 + (rows + probe) * h2) & (doorkeeper_bits * _width - 1);
+}
+
+// See FrequencySketch.h
+void FrequencySketch::Record(const std::string &key) {
+    uint64_t hash = Mix(std::hash<std::string>()(key));
+
+    bool seen = true;
+    for (int probe = 0; probe < doorkeeper_probes; probe++) {
+        std::size_t bit = Bit(hash, probe);
+        uint64_t mask = uint64_t(1) << (bit % 64);
+        seen &= (_doorkeeper[bit / 64] & mask) != 0;
+        _doorkeeper[bit / 64] |= mask;
+    }
+
+    if (seen) {
+        for (int row = 0; row < rows; row++) {
+            std::size_t counter = Counter(hash, row);
+            uint64_t &word = _counters[counter / counters_per_word];
+            int shift = (counter % counters_per_word) * counter_bits;
+            if (((word >> shift) & counter_max) < counter_max) {
+                word += uint64_t(1) << shift;
+            }
+        }
+    }
+
+    if (++_samples >= _sample_limit) {
+        Age();
+    }
+}
+
+// See FrequencySketch.h
+unsigned FrequencySketch::Estimate(const std::string &key) const {
+    uint64_t hash = Mix(std::hash<std::string>()(key));
+
+    unsigned result = counter_max;
+    for (int row = 0; row < rows; row++) {
+        std::size_t counter = Counter(hash, row);
+        uint64_t word = _counters[counter / counters_per_word];
+        result = std::min<unsigned>(result, (word >> ((counter % counters_per_word) * counter_bits)) & counter_max);
+    }
+
+    // Doorkeeper holds the first access of the key
+    for (int probe = 0; probe < doorkeeper_probes; probe++) {
+        std::size_t bit = Bit(hash, probe);
+        if ((_doorkeeper[bit / 64] & (uint64_t(1) << (bit % 64))) == 0) {
+            return result;
+        }
+    }
+    return result + 1;
+}
+
+// See FrequencySketch.h
+void FrequencySketch::Age() {
+    // Each counter is shifted right, bit shifted in from the next counter is masked out
+    for (auto &word : _counters) {
+        word = (word >> 1) & 0x7777777777777777ULL;
+    }
+    std::fill(_doorkeeper.begin(), _doorkeeper.end(), 0);
+    _samples /= 2;
+}
+
+} // namespace Backend
+} // namespace Afina
@@ -0,0 +1,62 @@
+#ifndef AFINA_STORAGE_FREQUENCY_SKETCH_H
+#define AFINA_STORAGE_FREQUENCY_SKETCH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Approximate access frequency of keys, as TinyLFU admission needs it
+ *
+ * Count-min sketch of four rows of 4-bit counters. Estimate is the least of key counters, so it could only be
+ * overestimated by collisions. Key seen for the first time sets bits of the doorkeeper Bloom filter only, so that
+ * one-hit wonders, which are most of the keys in real traces, don't take the counters.
+ *
+ * Once the number of records reaches ten times the width, all counters are halved and doorkeeper is cleared: old
+ * popularity fades and the counters never saturate for long
+ */
+class FrequencySketch {
+public:
+    // Width is the power of two not above the number of items, the storage is expected to hold
+    explicit FrequencySketch(std::size_t items);
+
+    // Counts one more access to the key
+    void Record(const std::string &key);
+
+    // Returns approximate number of the key accesses since the last aging, up to 16
+    unsigned Estimate(const std::string &key) const;
+
+    // Bytes taken by the counters and doorkeeper
+    std::size_t Bytes() const { return (_counters.size() + _doorkeeper.size()) * sizeof(uint64_t); }
+
+private:
+    // Halves all counters and clears doorkeeper
+    void Age();
+
+    // Returns index of the key counter in the given row
+    std::size_t Counter(uint64_t hash, int row) const;
+
+    // Returns index of the key bit in doorkeeper for the given probe
+    std::size_t Bit(uint64_t hash, int probe) const;
+
+    // 4-bit counters, sixteen in a word, rows follow one another
+    std::vector<uint64_t> _counters;
+
+    // Bloom filter of keys seen since the last aging
+    std::vector<uint64_t> _doorkeeper;
+
+    std::size_t _width;
+
+    // Records since the last aging and the number of them that triggers the next one
+    std::size_t _samples;
+    std::size_t _sample_limit;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_FREQUENCY_SKETCH_H
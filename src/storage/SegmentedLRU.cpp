@@ -0,0 +1,262 @@
+#include "SegmentedLRU.h"
+
+#include <algorithm>
+#include <iterator>
+
+#include "Allocated.h"
+
+namespace Afina {
+namespace Backend {
+
+// See SegmentedLRU.h
+SegmentedLRU::SegmentedLRU(size_t max_size, double protected_share, bool admission)
+    : _max_size(max_size), _window_max(0), _sizes(), _payload(0), _evictions(0) {
+    if (admission) {
+        // Storage can't hold more keys than list nodes fit into it, there is no use in telling more of them apart
+        _sketch.reset(new FrequencySketch(max_size / (2 * sizeof(void *) + sizeof(Item))));
+        _max_size -= std::min(_max_size, _sketch->Bytes());
+        _window_max = _max_size / 100;
+    }
+    _protected_max = (_max_size - _window_max) * protected_share;
+}
+
+// See SegmentedLRU.h
+std::size_t SegmentedLRU::Charge(const Item &item) {
+    // List node is two pointers followed by the item, index node is color and three pointers followed by the entry
+    static const std::size_t list_node = Allocated(2 * sizeof(void *) + sizeof(Item));
+    static const std::size_t index_node = Allocated(3 * sizeof(void *) + sizeof(int) + sizeof(Index::value_type));
+
+    return list_node + index_node + Allocated(item.key) + Allocated(item.value);
+}
+
+// See SegmentedLRU.h
+bool SegmentedLRU::Put(const std::string &key, const std::string &value) {
+    if (_sketch) {
+        _sketch->Record(key);
+    }
+
+    auto found = _index.find(key);
+    if (found == _index.end()) {
+        return Insert(key, value);
+    } else {
+        return Replace(found, value);
+    }
+}
+
+// See SegmentedLRU.h
+bool SegmentedLRU::PutIfAbsent(const std::string &key, const std::string &value) {
+    if (_sketch) {
+        _sketch->Record(key);
+    }
+
+    if (_index.find(key) != _index.end()) {
+        return false;
+    }
+    return Insert(key, value);
+}
+
+// See SegmentedLRU.h
+bool SegmentedLRU::Set(const std::string &key, const std::string &value) {
+    if (_sketch) {
+        _sketch->Record(key);
+    }
+
+    auto found = _index.find(key);
+    if (found == _index.end()) {
+        return false;
+    }
+    return Replace(found, value);
+}
+
+// See SegmentedLRU.h
+bool SegmentedLRU::Delete(const std::string &key) {
+    auto found = _index.find(key);
+    if (found == _index.end()) {
+        return false;
+    }
+    Remove(found);
+    return true;
+}
+
+// See SegmentedLRU.h
+bool SegmentedLRU::Get(const std::string &key, std::string &value) {
+    if (_sketch) {
+        _sketch->Record(key);
+    }
+
+    auto found = _index.find(key);
+    if (found == _index.end()) {
+        return false;
+    }
+
+    value = found->second->value;
+    Promote(found->second);
+    return true;
+}
+
+// See SegmentedLRU.h
+void SegmentedLRU::GetUsage(Usage &usage) {
+    std::size_t sketch = _sketch ? _sketch->Bytes() : 0;
+    usage.items = _index.size();
+    usage.bytes = _sizes[WINDOW] + MainSize() + sketch;
+    usage.overhead = usage.bytes - _payload;
+    usage.limit = _max_size + sketch;
+    usage.evictions = _evictions;
+}
+
+// See SegmentedLRU.h
+bool SegmentedLRU::Insert(const std::string &key, const std::string &value) {
+    if (key.size() + value.size() > _max_size) {
+        return false;
+    }
+
+    // Item is built aside to know its size, it has to fit into main segments sooner or later
+    Segment fresh;
+    fresh.emplace_front(key, value);
+    Item &item = fresh.front();
+    item.charge = Charge(item);
+    if (item.charge > _max_size - _window_max) {
+        return false;
+    }
+
+    _segments[WINDOW].splice(_segments[WINDOW].begin(), fresh);
+    _sizes[WINDOW] += item.charge;
+    _payload += key.size() + value.size();
+    _index.emplace(std::cref(item.key), _segments[WINDOW].begin());
+
+    // Without admission window is empty and the new item goes through it right away. Item rejected there is
+    // stored and evicted as far as the client is concerned
+    Drain(item, false);
+    return true;
+}
+
+// See SegmentedLRU.h
+void SegmentedLRU::Drain(const Item &item, bool admitted) {
+    while (_sizes[WINDOW] > _window_max) {
+        auto candidate = std::prev(_segments[WINDOW].end());
+        if ((admitted && &*candidate == &item) || Admit(*candidate)) {
+            while (MainSize() + candidate->charge > _max_size - _window_max) {
+                Evict(nullptr);
+            }
+            Move(candidate, PROBATION);
+        } else {
+            Remove(_index.find(candidate->key));
+            _evictions++;
+        }
+    }
+}
+
+// See SegmentedLRU.h
+bool SegmentedLRU::Admit(const Item &candidate) const {
+    std::size_t room = _max_size - _window_max - MainSize();
+    if (room >= candidate.charge || !_sketch) {
+        return true;
+    }
+
+    // Victims are walked as Evict would take them, ties go to the items already stored
+    unsigned frequency = _sketch->Estimate(candidate.key);
+    for (Place place : {PROBATION, PROTECTED}) {
+        const Segment &victims = _segments[place];
+        for (auto victim = victims.rbegin(); victim != victims.rend() && room < candidate.charge; ++victim) {
+            if (_sketch->Estimate(victim->key) >= frequency) {
+                return false;
+            }
+            room += victim->charge;
+        }
+    }
+    return true;
+}
+
+// See SegmentedLRU.h
+bool SegmentedLRU::Replace(Index::iterator found, const std::string &value) {
+    Segment::iterator item = found->second;
+    if (item->key.size() + value.size() > _max_size) {
+        return false;
+    }
+
+    _sizes[item->place] -= item->charge;
+    _payload += value.size() - item->value.size();
+    if (value.size() < item->value.capacity() / 2) {
+        // Assignment keeps the buffer, which is mostly wasted then
+        std::string(value).swap(item->value);
+    } else {
+        item->value = value;
+    }
+    item->charge = Charge(*item);
+    _sizes[item->place] += item->charge;
+
+    // Item doesn't fit even alone, old value is stale anyway
+    if (item->charge > _max_size - _window_max) {
+        Remove(found);
+        return false;
+    }
+
+    // Update is a request for the key, so it is promoted as on Get. Key is in the storage already, room for the
+    // larger value is made without asking admission
+    Promote(item);
+    if (item->place == WINDOW) {
+        Drain(*item, true);
+        return true;
+    }
+    while (MainSize() > _max_size - _window_max) {
+        Evict(&*item);
+    }
+    return true;
+}
+
+// See SegmentedLRU.h
+void SegmentedLRU::Move(Segment::iterator item, Place place) {
+    _sizes[item->place] -= item->charge;
+    _sizes[place] += item->charge;
+    _segments[place].splice(_segments[place].begin(), _segments[item->place], item);
+    item->place = place;
+}
+
+// See SegmentedLRU.h
+void SegmentedLRU::Promote(Segment::iterator item) {
+    if (item->place == WINDOW) {
+        Move(item, WINDOW);
+    } else {
+        // Item already protected might have grown on update, so the share is checked after every move
+        Move(item, PROTECTED);
+        Demote();
+    }
+}
+
+// See SegmentedLRU.h
+void SegmentedLRU::Demote() {
+    while (_sizes[PROTECTED] > _protected_max) {
+        Move(std::prev(_segments[PROTECTED].end()), PROBATION);
+    }
+}
+
+// See SegmentedLRU.h
+void SegmentedLRU::Evict(const Item *keep) {
+    for (Place place : {PROBATION, PROTECTED}) {
+        Segment &victims = _segments[place];
+        auto victim = victims.rbegin();
+        if (victim != victims.rend() && &*victim == keep) {
+            ++victim;
+        }
+        if (victim != victims.rend()) {
+            Remove(_index.find(victim->key));
+            _evictions++;
+            return;
+        }
+    }
+}
+
+// See SegmentedLRU.h
+void SegmentedLRU::Remove(Index::iterator found) {
+    Segment::iterator item = found->second;
+    Place place = item->place;
+    _sizes[place] -= item->charge;
+    _payload -= item->key.size() + item->value.size();
+
+    // Index refers to the key kept in the item, so it goes first
+    _index.erase(found);
+    _segments[place].erase(item);
+}
+
+} // namespace Backend
+} // namespace Afina
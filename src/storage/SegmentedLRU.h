@@ -0,0 +1,133 @@
+#ifndef AFINA_STORAGE_SEGMENTED_LRU_H
+#define AFINA_STORAGE_SEGMENTED_LRU_H
+
+#include <functional>
+#include <list>
+#include <map>
+#include <memory>
+#include <string>
+
+#include <afina/Storage.h>
+
+#include "FrequencySketch.h"
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Segmented LRU
+ * That is NOT thread safe implementaiton!!
+ *
+ * Items are kept in two LRU lists. New item goes to the probation segment and moves to the protected one once it
+ * is requested again. Protected segment takes at most protected_share of the memory, items that don't fit there
+ * are demoted back to probation. Eviction takes the least recent item of probation, so keys that are requested
+ * once, like the ones of a scan, push out each other rather than the hot ones.
+ *
+ * With admission on, that is W-TinyLFU: new items get into the window LRU taking 1% of memory first. Item pushed
+ * out of the window moves to probation only if TinyLFU estimates its key as more frequent than each of the items it
+ * would evict from there, otherwise it is evicted itself. Window keeps recent bursts, while the main segments keep
+ * keys frequent over the longer run. Frequency sketch takes its bytes out of max_size
+ *
+ * Items are charged with all the heap they take, same as in SimpleLRU
+ */
+class SegmentedLRU : public Afina::Storage {
+public:
+    SegmentedLRU(size_t max_size = 1024, double protected_share = 0.8, bool admission = false);
+    ~SegmentedLRU() {}
+
+    // Implements Afina::Storage interface
+    bool Put(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsent(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Set(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Delete(const std::string &key) override;
+
+    // Implements Afina::Storage interface
+    bool Get(const std::string &key, std::string &value) override;
+
+    // Implements Afina::Storage interface
+    void GetUsage(Usage &usage) override;
+
+private:
+    enum Place { WINDOW, PROBATION, PROTECTED, PLACES };
+
+    struct Item {
+        Item(const std::string &k, const std::string &v) : key(k), value(v), charge(0), place(WINDOW) {}
+
+        const std::string key;
+        std::string value;
+
+        // Bytes item is charged with, see Charge
+        std::size_t charge;
+
+        // Which segment item is in
+        Place place;
+    };
+
+    // Segments are ordered from the most recently used item to the least one
+    using Segment = std::list<Item>;
+    using Index = std::map<std::reference_wrapper<const std::string>, Segment::iterator, std::less<std::string>>;
+
+    // Bytes of heap taken by the item together with its list and index nodes
+    static std::size_t Charge(const Item &item);
+
+    // Inserts new item into window and moves the ones pushed out of it to probation
+    bool Insert(const std::string &key, const std::string &value);
+
+    // Moves items pushed out of window to probation, the ones admission rejects are evicted instead. Item that is
+    // admitted already skips the check
+    void Drain(const Item &item, bool admitted);
+
+    // Checks that the item fits into main segments or its key is more frequent than each of the items that would
+    // be evicted to make a room
+    bool Admit(const Item &candidate) const;
+
+    // Replaces value of the existing item in place, which counts as a hit
+    bool Replace(Index::iterator found, const std::string &value);
+
+    // Moves item to the head of the segment
+    void Move(Segment::iterator item, Place place);
+
+    // Moves requested item to the head of protected segment, or of window if it is there
+    void Promote(Segment::iterator item);
+
+    // Moves tail of protected segment to probation until it fits its share
+    void Demote();
+
+    // Removes least recently used item of probation, or of protected one if probation is empty. Items of window
+    // and the one to keep are never taken
+    void Evict(const Item *keep);
+
+    // Removes item from its segment and index
+    void Remove(Index::iterator found);
+
+    // Bytes items of main segments take in total
+    std::size_t MainSize() const { return _sizes[PROBATION] + _sizes[PROTECTED]; }
+
+    // Maximum number of bytes items may take and parts of it window and protected segment may take
+    std::size_t _max_size;
+    std::size_t _window_max;
+    std::size_t _protected_max;
+
+    // Bytes items of each segment take and total size of keys and values
+    std::size_t _sizes[PLACES];
+    std::size_t _payload;
+
+    uint64_t _evictions;
+
+    // Access frequencies of keys for admission, none if it is off
+    std::unique_ptr<FrequencySketch> _sketch;
+
+    Segment _segments[PLACES];
+    Index _index;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_SEGMENTED_LRU_H
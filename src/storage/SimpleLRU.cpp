@@ -1,9 +1,32 @@
 #include "SimpleLRU.h"
-#include <iostream>
+
+#include <algorithm>
+
+#include "Allocated.h"
 
 namespace Afina {
 namespace Backend {
 
+// See SimpleLRU.h
+SimpleLRU::SimpleLRU(size_t max_size, bool admission)
+    : _max_size(max_size), _cur_size(0), _payload(0), _evictions(0), _lru_head(nullptr), _lru_tail(nullptr),
+      _lru_index() {
+    if (admission) {
+        // Storage can't hold more keys than nodes fit into it, there is no use in telling more of them apart
+        _sketch.reset(new FrequencySketch(max_size / sizeof(lru_node)));
+        _max_size -= std::min(_max_size, _sketch->Bytes());
+    }
+}
+
+// See SimpleLRU.h
+std::size_t SimpleLRU::Charge(const lru_node &node) {
+    // Index node is color and three pointers followed by the entry, it is hidden inside of std::map
+    using index_entry = decltype(_lru_index)::value_type;
+    static const std::size_t index_node = Allocated(3 * sizeof(void *) + sizeof(int) + sizeof(index_entry));
+
+    return Allocated(sizeof(lru_node)) + Allocated(node.key) + Allocated(node.value) + index_node;
+}
+
 bool SimpleLRU::ReplaceData(const std::map<std::reference_wrapper<const std::string>, std::reference_wrapper<lru_node>,
                                            std::less<std::string>>::iterator node,
                             const std::string &value) {
@@ -12,15 +35,27 @@ bool SimpleLRU::ReplaceData(const std::map<std::reference_wrapper<const std::str
         return false;
     }
 
-    this->MoveToHead(&(node->second.get()));
-    this->_cur_size += value.size() - node->second.get().value.size();
+    lru_node *cur = &(node->second.get());
+    this->MoveToHead(cur);
+    this->_cur_size -= Charge(*cur);
+    this->_payload += value.size() - cur->value.size();
+    if (value.size() < cur->value.capacity() / 2) {
+        // Assignment keeps the buffer, which is mostly wasted then
+        std::string(value).swap(cur->value);
+    } else {
+        cur->value = value;
+    }
+    this->_cur_size += Charge(*cur);
 
-    while (this->_cur_size > this->_max_size) {
+    while (this->_cur_size > this->_max_size && this->_lru_tail != cur) {
         this->RemoveTail();
     }
 
-    node->second.get().value = value;
-
+    // Item doesn't fit even alone, old value is stale anyway
+    if (this->_cur_size > this->_max_size) {
+        this->Unlink(cur);
+        return false;
+    }
     return true;
 }
 
@@ -29,49 +64,85 @@ bool SimpleLRU::InsertHead(const std::string &key, const std::string &value) {
         return false;
     }
 
-    while (this->_cur_size + key.size() + value.size() > this->_max_size) {
+    std::unique_ptr<lru_node> node(new lru_node{key, value, nullptr, std::unique_ptr<lru_node>()});
+    std::size_t charge = Charge(*node);
+    if (charge > this->_max_size) {
+        return false;
+    }
+
+    // Rejected key is stored and evicted right away as far as the client is concerned
+    if (this->_sketch && !this->Admit(key, charge)) {
+        this->_evictions++;
+        return true;
+    }
+
+    while (this->_cur_size + charge > this->_max_size) {
         this->RemoveTail();
     }
 
-    lru_node *cur;
+    lru_node *cur = node.get();
     // if the list is empty
     if (this->_lru_tail == nullptr) {
-        cur = new lru_node{key, value, nullptr, std::unique_ptr<lru_node>()};
-        this->_lru_head.reset(cur);
+        this->_lru_head = std::move(node);
         this->_lru_tail = cur;
     } else {
-        cur = new lru_node{key, value, nullptr, std::move(this->_lru_head)};
-        this->_lru_head.reset(cur);
+        cur->next = std::move(this->_lru_head);
+        this->_lru_head = std::move(node);
         this->_lru_head->next->prev = cur;
     }
 
-    this->_cur_size += key.size() + value.size();
+    this->_cur_size += charge;
+    this->_payload += key.size() + value.size();
     this->_lru_index.insert(
         {std::reference_wrapper<const std::string>(cur->key), std::reference_wrapper<lru_node>(*cur)});
 
     return true;
 }
 
+// See SimpleLRU.h
+bool SimpleLRU::Admit(const std::string &key, std::size_t charge) const {
+    unsigned frequency = this->_sketch->Estimate(key);
+
+    // Nodes are walked from the tail as RemoveTail would take them, ties go to the ones already stored
+    std::size_t room = this->_max_size - this->_cur_size;
+    for (lru_node *victim = this->_lru_tail; victim != nullptr && room < charge; victim = victim->prev) {
+        if (this->_sketch->Estimate(victim->key) >= frequency) {
+            return false;
+        }
+        room += Charge(*victim);
+    }
+    return true;
+}
+
 void SimpleLRU::RemoveTail() {
     // for unforseen occurences
     if (this->_lru_tail == nullptr) {
         return;
     }
 
-    this->_lru_index.erase(this->_lru_tail->key);
+    this->_evictions++;
+    this->Unlink(this->_lru_tail);
+}
 
-    // if there is only one element in the list
-    if (this->_lru_tail->prev == nullptr) {
-        this->_cur_size = 0;
-        this->_lru_tail = nullptr;
-        this->_lru_head.reset();
-        return;
+void SimpleLRU::Unlink(lru_node *node) {
+    this->_cur_size -= Charge(*node);
+    this->_payload -= node->key.size() + node->value.size();
+
+    // Index refers to the key kept in the node, so it goes first
+    this->_lru_index.erase(node->key);
+
+    if (node == this->_lru_tail) {
+        this->_lru_tail = node->prev;
+    } else {
+        node->next->prev = node->prev;
     }
 
-    this->_cur_size -= this->_lru_tail->key.size() + this->_lru_tail->value.size();
-    this->_lru_tail = this->_lru_tail->prev;
-    this->_lru_tail->next.reset();
-    return;
+    // Node is destroyed once the pointer owning it gets the next one
+    if (node->prev == nullptr) {
+        this->_lru_head = std::move(node->next);
+    } else {
+        node->prev->next = std::move(node->next);
+    }
 }
 
 void SimpleLRU::MoveToHead(lru_node *node) {
@@ -101,6 +172,10 @@ void SimpleLRU::MoveToHead(lru_node *node) {
 
 // See MapBasedGlobalLockImpl.h
 bool SimpleLRU::Put(const std::string &key, const std::string &value) {
+    if (this->_sketch) {
+        this->_sketch->Record(key);
+    }
+
     auto found = this->_lru_index.find(key);
 
     // if elem not in cache
@@ -113,6 +188,10 @@ bool SimpleLRU::Put(const std::string &key, const std::string &value) {
 
 // See MapBasedGlobalLockImpl.h
 bool SimpleLRU::PutIfAbsent(const std::string &key, const std::string &value) {
+    if (this->_sketch) {
+        this->_sketch->Record(key);
+    }
+
     auto found = this->_lru_index.find(key);
 
     // if elem not in cache
@@ -125,6 +204,10 @@ bool SimpleLRU::PutIfAbsent(const std::string &key, const std::string &value) {
 
 // See MapBasedGlobalLockImpl.h
 bool SimpleLRU::Set(const std::string &key, const std::string &value) {
+    if (this->_sketch) {
+        this->_sketch->Record(key);
+    }
+
     auto found = this->_lru_index.find(key);
 
     // if elem in cache
@@ -141,25 +224,7 @@ bool SimpleLRU::Delete(const std::string &key) {
 
     // if elem in cache
     if (found != this->_lru_index.end()) {
-        lru_node *node = &(found->second.get());
-
-        this->_cur_size -= node->key.size() + node->value.size();
-
-        if (node->prev == nullptr) {
-            // if it is head
-            this->_lru_head = std::move(node->next);
-            this->_lru_head->prev = nullptr;
-        } else if (node == this->_lru_tail) {
-            // if it is tail
-            this->_lru_tail = node->prev;
-            this->_lru_tail->next.reset();
-        } else {
-            node->next->prev = node->prev;
-            node->prev->next = std::move(node->next);
-        }
-
-        this->_lru_index.erase(found);
-
+        this->Unlink(&(found->second.get()));
         return true;
     } else {
         return false;
@@ -168,6 +233,10 @@ bool SimpleLRU::Delete(const std::string &key) {
 
 // See MapBasedGlobalLockImpl.h
 bool SimpleLRU::Get(const std::string &key, std::string &value) {
+    if (this->_sketch) {
+        this->_sketch->Record(key);
+    }
+
     auto found = this->_lru_index.find(key);
 
     // if elem in cache
@@ -180,5 +249,15 @@ bool SimpleLRU::Get(const std::string &key, std::string &value) {
     }
 }
 
+// See MapBasedGlobalLockImpl.h
+void SimpleLRU::GetUsage(Usage &usage) {
+    std::size_t sketch = this->_sketch ? this->_sketch->Bytes() : 0;
+    usage.items = this->_lru_index.size();
+    usage.bytes = this->_cur_size + sketch;
+    usage.overhead = usage.bytes - this->_payload;
+    usage.limit = this->_max_size + sketch;
+    usage.evictions = this->_evictions;
+}
+
 } // namespace Backend
 } // namespace Afina
@@ -8,17 +8,24 @@
 
 #include <afina/Storage.h>
 
+#include "FrequencySketch.h"
+
 namespace Afina {
 namespace Backend {
 
 /**
  * # Map based implementation
  * That is NOT thread safe implementaiton!!
+ *
+ * Each item is charged with all the heap it takes: list node, key and value buffers unless string keeps them
+ * inline, index node and allocator headers, so that max_size is close to the memory process really uses
+ *
+ * With admission on, new item gets in only if TinyLFU estimates its key as more frequent than each of the ones it
+ * would evict, otherwise Put fails. Frequency sketch takes its bytes out of max_size
  */
 class SimpleLRU : public Afina::Storage {
 public:
-    SimpleLRU(size_t max_size = 1024)
-        : _max_size(max_size), _cur_size(0), _lru_head(nullptr), _lru_tail(nullptr), _lru_index() {}
+    SimpleLRU(size_t max_size = 1024, bool admission = false);
 
     ~SimpleLRU() {
         _lru_index.clear();
@@ -46,6 +53,9 @@ public:
     // Implements Afina::Storage interface
     bool Get(const std::string &key, std::string &value) override;
 
+    // Implements Afina::Storage interface
+    void GetUsage(Usage &usage) override;
+
 private:
     // LRU cache node
     using lru_node = struct lru_node {
@@ -56,12 +66,21 @@ private:
     };
 
     // Maximum number of bytes could be stored in this cache.
-    // i.e all (keys+values) must be less the _max_size
+    // i.e all charged sizes of items must be less the _max_size
     std::size_t _max_size;
 
-    // Current total stored data size
+    // Current total charged size of items, see Charge
     std::size_t _cur_size;
 
+    // Current total size of keys and values
+    std::size_t _payload;
+
+    // Number of nodes removed from the tail to free space for new ones
+    uint64_t _evictions;
+
+    // Access frequencies of keys for admission, none if it is off
+    std::unique_ptr<FrequencySketch> _sketch;
+
     // Main storage of lru_nodes, elements in this list ordered descending by "freshness": in the head
     // element that wasn't used for longest time.
     //
@@ -74,6 +93,15 @@ private:
     std::map<std::reference_wrapper<const std::string>, std::reference_wrapper<lru_node>, std::less<std::string>>
         _lru_index;
 
+    // Bytes of heap taken by the node together with its index entry
+    static std::size_t Charge(const lru_node &node);
+
+    // Unlinks node from the list and index, node gets destroyed
+    void Unlink(lru_node *node);
+
+    // Checks that the key is more frequent than each of the nodes to be evicted for the new one to fit
+    bool Admit(const std::string &key, std::size_t charge) const;
+
     // Insert new node into the list
     bool InsertHead(const std::string &key, const std::string &value);
 
@@ -0,0 +1,66 @@
+#ifndef AFINA_STORAGE_THREAD_SAFE_H
+#define AFINA_STORAGE_THREAD_SAFE_H
+
+#include <mutex>
+#include <string>
+#include <utility>
+
+#include <afina/Storage.h>
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Any storage made thread safe with a global lock
+ * Every call takes the same mutex, so storage given as parameter needs no synchronization of its own
+ */
+template <typename T> class ThreadSafe : public T {
+public:
+    template <typename... Args> explicit ThreadSafe(Args &&... args) : T(std::forward<Args>(args)...) {}
+    ~ThreadSafe() {}
+
+    // Implements Afina::Storage interface
+    bool Put(const std::string &key, const std::string &value) override {
+        std::unique_lock<std::mutex> _lock(_g_mutex);
+        return T::Put(key, value);
+    }
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsent(const std::string &key, const std::string &value) override {
+        std::unique_lock<std::mutex> _lock(_g_mutex);
+        return T::PutIfAbsent(key, value);
+    }
+
+    // Implements Afina::Storage interface
+    bool Set(const std::string &key, const std::string &value) override {
+        std::unique_lock<std::mutex> _lock(_g_mutex);
+        return T::Set(key, value);
+    }
+
+    // Implements Afina::Storage interface
+    bool Delete(const std::string &key) override {
+        std::unique_lock<std::mutex> _lock(_g_mutex);
+        return T::Delete(key);
+    }
+
+    // Implements Afina::Storage interface
+    bool Get(const std::string &key, std::string &value) override {
+        std::unique_lock<std::mutex> _lock(_g_mutex);
+        return T::Get(key, value);
+    }
+
+    // Implements Afina::Storage interface
+    void GetUsage(Afina::Storage::Usage &usage) override {
+        std::unique_lock<std::mutex> _lock(_g_mutex);
+        T::GetUsage(usage);
+    }
+
+private:
+    // global mutex
+    std::mutex _g_mutex;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_THREAD_SAFE_H
@@ -1,59 +1,17 @@
 #ifndef AFINA_STORAGE_THREAD_SAFE_SIMPLE_LRU_H
 #define AFINA_STORAGE_THREAD_SAFE_SIMPLE_LRU_H
 
-#include <map>
-#include <mutex>
-#include <string>
-
 #include "SimpleLRU.h"
+#include "ThreadSafe.h"
 
 namespace Afina {
 namespace Backend {
 
 /**
  * # SimpleLRU thread safe version
- *
- *
+ * Global lock, see ThreadSafe
  */
-class ThreadSafeSimplLRU : public SimpleLRU {
-public:
-    ThreadSafeSimplLRU(size_t max_size = 1024) : SimpleLRU(max_size) {}
-    ~ThreadSafeSimplLRU() {}
-
-    // see SimpleLRU.h
-    bool Put(const std::string &key, const std::string &value) override {
-        std::unique_lock<std::mutex> _lock(_g_mutex);
-        return SimpleLRU::Put(key, value);
-    }
-
-    // see SimpleLRU.h
-    bool PutIfAbsent(const std::string &key, const std::string &value) override {
-        std::unique_lock<std::mutex> _lock(_g_mutex);
-        return SimpleLRU::PutIfAbsent(key, value);
-    }
-
-    // see SimpleLRU.h
-    bool Set(const std::string &key, const std::string &value) override {
-        std::unique_lock<std::mutex> _lock(_g_mutex);
-        return SimpleLRU::Set(key, value);
-    }
-
-    // see SimpleLRU.h
-    bool Delete(const std::string &key) override {
-        std::unique_lock<std::mutex> _lock(_g_mutex);
-        return SimpleLRU::Delete(key);
-    }
-
-    // see SimpleLRU.h
-    bool Get(const std::string &key, std::string &value) override {
-        std::unique_lock<std::mutex> _lock(_g_mutex);
-        return SimpleLRU::Get(key, value);
-    }
-
-private:
-    // global mutex
-    std::mutex _g_mutex;
-};
+using ThreadSafeSimplLRU = ThreadSafe<SimpleLRU>;
 
 } // namespace Backend
 } // namespace Afina
@@ -0,0 +1,60 @@
+#include "gtest/gtest.h"
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include <afina/concurrency/Epoch.h>
+
+using namespace Afina::Concurrency;
+
+TEST(EpochTest, NoReaders) {
+    Epoch epoch;
+
+    // Node unlinked now is freed right after the next epoch starts
+    uint64_t tag = epoch.Current();
+    EXPECT_EQ(epoch.Advance(), tag + 1);
+    EXPECT_EQ(epoch.Advance(), tag + 2);
+}
+
+TEST(EpochTest, GuardHoldsEpoch) {
+    Epoch epoch;
+    uint64_t tag = epoch.Current();
+    {
+        Epoch::Guard guard(epoch);
+        EXPECT_EQ(epoch.Advance(), tag);
+        EXPECT_EQ(epoch.Advance(), tag);
+    }
+    EXPECT_GT(epoch.Advance(), tag);
+}
+
+TEST(EpochTest, GuardInOtherThread) {
+    Epoch epoch;
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool entered = false;
+    bool done = false;
+
+    uint64_t tag = epoch.Current();
+    std::thread reader([&] {
+        Epoch::Guard guard(epoch);
+        std::unique_lock<std::mutex> lock(mutex);
+        entered = true;
+        cv.notify_all();
+        cv.wait(lock, [&] { return done; });
+    });
+
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [&] { return entered; });
+    }
+    EXPECT_EQ(epoch.Advance(), tag);
+
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        done = true;
+        cv.notify_all();
+    }
+    reader.join();
+    EXPECT_GT(epoch.Advance(), tag);
+}
@@ -0,0 +1,353 @@
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include <afina/concurrency/Executor.h>
+#include <afina/concurrency/WorkStealingDeque.h>
+
+using namespace Afina::Concurrency;
+
+// Blocks tasks until released
+class Gate {
+public:
+    Gate() : _open(false) {}
+
+    void Wait() {
+        std::unique_lock<std::mutex> lock(_mutex);
+        while (!_open) {
+            _cv.wait(lock);
+        }
+    }
+
+    void Open() {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _open = true;
+        _cv.notify_all();
+    }
+
+private:
+    std::mutex _mutex;
+    std::condition_variable _cv;
+    bool _open;
+};
+
+TEST(WorkStealingDequeTest, OwnerLifoThiefFifo) {
+    WorkStealingDeque<int> deque(4);
+    int items[5] = {0, 1, 2, 3, 4};
+
+    for (int i = 0; i < 4; i++) {
+        ASSERT_TRUE(deque.push(&items[i]));
+    }
+    ASSERT_FALSE(deque.push(&items[4]));
+    ASSERT_EQ(4, deque.size());
+
+    bool lost;
+    EXPECT_EQ(&items[0], deque.steal(lost));
+    EXPECT_EQ(&items[3], deque.pop());
+    EXPECT_EQ(&items[1], deque.steal(lost));
+    EXPECT_EQ(&items[2], deque.pop());
+    EXPECT_EQ(nullptr, deque.pop());
+    EXPECT_EQ(nullptr, deque.steal(lost));
+    EXPECT_FALSE(lost);
+}
+
+TEST(WorkStealingDequeTest, EachItemTakenOnce) {
+    const int total = 200000;
+    std::vector<int> items(total);
+    std::vector<std::atomic<int>> taken(total);
+    for (int i = 0; i < total; i++) {
+        items[i] = i;
+        taken[i] = 0;
+    }
+
+    WorkStealingDeque<int> deque(64);
+    std::atomic<bool> done(false);
+
+    std::vector<std::thread> thieves;
+    for (int t = 0; t < 3; t++) {
+        thieves.emplace_back([&] {
+            bool lost;
+            while (!done.load()) {
+                int *p = deque.steal(lost);
+                if (p != nullptr) {
+                    taken[*p]++;
+                }
+            }
+        });
+    }
+
+    // Owner interleaves pushes and pops
+    for (int i = 0; i < total; i++) {
+        while (!deque.push(&items[i])) {
+            int *p = deque.pop();
+            if (p != nullptr) {
+                taken[*p]++;
+            }
+        }
+        if (i % 3 == 0) {
+            int *p = deque.pop();
+            if (p != nullptr) {
+                taken[*p]++;
+            }
+        }
+    }
+    while (int *p = deque.pop()) {
+        taken[*p]++;
+    }
+
+    done = true;
+    for (auto &t : thieves) {
+        t.join();
+    }
+
+    for (int i = 0; i < total; i++) {
+        ASSERT_EQ(1, taken[i].load()) << "item " << i;
+    }
+}
+
+TEST(ExecutorTest, RunsAllTasks) {
+    std::atomic<int> counter(0);
+    {
+        Executor executor(2, 4, 10000, 100);
+        executor.Start();
+        for (int i = 0; i < 10000; i++) {
+            ASSERT_TRUE(executor.Execute([&counter](int n) { counter += n; }, 1));
+        }
+        executor.Stop(true);
+    }
+    EXPECT_EQ(10000, counter.load());
+}
+
+TEST(ExecutorTest, NestedTasksAreStolen) {
+    std::atomic<int> counter(0);
+    std::mutex mutex;
+    std::set<std::thread::id> threads;
+
+    Executor executor(4, 4, 100000, 100);
+    executor.Start();
+
+    // Each root task spawns children from inside the pool, so they land in the local deque,
+    // all threads must get some work anyway
+    std::atomic<int> roots(0);
+    for (int i = 0; i < 4; i++) {
+        executor.Execute([&] {
+            for (int j = 0; j < 1000; j++) {
+                executor.Execute([&] {
+                    {
+                        std::unique_lock<std::mutex> lock(mutex);
+                        threads.insert(std::this_thread::get_id());
+                    }
+                    std::this_thread::sleep_for(std::chrono::microseconds(10));
+                    counter++;
+                });
+            }
+            roots++;
+        });
+    }
+
+    while (roots.load() < 4) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    executor.Stop(true);
+
+    EXPECT_EQ(4000, counter.load());
+    EXPECT_EQ(4, threads.size());
+}
+
+TEST(ExecutorTest, QueueLimit) {
+    Executor executor(1, 1, 2, 100);
+    executor.Start();
+
+    Gate gate, started;
+    ASSERT_TRUE(executor.Execute([&] {
+        started.Open();
+        gate.Wait();
+    }));
+    started.Wait();
+
+    // Single thread is busy: two tasks could wait in queue, the third is rejected
+    std::atomic<int> counter(0);
+    EXPECT_TRUE(executor.Execute([&] { counter++; }));
+    EXPECT_TRUE(executor.Execute([&] { counter++; }));
+    EXPECT_FALSE(executor.Execute([&] { counter++; }));
+
+    gate.Open();
+    executor.Stop(true);
+    EXPECT_EQ(2, counter.load());
+    EXPECT_FALSE(executor.Execute([&] { counter++; }));
+}
+
+TEST(ExecutorTest, StopRacingSubmit) {
+    // Each accepted task must run even if Stop comes right in between of the state check and the push
+    for (int round = 0; round < 200; round++) {
+        std::atomic<int> accepted(0), ran(0);
+        Executor executor(1, 1, 100000, 100);
+        executor.Start();
+
+        std::thread submitter([&] {
+            for (int i = 0; i < 1000; i++) {
+                if (executor.Execute([&ran] { ran++; })) {
+                    accepted++;
+                }
+            }
+        });
+        executor.Stop(true);
+        submitter.join();
+
+        // Task accepted after the pool was stopped would never run
+        ASSERT_EQ(accepted.load(), ran.load()) << "round " << round;
+    }
+}
+
+TEST(ExecutorTest, Statistics) {
+    Executor executor(1, 2, 3, 50);
+    executor.Start();
+
+    Gate gate;
+    std::atomic<int> running(0);
+    for (int i = 0; i < 2; i++) {
+        ASSERT_TRUE(executor.Execute([&] {
+            running++;
+            gate.Wait();
+        }));
+    }
+    while (running.load() < 2) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    // Both threads are busy, queue takes three more tasks
+    for (int i = 0; i < 3; i++) {
+        ASSERT_TRUE(executor.Execute([] {}));
+    }
+    EXPECT_FALSE(executor.Execute([] {}));
+
+    Executor::Statistics stats;
+    executor.GetStatistics(stats);
+    EXPECT_EQ(2, stats.threads_live);
+    EXPECT_EQ(0, stats.threads_free);
+    EXPECT_EQ(3, stats.queue_depth);
+    EXPECT_EQ(3, stats.queue_depth_max);
+    EXPECT_EQ(1, stats.tasks_rejected);
+    EXPECT_EQ(2, stats.threads_spawned);
+    EXPECT_EQ(2, stats.wait_time.Count());
+    EXPECT_EQ(0, stats.run_time.Count());
+
+    // Extra thread retires after idle timeout
+    gate.Open();
+    for (int i = 0; i < 100; i++) {
+        executor.GetStatistics(stats);
+        if (stats.threads_retired > 0) {
+            break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    EXPECT_EQ(1, stats.threads_retired);
+    EXPECT_EQ(1, stats.threads_live);
+    EXPECT_EQ(5, stats.wait_time.Count());
+    EXPECT_EQ(5, stats.run_time.Count());
+    EXPECT_EQ(0, stats.queue_depth);
+
+    executor.Stop(true);
+}
+
+TEST(ExecutorTest, GrowsUpToHighWatermark) {
+    Executor executor(1, 3, 10, 50);
+    executor.Start();
+
+    Gate gate;
+    std::atomic<int> running(0);
+    for (int i = 0; i < 5; i++) {
+        ASSERT_TRUE(executor.Execute([&] {
+            running++;
+            gate.Wait();
+        }));
+    }
+
+    // Three threads get three tasks, two others wait in queue
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (running.load() < 3 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_EQ(3, running.load());
+
+    gate.Open();
+    executor.Stop(true);
+    EXPECT_EQ(5, running.load());
+}
+
+TEST(ExecutorTest, PriorityLanesWeighted) {
+    Executor executor(1, 1, 1000, 100);
+    executor.Start();
+
+    Gate gate, started;
+    ASSERT_TRUE(executor.Execute([&] {
+        started.Open();
+        gate.Wait();
+    }));
+    started.Wait();
+
+    // Single thread is busy, so everything below is queued before the first dequeue
+    std::mutex mutex;
+    std::vector<Executor::Priority> order;
+    auto submit = [&](Executor::Priority p, int n) {
+        for (int i = 0; i < n; i++) {
+            ASSERT_TRUE(executor.Schedule(p, Executor::NoDeadline(), Task([&mutex, &order, p] {
+                                              std::unique_lock<std::mutex> lock(mutex);
+                                              order.push_back(p);
+                                          })));
+        }
+    };
+    submit(Executor::Priority::kLow, 20);
+    submit(Executor::Priority::kNormal, 40);
+    submit(Executor::Priority::kHigh, 80);
+
+    gate.Open();
+    executor.Stop(true);
+    ASSERT_EQ(140, order.size());
+
+    // Each round of 13 tasks is split 8:4:1, bulk tasks make progress even though they are the last
+    int counts[Executor::kPriorities] = {0, 0, 0};
+    for (int i = 0; i < 26; i++) {
+        counts[int(order[i])]++;
+    }
+    EXPECT_EQ(16, counts[int(Executor::Priority::kHigh)]);
+    EXPECT_EQ(8, counts[int(Executor::Priority::kNormal)]);
+    EXPECT_EQ(2, counts[int(Executor::Priority::kLow)]);
+}
+
+TEST(ExecutorTest, ExpiredTasksDropped) {
+    Executor executor(1, 1, 10, 100);
+    executor.Start();
+
+    Gate gate, started;
+    ASSERT_TRUE(executor.Execute([&] {
+        started.Open();
+        gate.Wait();
+    }));
+    started.Wait();
+
+    std::atomic<int> ran(0), dropped(0);
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(10);
+    ASSERT_TRUE(executor.Schedule(Executor::Priority::kNormal, deadline, Task([&] { ran++; }), Task([&] { dropped++; })));
+    ASSERT_TRUE(executor.Schedule(Executor::Priority::kNormal, deadline, Task([&] { ran++; })));
+    ASSERT_TRUE(executor.Schedule(Executor::Priority::kNormal, Executor::NoDeadline(), Task([&] { ran++; })));
+
+    // Let deadline pass while tasks are waiting
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    gate.Open();
+    executor.Stop(true);
+
+    EXPECT_EQ(1, ran.load());
+    EXPECT_EQ(1, dropped.load());
+
+    Executor::Statistics stats;
+    executor.GetStatistics(stats);
+    EXPECT_EQ(2, stats.tasks_expired);
+}
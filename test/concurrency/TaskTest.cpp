@@ -0,0 +1,137 @@
+#include "gtest/gtest.h"
+
+#include <array>
+#include <memory>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include <afina/concurrency/SlotPool.h>
+#include <afina/concurrency/Task.h>
+
+using namespace Afina::Concurrency;
+
+// Counts live copies, to make sure task destroys what it has created
+struct Tracked {
+    static int alive;
+
+    Tracked(int *calls) : calls(calls) { alive++; }
+    Tracked(const Tracked &other) : calls(other.calls) { alive++; }
+    Tracked(Tracked &&other) noexcept : calls(other.calls) { alive++; }
+    ~Tracked() { alive--; }
+
+    void operator()() { (*calls)++; }
+
+    int *calls;
+};
+
+int Tracked::alive = 0;
+
+// Closure of the given size
+template <std::size_t N> struct Sized : public Tracked {
+    Sized(int *calls) : Tracked(calls) { payload.fill(1); }
+    std::array<char, N> payload;
+};
+
+template <typename F> void CheckTask() {
+    int calls = 0;
+    {
+        Task task{F(&calls)};
+        ASSERT_TRUE(bool(task));
+        task();
+
+        // Moved from task becomes empty
+        Task moved(std::move(task));
+        ASSERT_FALSE(bool(task));
+        moved();
+
+        Task assigned;
+        assigned = std::move(moved);
+        assigned();
+        EXPECT_EQ(1, Tracked::alive);
+    }
+    EXPECT_EQ(3, calls);
+    EXPECT_EQ(0, Tracked::alive);
+}
+
+TEST(TaskTest, Inline) { CheckTask<Tracked>(); }
+
+TEST(TaskTest, Pooled) { CheckTask<Sized<Task::kInlineSize + 1>>(); }
+
+TEST(TaskTest, Heap) { CheckTask<Sized<Task::kPooledSize + 1>>(); }
+
+TEST(TaskTest, MoveOnlyCallable) {
+    std::unique_ptr<int> value(new int(0));
+    int *raw = value.get();
+
+    struct Increment {
+        std::unique_ptr<int> value;
+        void operator()() { (*value)++; }
+    };
+
+    Increment inc;
+    inc.value = std::move(value);
+    Task task(std::move(inc));
+    task();
+    EXPECT_EQ(1, *raw);
+}
+
+TEST(TaskTest, AssignReleasesPrevious) {
+    int calls = 0;
+    Task task{Sized<100>(&calls)};
+    task = Task(Tracked(&calls));
+    EXPECT_EQ(1, Tracked::alive);
+    task.reset();
+    EXPECT_EQ(0, Tracked::alive);
+}
+
+TEST(SlotPoolTest, ReusesSlots) {
+    using Pool = SlotPool<40>;
+    EXPECT_EQ(0, Pool::kSlotSize % alignof(std::max_align_t));
+
+    std::set<void *> seen;
+    std::vector<void *> slots;
+    for (int i = 0; i < 1000; i++) {
+        slots.push_back(Pool::Allocate());
+        ASSERT_TRUE(seen.insert(slots.back()).second);
+    }
+    for (void *p : slots) {
+        Pool::Free(p);
+    }
+
+    // Free slots are handed out before pool grows, so all of them are reused
+    slots.clear();
+    std::size_t reused = 0;
+    for (int i = 0; i < 2000; i++) {
+        slots.push_back(Pool::Allocate());
+        reused += seen.count(slots.back());
+    }
+    EXPECT_EQ(1000, reused);
+    for (void *p : slots) {
+        Pool::Free(p);
+    }
+}
+
+TEST(SlotPoolTest, FreedByOtherThread) {
+    using Pool = SlotPool<64>;
+
+    std::vector<void *> slots;
+    for (int i = 0; i < 10000; i++) {
+        slots.push_back(Pool::Allocate());
+    }
+
+    // Thread exit returns its cache to the shared list
+    std::thread t([&] {
+        for (void *p : slots) {
+            Pool::Free(p);
+        }
+    });
+    t.join();
+
+    std::set<void *> seen(slots.begin(), slots.end());
+    std::size_t reused = 0;
+    for (int i = 0; i < 20000; i++) {
+        reused += seen.count(Pool::Allocate());
+    }
+    EXPECT_EQ(10000, reused);
+}
@@ -1,7 +1,12 @@
 #include "gtest/gtest.h"
 
+#include <algorithm>
 #include <iostream>
+#include <limits>
 #include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
 
 #include <afina/coroutine/Engine.h>
 
@@ -62,3 +67,207 @@ TEST(CoroutineTest, Printer) {
     engine.start(_printer, engine, result);
     ASSERT_STREQ("A1 B1 A2 B2 A3 B3 END", result.c_str());
 }
+
+TEST(CoroutineTest, SeparateStacksSimpleStart) {
+    Afina::Coroutine::Engine engine(Afina::Coroutine::Engine::StackMode::kSeparate);
+
+    int result;
+    engine.start(_calculator_add, result, 1, 2);
+
+    ASSERT_EQ(3, result);
+}
+
+TEST(CoroutineTest, SeparateStacksPrinter) {
+    Afina::Coroutine::Engine engine(Afina::Coroutine::Engine::StackMode::kSeparate);
+
+    out.str("");
+    std::string result;
+    engine.start(_printer, engine, result);
+    ASSERT_STREQ("A1 B1 A2 B2 A3 B3 END", result.c_str());
+}
+
+// Each worker appends its id on every step, yield has to give every alive routine a turn
+void _worker(Afina::Coroutine::Engine &pe, std::string &trace, char id) {
+    for (int i = 0; i < 3; i++) {
+        trace.push_back(id);
+        pe.yield();
+    }
+}
+
+void _spawner(Afina::Coroutine::Engine &pe, std::string &trace, int &count) {
+    for (char id = 'a'; id < 'a' + count; id++) {
+        pe.run(_worker, pe, trace, char(id));
+    }
+}
+
+void CheckRoundRobin(Afina::Coroutine::Engine::StackMode mode) {
+    Afina::Coroutine::Engine engine(mode);
+
+    std::string trace;
+    int count = 3;
+    engine.start(_spawner, engine, trace, count);
+
+    // Every routine did all of its steps and no one ran twice in a row while others were waiting
+    ASSERT_EQ(9, trace.size());
+    for (char id = 'a'; id < 'a' + count; id++) {
+        EXPECT_EQ(3, std::count(trace.begin(), trace.end(), id));
+    }
+    for (std::size_t i = 0; i + 1 < 6; i++) {
+        EXPECT_NE(trace[i], trace[i + 1]) << trace;
+    }
+}
+
+TEST(CoroutineTest, YieldRoundRobin) { CheckRoundRobin(Afina::Coroutine::Engine::StackMode::kCopy); }
+
+TEST(CoroutineTest, SeparateStacksYieldRoundRobin) {
+    CheckRoundRobin(Afina::Coroutine::Engine::StackMode::kSeparate);
+}
+
+// Uses some stack on each level, so that routine stack has to be deep, result depends on all frames
+int _deep(int level) {
+    volatile char frame[512];
+    frame[0] = char(level);
+    if (level == 0) {
+        return frame[0];
+    }
+    return _deep(level - 1) + frame[0];
+}
+
+void _deep_worker(Afina::Coroutine::Engine &pe, int &result) {
+    pe.yield();
+    result = _deep(100);
+    pe.yield();
+}
+
+void _many(Afina::Coroutine::Engine &pe, std::vector<int> &results) {
+    for (std::size_t i = 0; i < results.size(); i++) {
+        pe.run(_deep_worker, pe, results[i]);
+    }
+}
+
+TEST(CoroutineTest, SeparateStacksManyRoutines) {
+    Afina::Coroutine::Engine engine(Afina::Coroutine::Engine::StackMode::kSeparate, 128 * 1024);
+
+    // More routines than stacks kept for reuse, all of them alive at once
+    std::vector<int> results(500, 0);
+    engine.start(_many, engine, results);
+    for (int r : results) {
+        ASSERT_EQ(5050, r);
+    }
+
+    // Engine could be started again, reusing stacks of finished routines
+    std::vector<int> again(10, 0);
+    engine.start(_many, engine, again);
+    for (int r : again) {
+        ASSERT_EQ(5050, r);
+    }
+}
+
+int _unbounded(int level) {
+    volatile char frame[1024];
+    frame[0] = char(level);
+
+    // Stack is over long before, but otherwise compiler calls the recursion infinite
+    if (level == std::numeric_limits<int>::max()) {
+        return 0;
+    }
+    return _unbounded(level + 1) + frame[0];
+}
+
+void _overflow(int &result) { result = _unbounded(0); }
+
+TEST(CoroutineTest, SeparateStacksGuardPage) {
+    // Overflow must crash on the guard page instead of silently overwriting neighbour memory
+    ::testing::FLAGS_gtest_death_test_style = "threadsafe";
+    ASSERT_DEATH(
+        {
+            Afina::Coroutine::Engine engine(Afina::Coroutine::Engine::StackMode::kSeparate, 64 * 1024);
+            int result;
+            engine.start(_overflow, result);
+        },
+        "");
+}
+
+// Routines wait for "events" delivered by the unblocker, one event per unblocker call
+struct Waiters {
+    Afina::Coroutine::Engine *engine;
+    std::vector<void *> routines;
+    std::string trace;
+    int unblocks;
+};
+
+void _waiter(Waiters &w, char id) {
+    w.routines.push_back(w.engine->current());
+    w.engine->block();
+    w.trace.push_back(id);
+}
+
+void _waiters(Waiters &w) {
+    for (char id = 'a'; id < 'd'; id++) {
+        w.engine->run(_waiter, w, char(id));
+    }
+
+    // Blocked routines are never picked by yield
+    w.engine->yield();
+    w.engine->yield();
+    w.trace.push_back('-');
+}
+
+void CheckBlocking(Afina::Coroutine::Engine::StackMode mode) {
+    Waiters w;
+    w.unblocks = 0;
+    Afina::Coroutine::Engine engine(mode, 256 * 1024, [&w] {
+        // Wake up routines in the order reverse to the one they have blocked in
+        w.unblocks++;
+        w.engine->unblock(w.routines.back());
+        w.routines.pop_back();
+    });
+    w.engine = &engine;
+
+    engine.start(_waiters, w);
+    EXPECT_EQ(3, w.unblocks);
+    EXPECT_TRUE(w.routines.empty());
+    EXPECT_EQ("-abc", w.trace);
+}
+
+TEST(CoroutineTest, BlockUnblock) { CheckBlocking(Afina::Coroutine::Engine::StackMode::kCopy); }
+
+TEST(CoroutineTest, SeparateStacksBlockUnblock) { CheckBlocking(Afina::Coroutine::Engine::StackMode::kSeparate); }
+
+void _traveler(std::thread::id &before, std::thread::id &after) {
+    before = std::this_thread::get_id();
+    Afina::Coroutine::Engine::running()->yield();
+    after = std::this_thread::get_id();
+}
+
+void _noop() {}
+
+void _departure(Afina::Coroutine::Engine &pe, std::thread::id &before, std::thread::id &after, void *&moved) {
+    pe.run(_traveler, before, after);
+    pe.yield();
+
+    // Traveler is suspended in the middle now, engine keeps the new routine and gives traveler away
+    pe.run(_noop);
+    moved = pe.detach();
+}
+
+void _arrival(void *&moved) { Afina::Coroutine::Engine::running()->adopt(moved); }
+
+TEST(CoroutineTest, SeparateStacksMigration) {
+    Afina::Coroutine::Engine departure(Afina::Coroutine::Engine::StackMode::kSeparate);
+    Afina::Coroutine::Engine arrival(Afina::Coroutine::Engine::StackMode::kSeparate);
+
+    std::thread::id before, after;
+    void *moved = nullptr;
+    departure.start(_departure, departure, before, after, moved);
+    ASSERT_NE(nullptr, moved);
+    EXPECT_EQ(std::this_thread::get_id(), before);
+
+    std::thread::id arrival_thread;
+    std::thread other([&] {
+        arrival_thread = std::this_thread::get_id();
+        arrival.start(_arrival, moved);
+    });
+    other.join();
+    EXPECT_EQ(arrival_thread, after);
+}
@@ -0,0 +1,197 @@
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <string>
+
+#include <afina/coroutine/Channel.h>
+#include <afina/coroutine/Engine.h>
+#include <afina/coroutine/Sync.h>
+
+using Afina::Coroutine::Channel;
+using Afina::Coroutine::CondVar;
+using Afina::Coroutine::Engine;
+using Afina::Coroutine::Mutex;
+using Afina::Coroutine::Semaphore;
+
+struct Locking {
+    Engine *engine;
+    Mutex *mutex;
+    std::string trace;
+};
+
+void _holder(Locking &l) {
+    l.mutex->lock();
+    l.trace += "H";
+    l.engine->yield();
+    l.engine->yield();
+    l.trace += "h";
+    l.mutex->unlock();
+}
+
+void _contender(Locking &l) {
+    l.mutex->lock();
+    l.trace += "C";
+    l.mutex->unlock();
+}
+
+void _bystander(Locking &l) { l.trace += "b"; }
+
+void _locking(Locking &l) {
+    l.engine->run(_bystander, l);
+    l.engine->run(_contender, l);
+    l.engine->run(_holder, l);
+}
+
+void CheckMutex(Engine::StackMode mode) {
+    Engine engine(mode);
+    Mutex mutex(engine);
+    Locking l{&engine, &mutex, ""};
+
+    // Contender is parked while holder yields, bystander is not affected
+    engine.start(_locking, l);
+    EXPECT_EQ("HbhC", l.trace);
+}
+
+TEST(CoroutineSyncTest, Mutex) { CheckMutex(Engine::StackMode::kCopy); }
+
+TEST(CoroutineSyncTest, SeparateStacksMutex) { CheckMutex(Engine::StackMode::kSeparate); }
+
+struct Flag {
+    Engine *engine;
+    Mutex *mutex;
+    CondVar *cv;
+    bool ready;
+    int seen;
+};
+
+void _flag_waiter(Flag &f) {
+    f.mutex->lock();
+    f.cv->wait(*f.mutex, [&f] { return f.ready; });
+    f.seen++;
+    f.mutex->unlock();
+}
+
+void _flag_setter(Flag &f) {
+    for (int i = 0; i < 3; i++) {
+        f.engine->yield();
+    }
+
+    f.mutex->lock();
+    f.ready = true;
+    f.cv->notify_all();
+    f.mutex->unlock();
+}
+
+void _flags(Flag &f) {
+    f.engine->run(_flag_setter, f);
+    for (int i = 0; i < 4; i++) {
+        f.engine->run(_flag_waiter, f);
+    }
+}
+
+void CheckCondVar(Engine::StackMode mode) {
+    Engine engine(mode);
+    Mutex mutex(engine);
+    CondVar cv(engine);
+    Flag f{&engine, &mutex, &cv, false, 0};
+
+    engine.start(_flags, f);
+    EXPECT_TRUE(f.ready);
+    EXPECT_EQ(4, f.seen);
+}
+
+TEST(CoroutineSyncTest, CondVar) { CheckCondVar(Engine::StackMode::kCopy); }
+
+TEST(CoroutineSyncTest, SeparateStacksCondVar) { CheckCondVar(Engine::StackMode::kSeparate); }
+
+struct Limited {
+    Engine *engine;
+    Semaphore *semaphore;
+    int inside;
+    int max_inside;
+    int done;
+};
+
+void _limited(Limited &l) {
+    l.semaphore->acquire();
+    l.inside++;
+    l.max_inside = std::max(l.max_inside, l.inside);
+    l.engine->yield();
+    l.engine->yield();
+    l.inside--;
+    l.done++;
+    l.semaphore->release();
+}
+
+void _limiteds(Limited &l) {
+    for (int i = 0; i < 10; i++) {
+        l.engine->run(_limited, l);
+    }
+}
+
+void CheckSemaphore(Engine::StackMode mode) {
+    Engine engine(mode);
+    Semaphore semaphore(engine, 3);
+    Limited l{&engine, &semaphore, 0, 0, 0};
+
+    engine.start(_limiteds, l);
+    EXPECT_EQ(10, l.done);
+    EXPECT_EQ(3, l.max_inside);
+    EXPECT_EQ(3, semaphore.available());
+}
+
+TEST(CoroutineSyncTest, Semaphore) { CheckSemaphore(Engine::StackMode::kCopy); }
+
+TEST(CoroutineSyncTest, SeparateStacksSemaphore) { CheckSemaphore(Engine::StackMode::kSeparate); }
+
+struct Pipe {
+    Channel<int> *channel;
+    int sum;
+    int received;
+    std::size_t max_size;
+};
+
+void _producer(Pipe &p) {
+    for (int i = 1; i <= 100; i++) {
+        ASSERT_TRUE(p.channel->send(i));
+        p.max_size = std::max(p.max_size, p.channel->size());
+    }
+    p.channel->close();
+    EXPECT_FALSE(p.channel->send(0));
+}
+
+void _consumer(Pipe &p) {
+    int value;
+    while (p.channel->recv(value)) {
+        p.sum += value;
+        p.received++;
+    }
+}
+
+void _pipe(Engine &engine, Pipe &p) {
+    engine.run(_consumer, p);
+    engine.run(_consumer, p);
+    engine.run(_producer, p);
+}
+
+void CheckChannel(Engine::StackMode mode) {
+    Engine engine(mode);
+    Channel<int> channel(engine, 4);
+    Pipe p{&channel, 0, 0, 0};
+
+    engine.start(_pipe, engine, p);
+    EXPECT_EQ(5050, p.sum);
+    EXPECT_EQ(100, p.received);
+    EXPECT_EQ(4, p.max_size);
+}
+
+TEST(CoroutineSyncTest, Channel) { CheckChannel(Engine::StackMode::kCopy); }
+
+TEST(CoroutineSyncTest, SeparateStacksChannel) { CheckChannel(Engine::StackMode::kSeparate); }
+
+TEST(CoroutineSyncTest, WaitOutsideOfRoutine) {
+    Engine engine;
+    Channel<int> channel(engine, 1);
+    int value;
+    EXPECT_THROW(channel.recv(value), std::runtime_error);
+}
@@ -0,0 +1,126 @@
+#include "gtest/gtest.h"
+
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <afina/execute/Get.h>
+#include <afina/execute/Set.h>
+#include <afina/execute/Stats.h>
+#include <afina/metrics/Metrics.h>
+
+#include "storage/SimpleLRU.h"
+
+using namespace Afina;
+
+// Returns value of the given STAT line, or empty string if there is no such
+std::string stat_value(const std::string &out, const std::string &name) {
+    std::stringstream in(out);
+    std::string line;
+    while (std::getline(in, line)) {
+        std::string prefix = "STAT " + name + " ";
+        if (line.compare(0, prefix.size(), prefix) == 0) {
+            return line.substr(prefix.size(), line.size() - prefix.size() - 1);
+        }
+    }
+    return std::string();
+}
+
+uint64_t stat_number(const std::string &out, const std::string &name) {
+    return std::stoull(stat_value(out, name));
+}
+
+TEST(StatsTest, HitsAndMisses) {
+    Backend::SimpleLRU storage;
+
+    std::string out;
+    Execute::Stats().Execute(storage, "", out);
+    uint64_t hits = stat_number(out, "get_hits");
+    uint64_t misses = stat_number(out, "get_misses");
+    uint64_t sets = stat_number(out, "cmd_set");
+
+    Execute::Set("foo", 0, 0).Execute(storage, "bar", out);
+    ASSERT_EQ("STORED", out);
+    Execute::Get({"foo", "baz"}).Execute(storage, "", out);
+
+    Execute::Stats().Execute(storage, "", out);
+    EXPECT_EQ(hits + 1, stat_number(out, "get_hits"));
+    EXPECT_EQ(misses + 1, stat_number(out, "get_misses"));
+    EXPECT_EQ(sets + 1, stat_number(out, "cmd_set"));
+    EXPECT_EQ(1, stat_number(out, "curr_items"));
+    EXPECT_EQ(6 + stat_number(out, "item_overhead"), stat_number(out, "bytes"));
+    EXPECT_LT(6, stat_number(out, "bytes"));
+    EXPECT_EQ(1024, stat_number(out, "limit_maxbytes"));
+    EXPECT_EQ("END", out.substr(out.size() - 3));
+}
+
+TEST(StatsTest, Groups) {
+    // Room for a single item
+    Storage::Usage item;
+    {
+        Backend::SimpleLRU probe;
+        probe.Put("a", "12345");
+        probe.GetUsage(item);
+    }
+    Backend::SimpleLRU storage(item.bytes + item.bytes / 2);
+
+    std::string out;
+    Execute::Set("a", 0, 0).Execute(storage, "12345", out);
+    Execute::Set("b", 0, 0).Execute(storage, "12345", out);
+
+    Execute::Stats("items").Execute(storage, "", out);
+    EXPECT_EQ(1, stat_number(out, "items:1:number"));
+    EXPECT_EQ(1, stat_number(out, "items:1:evicted"));
+
+    Execute::Stats("slabs").Execute(storage, "", out);
+    EXPECT_EQ(1, stat_number(out, "active_slabs"));
+    EXPECT_EQ(item.bytes, stat_number(out, "total_malloced"));
+    EXPECT_EQ(6, stat_number(out, "1:mem_requested"));
+
+    Metrics::SetSetting("tcpport", "11211");
+    Execute::Stats("settings").Execute(storage, "", out);
+    EXPECT_EQ(item.bytes + item.bytes / 2, stat_number(out, "maxbytes"));
+    EXPECT_EQ("11211", stat_value(out, "tcpport"));
+
+    Execute::Stats("unknown").Execute(storage, "", out);
+    EXPECT_EQ("ERROR", out);
+}
+
+TEST(StatsTest, ComponentReports) {
+    Backend::SimpleLRU storage(10);
+    std::string out;
+
+    int id = Metrics::AddReport("pool", [](std::vector<std::pair<std::string, std::string>> &values) {
+        values.emplace_back("threads", "4");
+    });
+    Execute::Stats("pool").Execute(storage, "", out);
+    EXPECT_EQ("STAT threads 4\r\nEND", out);
+
+    Metrics::RemoveReport(id);
+    Execute::Stats("pool").Execute(storage, "", out);
+    EXPECT_EQ("ERROR", out);
+}
+
+TEST(StatsTest, CountersMergedAcrossThreads) {
+    Metrics::Snapshot before, after;
+    Metrics::Collect(before);
+
+    const int threads = 4, increments = 10000;
+    std::vector<std::thread> workers;
+    for (int i = 0; i < threads; i++) {
+        workers.emplace_back([] {
+            for (int j = 0; j < increments; j++) {
+                Metrics::Add(Metrics::kBytesRead, 2);
+                Metrics::Sub(Metrics::kBytesRead);
+            }
+        });
+    }
+    for (auto &t : workers) {
+        t.join();
+    }
+
+    // Shards of exited threads are kept, so nothing is lost
+    Metrics::Collect(after);
+    EXPECT_EQ(before[Metrics::kBytesRead] + threads * increments, after[Metrics::kBytesRead]);
+}
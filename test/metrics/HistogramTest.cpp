@@ -0,0 +1,76 @@
+#include "gtest/gtest.h"
+
+#include <thread>
+
+#include <afina/metrics/Histogram.h>
+#include <afina/metrics/Latency.h>
+
+using namespace Afina::Metrics;
+
+TEST(HistogramTest, BucketsAreContinuous) {
+    uint64_t prev = 0;
+    for (std::size_t b = 0; b < Histogram::kBuckets; b++) {
+        uint64_t highest = Histogram::BucketHighest(b);
+        ASSERT_EQ(b, Histogram::BucketOf(highest));
+        if (b > 0) {
+            ASSERT_EQ(b, Histogram::BucketOf(prev + 1));
+        }
+        prev = highest;
+    }
+    ASSERT_EQ(Histogram::kMaxValue, prev);
+}
+
+TEST(HistogramTest, SmallValuesAreExact) {
+    Histogram h;
+    for (uint64_t v = 1; v <= 50; v++) {
+        h.Record(v);
+    }
+
+    EXPECT_EQ(50, h.Count());
+    EXPECT_EQ(25, h.Percentile(50));
+    EXPECT_EQ(50, h.Percentile(100));
+    EXPECT_EQ(50, h.Max());
+    EXPECT_DOUBLE_EQ(25.5, h.Mean());
+}
+
+TEST(HistogramTest, RelativeError) {
+    Histogram h;
+    for (uint64_t v = 1000; v <= 1000000; v += 1000) {
+        h.Record(v);
+    }
+
+    // Reported value is the top of the bucket: never below, at most 1/32 above
+    uint64_t p99 = h.Percentile(99);
+    EXPECT_GE(p99, 990000);
+    EXPECT_LE(p99, 990000 + 990000 / Histogram::kSubBuckets);
+
+    h.Record(uint64_t(1) << 50);
+    EXPECT_EQ(Histogram::kMaxValue, h.Max());
+}
+
+TEST(HistogramTest, CorrectedForStall) {
+    Histogram h;
+    h.RecordCorrected(50, 100);
+    h.RecordCorrected(1000, 100);
+    h.RecordCorrected(1000, 0);
+
+    // Stall of 1000 hides requests which would have waited 900, 800, ..., 100
+    EXPECT_EQ(12, h.Count());
+    EXPECT_EQ(50, h.Percentile(1));
+    EXPECT_EQ(Histogram::BucketHighest(Histogram::BucketOf(1000)), h.Max());
+    EXPECT_DOUBLE_EQ((50 + 1000 * 2 + 4500) / 12.0, h.Mean());
+}
+
+TEST(HistogramTest, LatencyMergedAcrossThreads) {
+    Histogram before;
+    CollectLatency(kOpReplace, before);
+
+    std::thread t1([] { RecordLatency(kOpReplace, 0, 100); });
+    std::thread t2([] { RecordLatency(kOpReplace, 0, 200); });
+    t1.join();
+    t2.join();
+
+    Histogram after;
+    CollectLatency(kOpReplace, after);
+    EXPECT_EQ(before.Count() + 2, after.Count());
+}
@@ -0,0 +1,43 @@
+#include "gtest/gtest.h"
+
+#include <string>
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <afina/metrics/Latency.h>
+
+#include "network/ResponseQueue.h"
+
+using namespace Afina;
+
+TEST(ResponseQueueTest, LatencyCountsTimeInQueue) {
+    int sockets[2];
+    ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, sockets));
+
+    Metrics::Histogram before;
+    Metrics::CollectLatency(Metrics::kOpReplace, before);
+
+    // Response waits in the queue, which is a part of the command latency
+    Network::ResponseQueue output;
+    output.Push("STORED", Metrics::kOpReplace, Metrics::Clock::Now());
+    output.Push("NOT_STORED", Metrics::kOpReplace, Metrics::Clock::Now());
+    usleep(20000);
+
+    Metrics::Histogram queued;
+    Metrics::CollectLatency(Metrics::kOpReplace, queued);
+    EXPECT_EQ(before.Count(), queued.Count());
+
+    output.Flush(sockets[0]);
+    Metrics::Histogram sent;
+    Metrics::CollectLatency(Metrics::kOpReplace, sent);
+    EXPECT_EQ(before.Count() + 2, sent.Count());
+    EXPECT_GE(sent.Max(), 20000000u);
+
+    char buffer[64];
+    ssize_t n = recv(sockets[1], buffer, sizeof(buffer), 0);
+    EXPECT_EQ("STORED\r\nNOT_STORED\r\n", std::string(buffer, n > 0 ? n : 0));
+
+    close(sockets[0]);
+    close(sockets[1]);
+}
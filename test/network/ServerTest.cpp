@@ -0,0 +1,210 @@
+#include "gtest/gtest.h"
+
+#include <cerrno>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <afina/logging/Config.h>
+#include <afina/metrics/Latency.h>
+#include <afina/network/Server.h>
+
+#include "logging/ServiceImpl.h"
+#include "network/mt_blocking/ServerImpl.h"
+#include "network/mt_nonblocking/ServerImpl.h"
+#include "network/st_blocking/ServerImpl.h"
+#include "network/st_nonblocking/ServerImpl.h"
+#include "network/uring/ServerImpl.h"
+#include "storage/ThreadSafeSimpleLRU.h"
+
+using namespace Afina;
+
+namespace {
+
+// Loggers are registered globally, so all servers share single logging service
+std::shared_ptr<Logging::ServiceImpl> logging() {
+    static std::shared_ptr<Logging::ServiceImpl> service;
+    if (!service) {
+        auto config = std::make_shared<Logging::Config>();
+        Logging::Appender &console = config->appenders["console"];
+        console.type = Logging::Appender::Type::STDERR;
+        Logging::Logger &logger = config->loggers["root"];
+        logger.level = Logging::Logger::Level::CRITICAL;
+        logger.appenders.push_back("console");
+        service = std::make_shared<Logging::ServiceImpl>(config);
+        service->Start();
+    }
+    return service;
+}
+
+// Server of the given type running on its own port for the duration of the test
+class Running {
+public:
+    template <typename Impl> static std::unique_ptr<Running> Start(uint16_t port) {
+        std::unique_ptr<Running> result(new Running(port));
+        result->_server = std::make_shared<Impl>(result->_storage, logging());
+        result->_server->Start(port, 1, 2);
+        return result;
+    }
+
+    ~Running() {
+        _server->Stop();
+        _server->Join();
+        _storage->Stop();
+    }
+
+    // Sends request, closes the writing side if asked to and returns everything server replies until it
+    // closes connection or keeps silence for a second
+    std::string Exchange(const std::string &request, bool half_close) {
+        int s = socket(AF_INET, SOCK_STREAM, 0);
+        if (s == -1) {
+            throw std::runtime_error("socket() failed: " + std::string(strerror(errno)));
+        }
+
+        struct sockaddr_in addr;
+        std::memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(_port);
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        for (int attempt = 0; connect(s, (struct sockaddr *)&addr, sizeof(addr)) == -1; attempt++) {
+            if (attempt == 100) {
+                close(s);
+                throw std::runtime_error("connect() failed: " + std::string(strerror(errno)));
+            }
+            usleep(10000);
+        }
+
+        // Server is waiting for the data by now, so that it gets the data together with FIN in one event
+        usleep(50000);
+
+        struct timeval timeout = {1, 0};
+        setsockopt(s, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+        for (std::size_t sent = 0; sent < request.size();) {
+            ssize_t n = send(s, request.data() + sent, request.size() - sent, MSG_NOSIGNAL);
+            if (n <= 0) {
+                break;
+            }
+            sent += n;
+        }
+        if (half_close) {
+            shutdown(s, SHUT_WR);
+        }
+
+        std::string reply;
+        char buffer[4096];
+        for (ssize_t n; (n = recv(s, buffer, sizeof(buffer), 0)) > 0;) {
+            reply.append(buffer, n);
+        }
+        close(s);
+        return reply;
+    }
+
+private:
+    explicit Running(uint16_t port) : _port(port) {
+        _storage = std::make_shared<Backend::ThreadSafeSimplLRU>(1024 * 1024);
+        _storage->Start();
+    }
+
+    uint16_t _port;
+    std::shared_ptr<Afina::Storage> _storage;
+    std::shared_ptr<Network::Server> _server;
+};
+
+// Client sends commands and closes its side at once, replies must still arrive
+void CheckHalfClose(Running &server) {
+    EXPECT_EQ("STORED\r\nVALUE k 0 3\r\nabc\r\nEND\r\n", server.Exchange("set k 0 0 3\r\nabc\r\nget k\r\n", true));
+
+    // Value larger than a single read
+    std::string value(10 * 1024, 'x');
+    std::string reply = server.Exchange("set big 0 0 10240\r\n" + value + "\r\nget big\r\n", true);
+    EXPECT_TRUE(reply == "STORED\r\nVALUE big 0 10240\r\n" + value + "\r\nEND\r\n") << reply.size() << " bytes";
+}
+
+// Replies to the commands preceding the malformed one are sent before connection is closed
+void CheckProtocolError(Running &server) {
+    EXPECT_EQ("STORED\r\nVALUE k 0 3\r\nabc\r\nEND\r\n",
+              server.Exchange("set k 0 0 3\r\nabc\r\nget k\r\nbogus\r\n", false));
+    EXPECT_EQ("END\r\n", server.Exchange("get foo\r\nbogus\r\n", false));
+}
+
+// Latency of each command is recorded once its response is sent
+void CheckLatency(Running &server) {
+    Metrics::Histogram before;
+    Metrics::CollectLatency(Metrics::kOpGet, before);
+    EXPECT_EQ("END\r\nEND\r\n", server.Exchange("get a\r\nget b\r\n", true));
+
+    Metrics::Histogram after;
+    Metrics::CollectLatency(Metrics::kOpGet, after);
+    EXPECT_EQ(before.Count() + 2, after.Count());
+}
+
+} // namespace
+
+TEST(ServerTest, STnonblockHalfClose) {
+    auto server = Running::Start<Network::STnonblock::ServerImpl>(18201);
+    CheckHalfClose(*server);
+}
+
+TEST(ServerTest, MTnonblockHalfClose) {
+    auto server = Running::Start<Network::MTnonblock::ServerImpl>(18202);
+    CheckHalfClose(*server);
+}
+
+TEST(ServerTest, STnonblockLatency) {
+    auto server = Running::Start<Network::STnonblock::ServerImpl>(18208);
+    CheckLatency(*server);
+}
+
+TEST(ServerTest, STblockProtocolError) {
+    auto server = Running::Start<Network::STblocking::ServerImpl>(18206);
+    CheckProtocolError(*server);
+}
+
+TEST(ServerTest, MTblockProtocolError) {
+    auto server = Running::Start<Network::MTblocking::ServerImpl>(18207);
+    CheckProtocolError(*server);
+}
+
+TEST(ServerTest, UringHalfClose) {
+    auto server = Running::Start<Network::Uring::ServerImpl>(18203);
+    CheckHalfClose(*server);
+}
+
+TEST(ServerTest, UringProtocolError) {
+    auto server = Running::Start<Network::Uring::ServerImpl>(18204);
+    CheckProtocolError(*server);
+}
+
+TEST(ServerTest, UringLatency) {
+    auto server = Running::Start<Network::Uring::ServerImpl>(18209);
+    CheckLatency(*server);
+}
+
+TEST(ServerTest, UringFallback) {
+    // Worker registers file table larger than the descriptor limit, so kernel refuses it and server has to
+    // work as mt_nonblock. Limit is restored once server is started, it is checked at registration only
+    struct rlimit saved;
+    ASSERT_EQ(0, getrlimit(RLIMIT_NOFILE, &saved));
+    struct rlimit low = saved;
+    low.rlim_cur = 256;
+    ASSERT_EQ(0, setrlimit(RLIMIT_NOFILE, &low));
+    std::unique_ptr<Running> server;
+    try {
+        server = Running::Start<Network::Uring::ServerImpl>(18205);
+    } catch (...) {
+        setrlimit(RLIMIT_NOFILE, &saved);
+        throw;
+    }
+    ASSERT_EQ(0, setrlimit(RLIMIT_NOFILE, &saved));
+
+    CheckHalfClose(*server);
+}
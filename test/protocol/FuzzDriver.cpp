@@ -0,0 +1,154 @@
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Fuzz target, see ParserFuzzer.cpp
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, std::size_t size);
+
+/**
+ * Standalone driver for the libFuzzer style target, for toolchains without libFuzzer. Replays every file given,
+ * directories are replayed file by file. With -runs=N it then makes N random mutations of the replayed inputs,
+ * -seed=N makes the run reproducible. Input that has crashed the target is saved to crash-input
+ */
+namespace {
+
+std::vector<std::string> corpus;
+
+// Input being run, saved by the signal handler
+const std::string *current = nullptr;
+
+void OnCrash(int signum) {
+    if (current != nullptr) {
+        int fd = open("crash-input", O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd >= 0) {
+            ssize_t written = write(fd, current->data(), current->size());
+            (void)written;
+            close(fd);
+        }
+    }
+    signal(signum, SIG_DFL);
+    raise(signum);
+}
+
+void Load(const std::string &path) {
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0) {
+        std::fprintf(stderr, "Can't open %s\n", path.c_str());
+        std::exit(1);
+    }
+
+    if (S_ISDIR(st.st_mode)) {
+        DIR *dir = opendir(path.c_str());
+        while (struct dirent *entry = readdir(dir)) {
+            if (entry->d_name[0] != '.') {
+                Load(path + "/" + entry->d_name);
+            }
+        }
+        closedir(dir);
+        return;
+    }
+
+    std::ifstream file(path, std::ios::binary);
+    corpus.emplace_back(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+void Run(const std::string &input) {
+    current = &input;
+    LLVMFuzzerTestOneInput(reinterpret_cast<const uint8_t *>(input.data()), input.size());
+    current = nullptr;
+}
+
+// Makes random change of the input: byte flips, inserts of interesting bytes, removal and duplication of the
+// ranges, splicing with another input
+std::string Mutate(std::string input, std::mt19937 &rnd) {
+    static const char interesting[] = {'\r', '\n', ' ', '-', '0', '9', '\0', '\xff'};
+    int changes = 1 + rnd() % 4;
+    for (int i = 0; i < changes; i++) {
+        std::size_t pos = input.empty() ? 0 : rnd() % (input.size() + 1);
+        std::size_t len = 1 + rnd() % 16;
+        switch (rnd() % 6) {
+        case 0:
+            if (pos < input.size()) {
+                input[pos] ^= char(1 << (rnd() % 8));
+            }
+            break;
+        case 1:
+            input.insert(pos, 1, interesting[rnd() % sizeof(interesting)]);
+            break;
+        case 2:
+            input.insert(pos, std::string(len, char('0' + rnd() % 10)));
+            break;
+        case 3:
+            if (pos < input.size()) {
+                input.erase(pos, len);
+            }
+            break;
+        case 4:
+            if (pos < input.size()) {
+                input.insert(pos, input.substr(pos, len));
+            }
+            break;
+        default: {
+            const std::string &other = corpus[rnd() % corpus.size()];
+            std::size_t from = other.empty() ? 0 : rnd() % other.size();
+            input.insert(pos, other.substr(from, len * 4));
+            break;
+        }
+        }
+    }
+    return input;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    signal(SIGABRT, OnCrash);
+    signal(SIGSEGV, OnCrash);
+
+    unsigned long runs = 0, seed = 1;
+    for (int i = 1; i < argc; i++) {
+        if (std::strncmp(argv[i], "-runs=", 6) == 0) {
+            runs = std::strtoul(argv[i] + 6, nullptr, 10);
+        } else if (std::strncmp(argv[i], "-seed=", 6) == 0) {
+            seed = std::strtoul(argv[i] + 6, nullptr, 10);
+        } else {
+            Load(argv[i]);
+        }
+    }
+
+    for (auto &input : corpus) {
+        Run(input);
+    }
+    std::printf("Replayed %zu inputs\n", corpus.size());
+
+    if (runs > 0) {
+        if (corpus.empty()) {
+            corpus.emplace_back();
+        }
+
+        // Inputs that have been tried are added back, so that mutations stack up
+        std::mt19937 rnd(seed);
+        for (unsigned long i = 0; i < runs; i++) {
+            std::string input = Mutate(corpus[rnd() % corpus.size()], rnd);
+            Run(input);
+            if (rnd() % 64 == 0 && corpus.size() < 4096) {
+                corpus.push_back(std::move(input));
+            }
+        }
+        std::printf("Done %lu runs\n", runs);
+    }
+    return 0;
+}
@@ -97,4 +97,57 @@ TEST(MemcachedParserTest, Stats) {
 
     Execute::Stats *tmp = reinterpret_cast<Execute::Stats *>(cmd.get());
     ASSERT_FALSE(tmp == nullptr);
+    ASSERT_EQ("", tmp->group());
+}
+
+TEST(MemcachedParserTest, StatsGroup) {
+    Protocol::Parser parser;
+
+    size_t consumed = 0;
+    bool cmd_avail = parser.Parse("stats items\r\nget foo\r\n", consumed);
+    ASSERT_TRUE(cmd_avail);
+    ASSERT_EQ(13, consumed);
+    ASSERT_EQ("stats", parser.Name());
+
+    size_t value_size;
+    std::unique_ptr<Execute::Command> cmd = parser.Build(value_size);
+    ASSERT_FALSE(cmd == nullptr);
+    ASSERT_EQ(0, value_size);
+
+    Execute::Stats *tmp = reinterpret_cast<Execute::Stats *>(cmd.get());
+    ASSERT_EQ("items", tmp->group());
+}
+
+// Numeric fields are decimal, negative expire time included
+TEST(MemcachedParserTest, SetNumbers) {
+    Protocol::Parser parser;
+
+    size_t consumed = 0;
+    ASSERT_TRUE(parser.Parse("set foo 4294967295 -2147483648 4294967295\r\n", consumed));
+
+    size_t value_size;
+    std::unique_ptr<Execute::Command> cmd = parser.Build(value_size);
+    ASSERT_FALSE(cmd == nullptr);
+    ASSERT_EQ(4294967295u, value_size);
+
+    Execute::Set *tmp = reinterpret_cast<Execute::Set *>(cmd.get());
+    ASSERT_EQ(4294967295u, tmp->flags());
+    ASSERT_EQ(-2147483648LL, tmp->expire());
+
+    parser.Reset();
+    ASSERT_TRUE(parser.Parse("set foo 0 3600 1\r\n", consumed));
+    cmd = parser.Build(value_size);
+    ASSERT_EQ(3600, reinterpret_cast<Execute::Set *>(cmd.get())->expire());
+}
+
+// Overflow of any numeric field is an error, even if wrapped value looks fine
+TEST(MemcachedParserTest, NumbersOverflow) {
+    const char *commands[] = {"set foo 4294967296 0 1\r\n", "set foo 10000000000 0 1\r\n",
+                              "set foo 0 2147483648 1\r\n", "set foo 0 -2147483649 1\r\n",
+                              "set foo 0 0 4294967296\r\n", "set foo 0 0 10000000000\r\n"};
+    for (auto command : commands) {
+        Protocol::Parser parser;
+        size_t consumed = 0;
+        EXPECT_THROW(parser.Parse(command, consumed), std::runtime_error) << command;
+    }
 }
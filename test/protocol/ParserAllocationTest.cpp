@@ -0,0 +1,163 @@
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <string>
+
+#include <afina/execute/Command.h>
+#include <afina/execute/Get.h>
+#include <afina/execute/Set.h>
+
+#include <protocol/Parser.h>
+
+using namespace Afina;
+
+// Heap allocations made by the test binary are counted while enabled
+static bool counting = false;
+static std::size_t allocations = 0;
+
+void *operator new(std::size_t size) {
+    if (counting) {
+        allocations++;
+    }
+    void *p = std::malloc(size == 0 ? 1 : size);
+    if (p == nullptr) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+
+namespace {
+
+class CountAllocations {
+public:
+    CountAllocations() {
+        allocations = 0;
+        counting = true;
+    }
+    ~CountAllocations() { counting = false; }
+};
+
+// Feeds command line to the parser split at the given position, returns true if command was parsed out
+bool ParseSplit(Protocol::Parser &parser, const std::string &line, std::size_t split) {
+    std::size_t parsed = 0;
+    if (parser.Parse(line.data(), split, parsed) && parsed == split) {
+        return true;
+    }
+    return parser.Parse(line.data() + split, line.size() - split, parsed);
+}
+
+} // namespace
+
+// Once parser has seen the command, parsing it again doesn't allocate, however it is split between reads
+TEST(ParserAllocationTest, GetDoesNotAllocate) {
+    const std::string line = "get key some_key_which_does_not_fit_into_small_string x\r\n";
+    Protocol::Parser parser(Protocol::Parser::Mode::kView);
+    ASSERT_TRUE(ParseSplit(parser, line, line.size() / 2));
+    parser.Reset();
+
+    std::size_t failed = 0;
+    {
+        CountAllocations scope;
+        for (std::size_t split = 1; split <= line.size(); split++) {
+            if (!ParseSplit(parser, line, split) || parser.KeysCount() != 3) {
+                failed++;
+            }
+            parser.Reset();
+        }
+    }
+    ASSERT_EQ(0, failed);
+    EXPECT_EQ(0, allocations);
+}
+
+// Keys refer either to the input or to the copy of the split command line
+TEST(ParserAllocationTest, SplitGetKeys) {
+    const std::string line = "get ke key2 super_long_key_which_does_not_fit\r\n";
+    Protocol::Parser parser(Protocol::Parser::Mode::kView);
+
+    for (std::size_t split = 1; split <= line.size(); split++) {
+        ASSERT_TRUE(ParseSplit(parser, line, split));
+        ASSERT_EQ(3, parser.KeysCount());
+
+        const Execute::KeyView *keys = parser.Keys();
+        EXPECT_EQ("ke", std::string(keys[0].data, keys[0].size));
+        EXPECT_EQ("key2", std::string(keys[1].data, keys[1].size));
+        EXPECT_EQ("super_long_key_which_does_not_fit", std::string(keys[2].data, keys[2].size));
+
+        // Keys of the command that came in one piece are not copied
+        bool in_input = keys[0].data >= line.data() && keys[0].data < line.data() + line.size();
+        EXPECT_EQ(split == line.size(), in_input);
+        parser.Reset();
+    }
+}
+
+// In view mode get command is the only allocation made by Build
+TEST(ParserAllocationTest, BuildGetView) {
+    const std::string line = "get foo super_long_key_which_does_not_fit\r\n";
+    Protocol::Parser parser(Protocol::Parser::Mode::kView);
+
+    std::size_t parsed = 0;
+    ASSERT_TRUE(parser.Parse(line, parsed));
+
+    std::size_t body_size = 0;
+    std::unique_ptr<Execute::Command> cmd;
+    {
+        CountAllocations scope;
+        cmd = parser.Build(body_size);
+    }
+    EXPECT_EQ(1, allocations);
+    ASSERT_FALSE(cmd == nullptr);
+    EXPECT_EQ(0, body_size);
+
+    Execute::Get *get = reinterpret_cast<Execute::Get *>(cmd.get());
+    std::vector<std::string> keys = get->keys();
+    ASSERT_EQ(2, keys.size());
+    EXPECT_EQ("foo", keys[0]);
+    EXPECT_EQ("super_long_key_which_does_not_fit", keys[1]);
+}
+
+// Commands built in place are reused, so once every type has been seen there are no allocations at all
+TEST(ParserAllocationTest, BuildInPlaceDoesNotAllocate) {
+    const std::string set = "set some_key_which_does_not_fit_into_small_string 1 0 3\r\n";
+    const std::string get = "get foo some_key_which_does_not_fit_into_small_string\r\n";
+    Protocol::Parser parser(Protocol::Parser::Mode::kView);
+
+    std::size_t parsed = 0, body_size = 0;
+    for (auto line : {set, get}) {
+        ASSERT_TRUE(parser.Parse(line, parsed));
+        ASSERT_FALSE(parser.BuildInPlace(body_size) == nullptr);
+        parser.Reset();
+    }
+
+    Execute::Command *set_cmd = nullptr, *get_cmd = nullptr;
+    std::size_t failed = 0;
+    {
+        CountAllocations scope;
+        for (int i = 0; i < 100; i++) {
+            parser.Reset();
+            if (!parser.Parse(set, parsed) || (set_cmd = parser.BuildInPlace(body_size)) == nullptr || body_size != 3) {
+                failed++;
+            }
+
+            parser.Reset();
+            if (!parser.Parse(get, parsed) || (get_cmd = parser.BuildInPlace(body_size)) == nullptr) {
+                failed++;
+            }
+        }
+    }
+    ASSERT_EQ(0, failed);
+    EXPECT_EQ(0, allocations);
+
+    Execute::Set *tmp = reinterpret_cast<Execute::Set *>(set_cmd);
+    EXPECT_EQ("some_key_which_does_not_fit_into_small_string", tmp->key());
+    EXPECT_EQ(1, tmp->flags());
+
+    std::vector<std::string> keys = reinterpret_cast<Execute::Get *>(get_cmd)->keys();
+    ASSERT_EQ(2, keys.size());
+    EXPECT_EQ("foo", keys[0]);
+    EXPECT_EQ("some_key_which_does_not_fit_into_small_string", keys[1]);
+}
@@ -0,0 +1,107 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <afina/execute/Command.h>
+
+#include <protocol/Parser.h>
+
+using namespace Afina;
+
+namespace {
+
+// Fuzzer input is the stream of bytes client sends, first byte selects how it is split between reads
+const std::size_t kMaxInput = 64 * 1024;
+
+// Appends parsed command to the trace
+void Record(const Protocol::Parser &parser, std::size_t body_size, std::string &trace) {
+    trace += parser.Name();
+    for (std::size_t i = 0; i < parser.KeysCount(); i++) {
+        trace += ' ';
+        trace.append(parser.Keys()[i].data, parser.Keys()[i].size);
+    }
+    trace += ' ';
+    trace += std::to_string(body_size);
+    trace += '\n';
+}
+
+// Feeds stream to the parser in chunks of the given size the same way server does: each command is built, then
+// its body skipped. Returns trace of parsed commands ended by error if parser has thrown one
+std::string Trace(const uint8_t *data, std::size_t size, std::size_t chunk, Protocol::Parser::Mode mode) {
+    Protocol::Parser parser(mode);
+    std::string trace;
+    std::size_t body = 0;
+
+    try {
+        for (std::size_t offset = 0; offset < size; offset += chunk) {
+            // Each read gets its own memory, so that sanitizers see keys referring to the previous one
+            std::size_t n = std::min(chunk, size - offset);
+            std::unique_ptr<char[]> input(new char[n]);
+            std::copy(data + offset, data + offset + n, input.get());
+
+            const char *p = input.get();
+            while (n > 0) {
+                if (body > 0) {
+                    std::size_t skip = std::min(body, n);
+                    body -= skip;
+                    p += skip;
+                    n -= skip;
+                    continue;
+                }
+
+                std::size_t parsed = 0;
+                bool complete = parser.Parse(p, n, parsed);
+                if (parsed > n || (!complete && parsed != n)) {
+                    std::abort();
+                }
+                p += parsed;
+                n -= parsed;
+                if (!complete) {
+                    continue;
+                }
+
+                std::size_t body_size = 0;
+                if (mode == Protocol::Parser::Mode::kView) {
+                    if (parser.BuildInPlace(body_size) == nullptr) {
+                        std::abort();
+                    }
+                } else if (parser.Build(body_size) == nullptr) {
+                    std::abort();
+                }
+                Record(parser, body_size, trace);
+
+                body = (body_size > 0) ? body_size + 2 : 0;
+                parser.Reset();
+            }
+        }
+    } catch (std::runtime_error &ex) {
+        trace += "error\n";
+    }
+    return trace;
+}
+
+} // namespace
+
+// Parser must see the same commands however stream is split and whatever mode it works in
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, std::size_t size) {
+    if (size < 1 || size > kMaxInput) {
+        return 0;
+    }
+    std::size_t chunk = 1 + data[0] % 16;
+    data++;
+    size--;
+
+    std::string whole = Trace(data, size, std::max<std::size_t>(size, 1), Protocol::Parser::Mode::kView);
+    if (Trace(data, size, chunk, Protocol::Parser::Mode::kView) != whole) {
+        std::abort();
+    }
+    if (Trace(data, size, chunk, Protocol::Parser::Mode::kCopy) != whole) {
+        std::abort();
+    }
+    return 0;
+}
@@ -0,0 +1,140 @@
+#include "gtest/gtest.h"
+#include <string>
+
+#include "ItemSize.h"
+#include "storage/ARC.h"
+
+using namespace Afina::Backend;
+
+namespace {
+
+// Gets the key as a cache would, putting it on miss
+bool Request(ARC &storage, const std::string &key) {
+    std::string value;
+    if (storage.Get(key, value)) {
+        return true;
+    }
+    storage.Put(key, "value");
+    return false;
+}
+
+} // namespace
+
+TEST(ARCTest, PutGetSetDelete) {
+    ARC storage;
+    std::string value;
+
+    EXPECT_TRUE(storage.Put("KEY1", "val1"));
+    EXPECT_FALSE(storage.PutIfAbsent("KEY1", "val2"));
+    EXPECT_FALSE(storage.Set("KEY2", "val2"));
+    EXPECT_TRUE(storage.PutIfAbsent("KEY2", "val2"));
+
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_EQ(value, "val1");
+
+    EXPECT_TRUE(storage.Set("KEY1", "val3"));
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_EQ(value, "val3");
+
+    EXPECT_TRUE(storage.Delete("KEY1"));
+    EXPECT_FALSE(storage.Delete("KEY1"));
+    EXPECT_FALSE(storage.Get("KEY1", value));
+    EXPECT_TRUE(storage.Delete("KEY2"));
+
+    Afina::Storage::Usage usage;
+    storage.GetUsage(usage);
+    EXPECT_EQ(usage.items, 0);
+    EXPECT_EQ(usage.bytes, 0);
+}
+
+TEST(ARCTest, TooLargeItem) {
+    // Items take 1024 bytes of it, ghosts the rest
+    ARC storage(1280);
+    std::string value;
+
+    EXPECT_FALSE(storage.Put("KEY1", std::string(2048, 'x')));
+    EXPECT_TRUE(storage.Put("KEY1", "val1"));
+
+    // Replacement that fits by size but not with the overhead removes the item, as in SimpleLRU
+    EXPECT_FALSE(storage.Set("KEY1", std::string(1000, 'x')));
+    EXPECT_FALSE(storage.Get("KEY1", value));
+}
+
+TEST(ARCTest, ScanKeepsFrequentKeys) {
+    ARC storage(125 * item_size<ARC>("key000", "value"));
+
+    // Keys requested twice are in T2, while the scan goes through T1 as long as B1 gets no hits
+    for (int i = 0; i < 50; i++) {
+        Request(storage, "key" + std::to_string(100 + i));
+        Request(storage, "key" + std::to_string(100 + i));
+    }
+    for (int i = 0; i < 1000; i++) {
+        Request(storage, "scan" + std::to_string(1000 + i));
+    }
+
+    int kept = 0;
+    for (int i = 0; i < 50; i++) {
+        kept += Request(storage, "key" + std::to_string(100 + i));
+    }
+    EXPECT_EQ(kept, 50);
+}
+
+TEST(ARCTest, AdaptsToRecency) {
+    ARC storage(125 * item_size<ARC>("key000", "value"));
+
+    for (int i = 0; i < 60; i++) {
+        Request(storage, "key" + std::to_string(100 + i));
+        Request(storage, "key" + std::to_string(100 + i));
+    }
+
+    // Loop of keys doesn't fit next to the frequent keys, which are never requested again. Hits of B1 grow T1
+    // until the loop fits
+    int hits = 0;
+    for (int loop = 0; loop < 20; loop++) {
+        hits = 0;
+        for (int i = 0; i < 40; i++) {
+            hits += Request(storage, "loop" + std::to_string(100 + i));
+        }
+    }
+    EXPECT_EQ(hits, 40);
+
+    Afina::Storage::Usage usage;
+    storage.GetUsage(usage);
+    EXPECT_LE(usage.bytes, usage.limit);
+}
+
+TEST(ARCTest, GhostsFitIntoMaxSize) {
+    const size_t size = item_size<ARC>("key000", "value");
+    ARC storage(125 * size);
+
+    // Keys requested twice are evicted from T2 to B2. There is no ghosts of T1 when it takes all the memory
+    for (int i = 0; i < 1000; i++) {
+        Request(storage, "key" + std::to_string(1000 + i));
+        Request(storage, "key" + std::to_string(1000 + i));
+    }
+
+    // Ghosts don't push items out, they have their own part of the memory
+    Afina::Storage::Usage usage;
+    storage.GetUsage(usage);
+    EXPECT_EQ(usage.items, 100);
+    EXPECT_GT(usage.bytes, usage.items * size);
+    EXPECT_LE(usage.bytes, usage.limit);
+    EXPECT_EQ(usage.limit, 125 * size);
+    EXPECT_GE(usage.evictions, 1000 - usage.items);
+}
+
+TEST(ARCTest, GhostShareIsBounded) {
+    const size_t size = item_size<ARC>("key000", "value");
+    ARC storage(90 * size, 0.125);
+
+    for (int i = 0; i < 1000; i++) {
+        Request(storage, "key" + std::to_string(1000 + i));
+        Request(storage, "key" + std::to_string(1000 + i));
+    }
+
+    Afina::Storage::Usage usage;
+    storage.GetUsage(usage);
+    EXPECT_EQ(usage.items, 80);
+    EXPECT_GT(usage.bytes, usage.items * size);
+    EXPECT_LE(usage.bytes, 90 * size);
+}
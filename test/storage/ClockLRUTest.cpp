@@ -0,0 +1,157 @@
+#include "gtest/gtest.h"
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "storage/ClockLRU.h"
+
+using namespace Afina::Backend;
+
+namespace {
+
+std::string Key(int i) { return "key" + std::to_string(100000 + i); }
+
+} // namespace
+
+TEST(ClockLRUTest, PutGetSetDelete) {
+    ClockLRU storage;
+    std::string value;
+
+    EXPECT_TRUE(storage.Put("KEY1", "val1"));
+    EXPECT_FALSE(storage.PutIfAbsent("KEY1", "val2"));
+    EXPECT_FALSE(storage.Set("KEY2", "val2"));
+    EXPECT_TRUE(storage.PutIfAbsent("KEY2", "val2"));
+
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_EQ(value, "val1");
+
+    EXPECT_TRUE(storage.Set("KEY1", "val3"));
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_EQ(value, "val3");
+
+    EXPECT_TRUE(storage.Delete("KEY1"));
+    EXPECT_FALSE(storage.Delete("KEY1"));
+    EXPECT_FALSE(storage.Get("KEY1", value));
+    EXPECT_TRUE(storage.Delete("KEY2"));
+
+    // Buckets and slots stay, entries are all freed
+    Afina::Storage::Usage usage;
+    storage.GetUsage(usage);
+    EXPECT_EQ(usage.items, 0);
+    EXPECT_EQ(usage.bytes, usage.overhead);
+}
+
+TEST(ClockLRUTest, TooLargeItem) {
+    ClockLRU storage(1024);
+    std::string value;
+
+    EXPECT_FALSE(storage.Put("KEY1", std::string(2048, 'x')));
+    EXPECT_TRUE(storage.Put("KEY1", "val1"));
+
+    // Replacement that fits by size but not with the overhead removes the item, as in SimpleLRU
+    EXPECT_FALSE(storage.Set("KEY1", std::string(1000, 'x')));
+    EXPECT_FALSE(storage.Get("KEY1", value));
+}
+
+TEST(ClockLRUTest, SecondChance) {
+    ClockLRU storage(64 * 1024);
+    std::string value;
+
+    // Fill the storage up to the first eviction
+    int keys = 0;
+    Afina::Storage::Usage usage;
+    do {
+        ASSERT_TRUE(storage.Put(Key(keys++), "value"));
+        storage.GetUsage(usage);
+    } while (usage.evictions == 0);
+
+    // Keys requested since are passed by the hand while the others go
+    std::vector<int> hot;
+    for (int i = 0; i < keys; i += 2) {
+        if (storage.Get(Key(i), value)) {
+            hot.push_back(i);
+        }
+    }
+    ASSERT_GT(hot.size(), 100);
+    for (std::size_t i = 0; i < hot.size(); i++) {
+        ASSERT_TRUE(storage.Put(Key(keys + i), "value"));
+    }
+
+    for (int i : hot) {
+        EXPECT_TRUE(storage.Get(Key(i), value)) << Key(i);
+    }
+}
+
+TEST(ClockLRUTest, MemoryLimit) {
+    const std::size_t limit = 64 * 1024;
+    ClockLRU storage(limit);
+
+    for (int i = 0; i < 10000; i++) {
+        ASSERT_TRUE(storage.Put(Key(i), std::string(i % 200, 'x')));
+        if (i % 3 == 0) {
+            storage.Set(Key(i / 2), std::string(i % 50, 'y'));
+        }
+    }
+
+    Afina::Storage::Usage usage;
+    storage.GetUsage(usage);
+    EXPECT_LE(usage.bytes, limit);
+    EXPECT_GT(usage.bytes, limit * 3 / 4);
+    EXPECT_GT(usage.evictions, 0);
+}
+
+TEST(ClockLRUTest, ConcurrentReadersAndWriters) {
+    const int keys = 2000;
+    ClockLRU storage(128 * 1024);
+    std::atomic<bool> stop(false);
+    std::atomic<int> broken(0);
+
+    // Values always start with their key, so reader seeing entry half built or freed would notice
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 4; t++) {
+        readers.emplace_back([&, t] {
+            std::string value;
+            for (int i = t; !stop.load(); i = (i + 7) % keys) {
+                if (storage.Get(Key(i), value) && value.compare(0, Key(i).size(), Key(i)) != 0) {
+                    broken++;
+                }
+            }
+        });
+    }
+
+    std::vector<std::thread> writers;
+    for (int t = 0; t < 2; t++) {
+        writers.emplace_back([&, t] {
+            for (int i = 0; i < 50000; i++) {
+                int key = (i * 13 + t) % keys;
+                std::string value = Key(key) + std::string(i % 100, 'v');
+                switch (i % 4) {
+                case 0:
+                    storage.Delete(Key(key));
+                    break;
+                case 1:
+                    storage.Set(Key(key), value);
+                    break;
+                default:
+                    storage.Put(Key(key), value);
+                }
+            }
+        });
+    }
+
+    for (auto &writer : writers) {
+        writer.join();
+    }
+    stop = true;
+    for (auto &reader : readers) {
+        reader.join();
+    }
+    EXPECT_EQ(broken.load(), 0);
+
+    // No reader is left, so nothing waits to be freed after the next write
+    storage.Put(Key(0), Key(0));
+    Afina::Storage::Usage usage;
+    storage.GetUsage(usage);
+    EXPECT_LE(usage.bytes, usage.limit);
+}
@@ -0,0 +1,59 @@
+#include "gtest/gtest.h"
+#include <string>
+
+#include "storage/FrequencySketch.h"
+
+using namespace Afina::Backend;
+
+TEST(FrequencySketchTest, FirstAccessGoesToDoorkeeper) {
+    FrequencySketch sketch(1024);
+    EXPECT_EQ(sketch.Estimate("key"), 0);
+
+    sketch.Record("key");
+    EXPECT_EQ(sketch.Estimate("key"), 1);
+
+    sketch.Record("key");
+    sketch.Record("key");
+    EXPECT_EQ(sketch.Estimate("key"), 3);
+    EXPECT_EQ(sketch.Estimate("other"), 0);
+}
+
+TEST(FrequencySketchTest, CountersSaturate) {
+    FrequencySketch sketch(1024);
+    for (int i = 0; i < 100; i++) {
+        sketch.Record("key");
+    }
+    EXPECT_EQ(sketch.Estimate("key"), 16);
+}
+
+TEST(FrequencySketchTest, TellsHotKeysFromCold) {
+    FrequencySketch sketch(8192);
+    for (int i = 0; i < 5000; i++) {
+        sketch.Record("hot" + std::to_string(i % 10));
+        sketch.Record("cold" + std::to_string(i));
+    }
+
+    for (int i = 0; i < 10; i++) {
+        EXPECT_GE(sketch.Estimate("hot" + std::to_string(i)), 8);
+    }
+    int overestimated = 0;
+    for (int i = 4000; i < 5000; i++) {
+        overestimated += sketch.Estimate("cold" + std::to_string(i)) > 2;
+    }
+    EXPECT_LT(overestimated, 50);
+}
+
+TEST(FrequencySketchTest, AgingHalvesCounters) {
+    FrequencySketch sketch(16);
+    for (int i = 0; i < 11; i++) {
+        sketch.Record("key");
+    }
+    EXPECT_EQ(sketch.Estimate("key"), 11);
+
+    // Sample limit is ten times the width, recording up to it halves the counters and clears doorkeeper
+    for (int i = 11; i < 160; i++) {
+        sketch.Record("other" + std::to_string(i % 2));
+    }
+    EXPECT_EQ(sketch.Estimate("key"), 5);
+    EXPECT_EQ(sketch.Bytes(), 4 * 16 / 2 + 8);
+}
@@ -0,0 +1,20 @@
+#ifndef AFINA_TEST_STORAGE_ITEM_SIZE_H
+#define AFINA_TEST_STORAGE_ITEM_SIZE_H
+
+#include <string>
+
+#include <afina/Storage.h>
+
+/**
+ * Bytes storage of the given type takes for the item, overhead included
+ */
+template <typename S> size_t item_size(const std::string &key, const std::string &value) {
+    S storage(1024 * 1024);
+    storage.Put(key, value);
+
+    Afina::Storage::Usage usage;
+    storage.GetUsage(usage);
+    return usage.bytes;
+}
+
+#endif // AFINA_TEST_STORAGE_ITEM_SIZE_H
@@ -0,0 +1,218 @@
+#include "gtest/gtest.h"
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ItemSize.h"
+#include "storage/SegmentedLRU.h"
+#include "storage/ThreadSafe.h"
+
+using namespace Afina::Backend;
+
+TEST(SegmentedLRUTest, PutGetSetDelete) {
+    SegmentedLRU storage;
+    std::string value;
+
+    EXPECT_TRUE(storage.Put("KEY1", "val1"));
+    EXPECT_FALSE(storage.PutIfAbsent("KEY1", "val2"));
+    EXPECT_FALSE(storage.Set("KEY2", "val2"));
+    EXPECT_TRUE(storage.PutIfAbsent("KEY2", "val2"));
+
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_EQ(value, "val1");
+
+    EXPECT_TRUE(storage.Set("KEY1", "val3"));
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_EQ(value, "val3");
+
+    EXPECT_TRUE(storage.Delete("KEY1"));
+    EXPECT_FALSE(storage.Delete("KEY1"));
+    EXPECT_FALSE(storage.Get("KEY1", value));
+    EXPECT_TRUE(storage.Get("KEY2", value));
+    EXPECT_EQ(value, "val2");
+
+    EXPECT_TRUE(storage.Delete("KEY2"));
+    Afina::Storage::Usage usage;
+    storage.GetUsage(usage);
+    EXPECT_EQ(usage.items, 0);
+    EXPECT_EQ(usage.bytes, 0);
+}
+
+TEST(SegmentedLRUTest, ScanKeepsHotKeys) {
+    const size_t size = item_size<SegmentedLRU>("hot00", "value");
+    SegmentedLRU storage(10 * size);
+    std::string value;
+
+    // Hot keys are requested twice and get into the protected segment
+    for (int i = 0; i < 5; i++) {
+        EXPECT_TRUE(storage.Put("hot0" + std::to_string(i), "value"));
+    }
+    for (int i = 0; i < 5; i++) {
+        EXPECT_TRUE(storage.Get("hot0" + std::to_string(i), value));
+    }
+
+    // Scan of keys many times the capacity pushes out only the probation ones
+    for (int i = 0; i < 100; i++) {
+        EXPECT_TRUE(storage.Put("scan" + std::to_string(100 + i), "value"));
+    }
+    for (int i = 0; i < 5; i++) {
+        EXPECT_TRUE(storage.Get("hot0" + std::to_string(i), value));
+    }
+
+    Afina::Storage::Usage usage;
+    storage.GetUsage(usage);
+    EXPECT_EQ(usage.items, 10);
+    EXPECT_EQ(usage.evictions, 95);
+}
+
+TEST(SegmentedLRUTest, ProtectedSegmentIsBounded) {
+    const size_t size = item_size<SegmentedLRU>("key00", "value");
+    SegmentedLRU storage(10 * size, 0.5);
+    std::string value;
+
+    // All keys are requested twice, but protected segment holds only half of them and the rest go to probation
+    for (int i = 0; i < 10; i++) {
+        EXPECT_TRUE(storage.Put("key0" + std::to_string(i), "value"));
+        EXPECT_TRUE(storage.Get("key0" + std::to_string(i), value));
+    }
+
+    // New key evicts the least recent of demoted ones
+    EXPECT_TRUE(storage.Put("key10", "value"));
+    EXPECT_FALSE(storage.Get("key00", value));
+    for (int i = 1; i < 10; i++) {
+        EXPECT_TRUE(storage.Get("key0" + std::to_string(i), value));
+    }
+}
+
+TEST(SegmentedLRUTest, ProtectedSegmentIsBoundedOnUpdate) {
+    const size_t size = item_size<SegmentedLRU>("key00", "value");
+    SegmentedLRU storage(10 * size, 0.5);
+    std::string value;
+
+    // Protected segment is full, probation takes the rest
+    for (int i = 0; i < 5; i++) {
+        EXPECT_TRUE(storage.Put("key0" + std::to_string(i), "value"));
+        EXPECT_TRUE(storage.Get("key0" + std::to_string(i), value));
+    }
+    for (int i = 5; i < 10; i++) {
+        EXPECT_TRUE(storage.Put("key0" + std::to_string(i), "value"));
+    }
+
+    // Protected key grows, so the least recent protected key goes to probation and scan pushes it out
+    EXPECT_TRUE(storage.Put("key04", std::string(size / 2, 'x')));
+    for (int i = 0; i < 10; i++) {
+        EXPECT_TRUE(storage.Put("scan" + std::to_string(100 + i), "value"));
+    }
+    EXPECT_FALSE(storage.Get("key00", value));
+    for (int i = 1; i < 5; i++) {
+        EXPECT_TRUE(storage.Get("key0" + std::to_string(i), value));
+    }
+}
+
+TEST(SegmentedLRUTest, TooLargeItem) {
+    SegmentedLRU storage(1024);
+    std::string value;
+
+    EXPECT_FALSE(storage.Put("KEY1", std::string(2048, 'x')));
+    EXPECT_TRUE(storage.Put("KEY1", "val1"));
+
+    // Replacement that fits by size but not with the overhead removes the item, as in SimpleLRU
+    EXPECT_FALSE(storage.Set("KEY1", std::string(1000, 'x')));
+    EXPECT_FALSE(storage.Get("KEY1", value));
+}
+
+TEST(SegmentedLRUTest, UsageCountsOverhead) {
+    SegmentedLRU storage(1024 * 1024);
+    EXPECT_TRUE(storage.Put("KEY1", std::string(1000, 'x')));
+    EXPECT_TRUE(storage.Put("KEY2", "val2"));
+
+    Afina::Storage::Usage usage;
+    storage.GetUsage(usage);
+    EXPECT_EQ(usage.items, 2);
+    EXPECT_EQ(usage.bytes - usage.overhead, 1000 + 4 + 4 + 4);
+    EXPECT_GT(usage.overhead, 0);
+    EXPECT_LE(usage.bytes, usage.limit);
+}
+
+TEST(SegmentedLRUTest, ThreadSafe) {
+    ThreadSafe<SegmentedLRU> storage(64 * item_size<SegmentedLRU>("key0000", "value"));
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([&storage, t]() {
+            std::string value;
+            for (int i = 0; i < 10000; i++) {
+                std::string key = "key" + std::to_string(1000 + (i * 7 + t) % 128);
+                if (!storage.Get(key, value)) {
+                    storage.Put(key, "value");
+                }
+            }
+        });
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+
+    Afina::Storage::Usage usage;
+    storage.GetUsage(usage);
+    EXPECT_LE(usage.bytes, usage.limit);
+    EXPECT_LE(usage.items, 64);
+}
+
+TEST(SegmentedLRUTest, AdmissionKeepsFrequentKeys) {
+    SegmentedLRU storage(128 * item_size<SegmentedLRU>("key000", "value"), 0.8, true);
+    std::string value;
+
+    // Keys requested three times make most of the storage
+    for (int i = 0; i < 100; i++) {
+        std::string key = "key" + std::to_string(100 + i);
+        EXPECT_TRUE(storage.Put(key, "value"));
+        EXPECT_TRUE(storage.Get(key, value));
+        EXPECT_TRUE(storage.Get(key, value));
+    }
+
+    // One-off keys get into the window and the rest of probation, then lose to the ones already there
+    for (int i = 0; i < 300; i++) {
+        EXPECT_TRUE(storage.Put("once" + std::to_string(1000 + i), "value"));
+    }
+
+    // Sketch is small enough for a few keys to collide
+    int kept = 0;
+    for (int i = 0; i < 100; i++) {
+        kept += storage.Get("key" + std::to_string(100 + i), value);
+    }
+    EXPECT_GE(kept, 95);
+
+    Afina::Storage::Usage usage;
+    storage.GetUsage(usage);
+    EXPECT_LE(usage.bytes, usage.limit);
+    EXPECT_EQ(400 - usage.items, usage.evictions);
+}
+
+TEST(SegmentedLRUTest, AdmissionKeepsUpdatedKey) {
+    SegmentedLRU storage(128 * item_size<SegmentedLRU>("key000", "value"), 0.8, true);
+    std::string value;
+    EXPECT_TRUE(storage.Put("cold", "value"));
+
+    // Storage gets full of keys more frequent than the cold one, which is kept by recency
+    for (int i = 0; i < 150; i++) {
+        std::string key = "key" + std::to_string(100 + i);
+        storage.Put(key, "value");
+        for (int j = 0; j < 9; j++) {
+            storage.Get(key, value);
+        }
+        if (i % 30 == 0) {
+            ASSERT_TRUE(storage.Get("cold", value));
+        }
+    }
+
+    // Key is stored already, its larger value evicts others rather than being judged by frequency
+    std::string large(3000, 'x');
+    EXPECT_TRUE(storage.Put("cold", large));
+    EXPECT_TRUE(storage.Get("cold", value));
+    EXPECT_EQ(large, value);
+
+    Afina::Storage::Usage usage;
+    storage.GetUsage(usage);
+    EXPECT_LE(usage.bytes, usage.limit);
+}
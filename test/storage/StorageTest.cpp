@@ -10,6 +10,7 @@
 #include <afina/execute/Get.h>
 #include <afina/execute/Set.h>
 
+#include "ItemSize.h"
 #include "storage/SimpleLRU.h"
 
 using namespace Afina::Backend;
@@ -91,15 +92,112 @@ TEST(StorageTest, PutDeleteGet) {
     EXPECT_TRUE(value == "val2");
 }
 
+TEST(StorageTest, DeleteOnlyItem) {
+    SimpleLRU storage;
+
+    EXPECT_TRUE(storage.Put("KEY1", "val1"));
+    EXPECT_TRUE(storage.Delete("KEY1"));
+
+    std::string value;
+    EXPECT_FALSE(storage.Get("KEY1", value));
+
+    EXPECT_TRUE(storage.Put("KEY2", "val2"));
+    EXPECT_TRUE(storage.Put("KEY3", "val3"));
+    EXPECT_TRUE(storage.Get("KEY2", value));
+    EXPECT_TRUE(value == "val2");
+}
+
+TEST(StorageTest, UsageCountsOverhead) {
+    SimpleLRU storage(1024 * 1024);
+    const std::string big(1000, 'x');
+
+    EXPECT_TRUE(storage.Put("KEY1", big));
+    EXPECT_TRUE(storage.Put("KEY2", "val2"));
+
+    Afina::Storage::Usage usage;
+    storage.GetUsage(usage);
+    EXPECT_EQ(2, usage.items);
+    EXPECT_EQ(4 + 1000 + 4 + 4, usage.bytes - usage.overhead);
+
+    // At least list node with two strings for each item
+    EXPECT_GT(usage.overhead, 2 * (2 * sizeof(std::string) + 2 * sizeof(void *)));
+
+    // Buffer of the large value is released
+    EXPECT_TRUE(storage.Put("KEY1", "val1"));
+    Afina::Storage::Usage replaced;
+    storage.GetUsage(replaced);
+    EXPECT_LE(replaced.bytes + 1000, usage.bytes);
+
+    EXPECT_TRUE(storage.Delete("KEY1"));
+    EXPECT_TRUE(storage.Delete("KEY2"));
+    storage.GetUsage(usage);
+    EXPECT_EQ(0, usage.bytes);
+    EXPECT_EQ(0, usage.overhead);
+}
+
+TEST(StorageTest, LimitIncludesOverhead) {
+    // Keys and values alone of all items would fit
+    SimpleLRU storage(8000);
+    for (int i = 0; i < 1000; ++i) {
+        EXPECT_TRUE(storage.Put("k" + std::to_string(1000 + i), "v" + std::to_string(1000 + i)));
+    }
+
+    Afina::Storage::Usage usage;
+    storage.GetUsage(usage);
+    EXPECT_LT(usage.items, 1000);
+    EXPECT_LE(usage.bytes, 8000);
+    EXPECT_EQ(1000 - usage.items, usage.evictions);
+}
+
+TEST(StorageTest, TooLargeReplaceRemovesItem) {
+    SimpleLRU storage(1024);
+
+    EXPECT_TRUE(storage.Put("KEY1", "val1"));
+    EXPECT_FALSE(storage.Put("KEY1", std::string(1000, 'x')));
+
+    std::string value;
+    EXPECT_FALSE(storage.Get("KEY1", value));
+}
+
 std::string pad_space(const std::string &s, size_t length) {
     std::string result = s;
     result.resize(length, ' ');
     return result;
 }
 
+TEST(StorageTest, AdmissionKeepsFrequentKeys) {
+    SimpleLRU storage(128 * item_size<SimpleLRU>("key000", "value"), true);
+    std::string value;
+
+    for (int i = 0; i < 100; i++) {
+        std::string key = "key" + std::to_string(100 + i);
+        EXPECT_TRUE(storage.Put(key, "value"));
+        EXPECT_TRUE(storage.Get(key, value));
+        EXPECT_TRUE(storage.Get(key, value));
+    }
+
+    // Once storage is full, one-off keys are rejected instead of evicting the frequent ones. Rejected key counts
+    // as stored and evicted right away
+    for (int i = 0; i < 300; i++) {
+        EXPECT_TRUE(storage.Put("once" + std::to_string(1000 + i), "value"));
+    }
+
+    // Sketch is small enough for a few keys to collide
+    int kept = 0;
+    for (int i = 0; i < 100; i++) {
+        kept += storage.Get("key" + std::to_string(100 + i), value);
+    }
+    EXPECT_GE(kept, 95);
+
+    Afina::Storage::Usage usage;
+    storage.GetUsage(usage);
+    EXPECT_LE(usage.bytes, usage.limit);
+    EXPECT_EQ(400 - usage.items, usage.evictions);
+}
+
 TEST(StorageTest, BigTest) {
     const size_t length = 20;
-    SimpleLRU storage(2 * 100000 * length);
+    SimpleLRU storage(100000 * item_size<SimpleLRU>(pad_space("Key", length), pad_space("Val", length)));
 
     for (long i = 0; i < 100000; ++i) {
         auto key = pad_space("Key " + std::to_string(i), length);
@@ -120,7 +218,7 @@ TEST(StorageTest, BigTest) {
 
 TEST(StorageTest, MaxTest) {
     const size_t length = 20;
-    SimpleLRU storage(2 * 1000 * length);
+    SimpleLRU storage(1000 * item_size<SimpleLRU>(pad_space("Key", length), pad_space("Val", length)));
 
     std::stringstream ss;
 